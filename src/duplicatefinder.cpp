@@ -0,0 +1,546 @@
+/*
+ * DuplicateFinder 实现
+ */
+#include "duplicatefinder.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+#include "minimp3.h"
+#include "minimp3_ex.h"
+#include "medialibrary.h"
+#include "stft.h"
+
+namespace {
+
+constexpr quint64 kFnvOffset = 14695981039346656037ull;
+constexpr quint64 kFnvPrime = 1099511628211ull;
+
+inline quint64 fnv1a(quint64 hash, const uchar* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+struct FrameHash {
+    quint64 hash = kFnvOffset;
+    int frames = 0;
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+// mp3dec_iterate_buf 的回调：只对 MPEG 帧本身做哈希，标签已被 minimp3 跳过
+int hashFrame(void* user, const uint8_t* frame, int frameSize, int, size_t, uint64_t, mp3dec_frame_info_t*)
+{
+    FrameHash* state = static_cast<FrameHash*>(user);
+    state->hash = fnv1a(state->hash, frame, static_cast<size_t>(frameSize));
+    ++state->frames;
+    return *state->cancel ? 1 : 0;
+}
+
+// 64 个随机超平面，每维 ±1；固定种子，签名在每次运行之间一致（指纹长度固定，只在第一次调用时生成）
+const std::vector<qint8>& hyperplanes(int dimensions)
+{
+    static const std::vector<qint8> planes = [dimensions]() {
+        std::vector<qint8> result(static_cast<size_t>(64 * dimensions));
+        quint64 state = 0x5454504C41594552ull;   // splitmix64
+        for (size_t i = 0; i < result.size(); i += 64) {
+            state += 0x9E3779B97F4A7C15ull;
+            quint64 z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            for (size_t bit = 0; bit < 64 && i + bit < result.size(); ++bit) {
+                result[i + bit] = (z >> bit) & 1 ? 1 : -1;
+            }
+        }
+        return result;
+    }();
+    return planes;
+}
+
+quint64 signature(const QByteArray& fingerprint)
+{
+    const int dimensions = fingerprint.size();
+    const qint8* values = reinterpret_cast<const qint8*>(fingerprint.constData());
+    const qint8* plane = hyperplanes(dimensions).data();
+    quint64 bits = 0;
+    for (int bit = 0; bit < 64; ++bit, plane += dimensions) {
+        int dot = 0;
+        for (int i = 0; i < dimensions; ++i) {
+            dot += plane[i] * values[i];
+        }
+        if (dot >= 0) {
+            bits |= quint64(1) << bit;
+        }
+    }
+    return bits;
+}
+
+float similarity(const QByteArray& a, const QByteArray& b)
+{
+    if (a.size() != b.size() || a.isEmpty()) {
+        return 0.0f;
+    }
+    const qint8* x = reinterpret_cast<const qint8*>(a.constData());
+    const qint8* y = reinterpret_cast<const qint8*>(b.constData());
+    qint64 dot = 0;
+    qint64 xx = 0;
+    qint64 yy = 0;
+    for (int i = 0; i < a.size(); ++i) {
+        dot += x[i] * y[i];
+        xx += x[i] * x[i];
+        yy += y[i] * y[i];
+    }
+    return xx > 0 && yy > 0 ? static_cast<float>(dot / std::sqrt(static_cast<double>(xx) * static_cast<double>(yy))) : 0.0f;
+}
+
+// 不同 rip 的首尾静音长短不一：时长相差 3 秒或 3% 以内
+bool similarDuration(qint32 a, qint32 b)
+{
+    if (a <= 0 || b <= 0) {
+        return true;
+    }
+    return std::abs(a - b) <= std::max(3000, std::max(a, b) * 3 / 100);
+}
+
+} // namespace
+
+// ========== 工作任务 ==========
+
+/**
+ * @brief 一首歌的查重分析任务
+ */
+class FingerprintJob : public QRunnable
+{
+public:
+    explicit FingerprintJob(const QString& filePath)
+        : m_filePath(filePath)
+    {
+    }
+
+    void run() override
+    {
+        DuplicateFinder& finder = DuplicateFinder::instance();
+        DuplicateFinder::Result result;
+
+        QElapsedTimer timer;
+        timer.start();
+        if (!DuplicateFinder::analyze(m_filePath, finder.m_cancel, &result)) {
+            if (finder.m_cancel) {
+                return;
+            }
+        } else {
+            qDebug() << "[DuplicateFinder]" << QFileInfo(m_filePath).fileName()
+                     << (result.fingerprint.isEmpty() ? "只有内容哈希" : "已生成指纹")
+                     << ", 用时" << timer.elapsed() << "ms";
+        }
+
+        const QString filePath = m_filePath;
+        QMetaObject::invokeMethod(&finder, [filePath, result]() {
+            DuplicateFinder::instance().finishJob(filePath, result);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QString m_filePath;
+};
+
+// ========== DuplicateFinder ==========
+
+DuplicateFinder& DuplicateFinder::instance()
+{
+    static DuplicateFinder inst;
+    return inst;
+}
+
+DuplicateFinder::DuplicateFinder(QObject* parent)
+    : QObject(parent)
+{
+    // 与 TempoScanner 一样要完整解码，各用一半的核心
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+
+    // 删除前槽位仍可查询；改写后的文件要重新分析，旧的匹配先去掉
+    MediaLibrary& library = MediaLibrary::instance();
+    auto forgetPath = [this](const QString& filePath) {
+        if (forget(MediaLibrary::instance().slot(filePath))) {
+            emit duplicatesChanged();
+        }
+    };
+    connect(&library, &MediaLibrary::aboutToRemoveTrack, this, forgetPath);
+    connect(&library, &MediaLibrary::fileChanged, this, forgetPath);
+}
+
+DuplicateFinder::~DuplicateFinder()
+{
+    shutdown();
+}
+
+void DuplicateFinder::shutdown()
+{
+    m_cancel = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void DuplicateFinder::scan(const QStringList& filePaths)
+{
+    const MediaLibrary& library = MediaLibrary::instance();
+    bool changed = false;
+    for (const QString& filePath : filePaths) {
+        if (m_cancel || m_pending.contains(filePath)) {
+            continue;
+        }
+        const MediaLibrary::Track* track = library.track(filePath);
+        if (!track || track->isVirtual()) {
+            continue;
+        }
+        if (track->fingerprinted) {
+            changed |= index(library.slot(filePath));
+            continue;
+        }
+        m_pending.insert(filePath);
+        m_pool.start(new FingerprintJob(filePath), 0);
+    }
+    if (changed) {
+        emit duplicatesChanged();
+    }
+}
+
+void DuplicateFinder::finishJob(const QString& filePath, const Result& result)
+{
+    m_pending.remove(filePath);
+    if (m_cancel || !result.analyzed) {
+        return;
+    }
+
+    MediaLibrary& library = MediaLibrary::instance();
+    library.setFingerprint(filePath, result.contentHash, result.fingerprint, result.durationMs);
+    if (index(library.slot(filePath))) {
+        emit duplicatesChanged();
+    }
+}
+
+bool DuplicateFinder::index(int slot)
+{
+    if (slot < 0 || m_indexed.contains(slot)) {
+        return false;
+    }
+    const MediaLibrary& library = MediaLibrary::instance();
+    const MediaLibrary::Track& track = library.trackAt(slot);
+    if (!track.fingerprinted) {
+        return false;
+    }
+
+    Indexed entry;
+    entry.contentHash = track.contentHash;
+    entry.hasFingerprint = track.fingerprint.size() == kFingerprintSize;
+    entry.durationBucket = track.durationMs > 0 ? track.durationMs / kDurationBucketMs : -1;
+    if (entry.hasFingerprint) {
+        entry.signature = signature(track.fingerprint);
+    }
+
+    QSet<int> found;
+    if (entry.contentHash != 0) {
+        for (int other : m_byContent.value(entry.contentHash)) {
+            found.insert(other);
+        }
+    }
+    if (entry.hasFingerprint) {
+        // 同一段签名、相邻时长档的歌才是候选，每个候选只确认一次
+        QSet<int> tested = found;
+        for (int band = 0; band < kBands; ++band) {
+            const quint64 bits = (entry.signature >> (band * kBandBits)) & ((quint64(1) << kBandBits) - 1);
+            for (int bucket = entry.durationBucket - 1; bucket <= entry.durationBucket + 1; ++bucket) {
+                if (entry.durationBucket < 0 && bucket != entry.durationBucket) {
+                    continue;
+                }
+                const quint64 key = (quint64(band) << 48) | (bits << 32) | static_cast<quint32>(bucket);
+                const auto candidates = m_buckets.constFind(key);
+                if (candidates == m_buckets.constEnd()) {
+                    continue;
+                }
+                for (int other : *candidates) {
+                    if (tested.contains(other)) {
+                        continue;
+                    }
+                    tested.insert(other);
+                    const MediaLibrary::Track& candidate = library.trackAt(other);
+                    if (similarDuration(track.durationMs, candidate.durationMs)
+                        && similarity(track.fingerprint, candidate.fingerprint) >= kMatchSimilarity) {
+                        found.insert(other);
+                    }
+                }
+            }
+        }
+        for (int band = 0; band < kBands; ++band) {
+            const quint64 bits = (entry.signature >> (band * kBandBits)) & ((quint64(1) << kBandBits) - 1);
+            const quint64 key = (quint64(band) << 48) | (bits << 32) | static_cast<quint32>(entry.durationBucket);
+            m_buckets[key].push_back(slot);
+        }
+    }
+    if (entry.contentHash != 0) {
+        m_byContent[entry.contentHash].push_back(slot);
+    }
+    m_indexed.insert(slot, entry);
+
+    for (int other : found) {
+        m_matches[slot].insert(other);
+        m_matches[other].insert(slot);
+    }
+    return !found.isEmpty();
+}
+
+bool DuplicateFinder::forget(int slot)
+{
+    const auto it = m_indexed.constFind(slot);
+    if (it == m_indexed.constEnd()) {
+        return false;
+    }
+    const Indexed entry = *it;
+    m_indexed.erase(it);
+
+    auto erase = [slot](QHash<quint64, std::vector<int>>& table, quint64 key) {
+        auto bucket = table.find(key);
+        if (bucket == table.end()) {
+            return;
+        }
+        bucket->erase(std::remove(bucket->begin(), bucket->end(), slot), bucket->end());
+        if (bucket->empty()) {
+            table.erase(bucket);
+        }
+    };
+    if (entry.contentHash != 0) {
+        erase(m_byContent, entry.contentHash);
+    }
+    if (entry.hasFingerprint) {
+        for (int band = 0; band < kBands; ++band) {
+            const quint64 bits = (entry.signature >> (band * kBandBits)) & ((quint64(1) << kBandBits) - 1);
+            erase(m_buckets, (quint64(band) << 48) | (bits << 32) | static_cast<quint32>(entry.durationBucket));
+        }
+    }
+
+    const QSet<int> matched = m_matches.take(slot);
+    for (int other : matched) {
+        auto edges = m_matches.find(other);
+        if (edges != m_matches.end()) {
+            edges->remove(slot);
+            if (edges->isEmpty()) {
+                m_matches.erase(edges);
+            }
+        }
+    }
+    return !matched.isEmpty();
+}
+
+std::vector<QStringList> DuplicateFinder::groups() const
+{
+    // 槽位按加入顺序递增：从小到大出发做广度优先，组的顺序即第一首歌的顺序
+    std::vector<int> starts;
+    starts.reserve(static_cast<size_t>(m_matches.size()));
+    for (auto it = m_matches.constBegin(); it != m_matches.constEnd(); ++it) {
+        starts.push_back(it.key());
+    }
+    std::sort(starts.begin(), starts.end());
+
+    const MediaLibrary& library = MediaLibrary::instance();
+    std::vector<QStringList> result;
+    QSet<int> visited;
+    for (int start : starts) {
+        if (visited.contains(start)) {
+            continue;
+        }
+        std::vector<int> group{start};
+        visited.insert(start);
+        for (size_t i = 0; i < group.size(); ++i) {
+            for (int other : m_matches.value(group[i])) {
+                if (!visited.contains(other)) {
+                    visited.insert(other);
+                    group.push_back(other);
+                }
+            }
+        }
+        std::sort(group.begin(), group.end());
+        QStringList paths;
+        for (int slot : group) {
+            paths.append(library.trackAt(slot).path);
+        }
+        result.push_back(paths);
+    }
+    return result;
+}
+
+/**
+ * @brief 计算内容哈希并解码生成色度指纹（工作线程）
+ *
+ * 文件以内存映射方式读取；色度只保留每个分析帧 12 个浮点数（4 分钟约 120 KB）。
+ */
+bool DuplicateFinder::analyze(const QString& filePath, const std::atomic<bool>& cancel, Result* result)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        qWarning() << "[DuplicateFinder] 无法打开:" << filePath;
+        return false;
+    }
+    const uchar* data = file.map(0, file.size());
+    if (!data) {
+        qWarning() << "[DuplicateFinder] 内存映射失败:" << filePath;
+        return false;
+    }
+    const size_t size = static_cast<size_t>(file.size());
+    result->analyzed = true;
+
+    // 内容哈希：MPEG 帧（不含标签）；不是 MP3 时退回到整个文件
+    FrameHash frames;
+    frames.cancel = &cancel;
+    mp3dec_iterate_buf(data, size, hashFrame, &frames);
+    if (cancel) {
+        return false;
+    }
+    if (frames.frames == 0) {
+        result->contentHash = fnv1a(kFnvOffset, data, size);
+        return true;
+    }
+    result->contentHash = frames.hash != 0 ? frames.hash : 1;
+
+    auto decoder = std::make_unique<mp3dec_ex_t>();
+    if (mp3dec_ex_open_buf(decoder.get(), data, size, MP3D_SEEK_TO_SAMPLE | MP3D_DO_NOT_SCAN) != 0) {
+        return true;
+    }
+
+    StftAnalyzer stft(kFftSize, kHopSize, StftAnalyzer::Mono);
+    std::vector<int> pitchClass;                        // bin → 半音（0 = C），范围外为 -1
+    std::vector<std::array<float, kChromaBins>> chroma;
+    std::vector<float> energy;
+    int sampleRate = 0;
+    qint64 frameCount = 0;
+
+    mp3d_sample_t* pcm = nullptr;
+    mp3dec_frame_info_t info;
+    size_t samples;
+    while ((samples = mp3dec_ex_read_frame(decoder.get(), &pcm, &info, MINIMP3_MAX_SAMPLES_PER_FRAME)) > 0) {
+        if (cancel) {
+            mp3dec_ex_close(decoder.get());
+            return false;
+        }
+        const int channels = std::max(1, info.channels);
+        if (sampleRate == 0) {
+            sampleRate = info.hz;
+            // 只取 100Hz 到 5kHz：更低的 bin 跨好几个半音，更高的多是泛音和噪声
+            pitchClass.assign(static_cast<size_t>(stft.binCount()), -1);
+            for (int bin = 1; bin < stft.binCount(); ++bin) {
+                const double frequency = static_cast<double>(bin) * sampleRate / stft.fftSize();
+                if (frequency >= 100.0 && frequency <= 5000.0) {
+                    const long midi = std::lround(69.0 + 12.0 * std::log2(frequency / 440.0));
+                    pitchClass[static_cast<size_t>(bin)] = static_cast<int>(midi % kChromaBins);
+                }
+            }
+            chroma.reserve(static_cast<size_t>(sampleRate / kHopSize * 300));
+            energy.reserve(chroma.capacity());
+        }
+
+        const int count = static_cast<int>(samples) / channels;
+        stft.push(pcm, count, channels, [&](const SpectrumFrame& frame) {
+            std::array<float, kChromaBins> bins{};
+            float total = 0.0f;
+            const float* magnitude = frame.planes[0];
+            for (int bin = 0; bin < frame.binCount; ++bin) {
+                total += magnitude[bin];
+                const int pitch = pitchClass[static_cast<size_t>(bin)];
+                if (pitch >= 0) {
+                    bins[static_cast<size_t>(pitch)] += magnitude[bin];
+                }
+            }
+            chroma.push_back(bins);
+            energy.push_back(total);
+        });
+        frameCount += count;
+    }
+    mp3dec_ex_close(decoder.get());
+
+    if (sampleRate <= 0) {
+        return true;
+    }
+    result->durationMs = static_cast<qint32>(frameCount * 1000 / sampleRate);
+
+    // 去掉首尾静音：能量低于平均值 10% 的帧
+    const int total = static_cast<int>(chroma.size());
+    if (total < kSegments) {
+        return true;
+    }
+    double mean = 0.0;
+    for (float e : energy) {
+        mean += e;
+    }
+    const float threshold = static_cast<float>(mean / total * 0.1);
+    int first = 0;
+    int last = total - 1;
+    while (first < last && energy[static_cast<size_t>(first)] < threshold) {
+        ++first;
+    }
+    while (last > first && energy[static_cast<size_t>(last)] < threshold) {
+        --last;
+    }
+    if (last - first + 1 < kSegments) {
+        first = 0;
+        last = total - 1;
+    }
+
+    // 平均为 kSegments 段，每段归一化为色度分布，再减去全曲的平均分布
+    std::vector<float> vector(static_cast<size_t>(kFingerprintSize), 0.0f);
+    const int length = last - first + 1;
+    for (int segment = 0; segment < kSegments; ++segment) {
+        const int begin = first + segment * length / kSegments;
+        const int end = first + (segment + 1) * length / kSegments;
+        float* out = vector.data() + segment * kChromaBins;
+        float sum = 0.0f;
+        for (int i = begin; i < end; ++i) {
+            for (int pitch = 0; pitch < kChromaBins; ++pitch) {
+                out[pitch] += chroma[static_cast<size_t>(i)][static_cast<size_t>(pitch)];
+            }
+        }
+        for (int pitch = 0; pitch < kChromaBins; ++pitch) {
+            sum += out[pitch];
+        }
+        if (sum > 0.0f) {
+            for (int pitch = 0; pitch < kChromaBins; ++pitch) {
+                out[pitch] /= sum;
+            }
+        }
+    }
+    for (int pitch = 0; pitch < kChromaBins; ++pitch) {
+        float average = 0.0f;
+        for (int segment = 0; segment < kSegments; ++segment) {
+            average += vector[static_cast<size_t>(segment * kChromaBins + pitch)];
+        }
+        average /= kSegments;
+        for (int segment = 0; segment < kSegments; ++segment) {
+            vector[static_cast<size_t>(segment * kChromaBins + pitch)] -= average;
+        }
+    }
+
+    // 余弦相似度与缩放无关：按最大绝对值量化到 int8
+    float peak = 0.0f;
+    for (float value : vector) {
+        peak = std::max(peak, std::fabs(value));
+    }
+    if (peak < 1e-4f) {
+        return true;   // 色度几乎不随时间变化（噪声、纯音），指纹没有区分度
+    }
+    result->fingerprint.resize(kFingerprintSize);
+    qint8* out = reinterpret_cast<qint8*>(result->fingerprint.data());
+    for (int i = 0; i < kFingerprintSize; ++i) {
+        out[i] = static_cast<qint8>(std::lround(vector[static_cast<size_t>(i)] / peak * 127.0f));
+    }
+    return true;
+}
@@ -0,0 +1,116 @@
+/*
+ * DuplicateFinder - 媒体库查重：同一首歌的多个版本（不同来源的 rip、改过标签的副本）
+ *
+ * 每首歌在后台线程池中分析一次，结果（内容哈希 + 色度指纹）写入 MediaLibrary 的歌曲记录：
+ *   - 内容哈希：MP3 只对 MPEG 帧做 64 位 FNV-1a，跳过 ID3v2 / ID3v1 / APE 标签，
+ *     只改了标签的副本哈希相同；其他格式无法解码，对整个文件做哈希（只能找出完全相同的文件）
+ *   - 色度指纹：完整解码一遍，STFT 幅度谱按音高折叠为 12 个半音，去掉首尾静音后平均为
+ *     kSegments 段，减去整首的平均色度（只保留和声随时间的变化）后量化为 int8，共 384 字节；
+ *     不同码率、不同编码器的 rip 指纹相近，不同的歌接近正交
+ *
+ * 分组在 GUI 线程中增量进行，每首歌分析完只和候选比较，不做两两比较：
+ *   - 内容哈希相同的直接归为一组
+ *   - 指纹用 64 个随机 ±1 超平面做 SimHash 得到 64 位签名，按 8 段 × 8 位分桶（LSH），
+ *     桶键还带上 5 秒一档的时长，只在相邻时长档中查找；同桶的候选再用余弦相似度和时长确认
+ *   - 匹配关系记为图的边，重复组是图的连通分量；歌曲删除或文件被改写时去掉它的边
+ * CUE 分轨（镜像中的一段）不参与查重。
+ *
+ * 使用方式:
+ *   DuplicateFinder::instance().scan(playlist);
+ *   connect(&DuplicateFinder::instance(), &DuplicateFinder::duplicatesChanged, ...);
+ *   std::vector<QStringList> groups = DuplicateFinder::instance().groups();
+ */
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <atomic>
+#include <vector>
+
+class DuplicateFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DuplicateFinder& instance();
+
+    /**
+     * @brief 为尚未分析的歌曲排队分析（低优先级），已分析过的直接加入索引
+     */
+    void scan(const QStringList& filePaths);
+
+    /**
+     * @brief 当前的重复组：每组至少两首，组内和组间都按加入媒体库的顺序排列
+     */
+    std::vector<QStringList> groups() const;
+
+    /**
+     * @brief 取消排队中的任务并等待正在运行的任务退出（程序退出前调用）
+     */
+    void shutdown();
+
+signals:
+    void duplicatesChanged();
+
+private:
+    friend class FingerprintJob;
+
+    struct Result {
+        bool analyzed = false;      // 文件能打开（否则不记录，下次启动重试）
+        quint64 contentHash = 0;
+        QByteArray fingerprint;     // 空表示无法解码或太短
+        qint32 durationMs = 0;
+    };
+
+    // 已加入索引的歌曲
+    struct Indexed {
+        quint64 contentHash = 0;
+        quint64 signature = 0;
+        int durationBucket = -1;
+        bool hasFingerprint = false;
+    };
+
+    DuplicateFinder(QObject* parent = nullptr);
+    ~DuplicateFinder();
+    DuplicateFinder(const DuplicateFinder&) = delete;
+    DuplicateFinder& operator=(const DuplicateFinder&) = delete;
+
+    // 在 GUI 线程中接收任务结果
+    void finishJob(const QString& filePath, const Result& result);
+
+    // 把库中一首已分析的歌加入索引并与候选比较；返回是否找到了重复
+    bool index(int slot);
+    // 从索引中去掉一首歌和它的匹配关系；返回是否去掉了匹配
+    bool forget(int slot);
+
+    // 在工作线程中运行；文件无法打开时返回 false（不记录结果，下次启动重试）
+    static bool analyze(const QString& filePath, const std::atomic<bool>& cancel, Result* result);
+
+    static constexpr int kChromaBins = 12;
+    static constexpr int kSegments = 32;
+    static constexpr int kFingerprintSize = kSegments * kChromaBins;
+    static constexpr int kFftSize = 4096;       // 44.1kHz 下每个 bin 约 10.8Hz，约 180Hz 以上相邻半音落在不同的 bin
+    static constexpr int kHopSize = 4096;       // 不重叠：只需要平均色度，约 11 帧/秒
+    static constexpr int kBands = 8;            // LSH：64 位签名分 8 段，每段 8 位
+    static constexpr int kBandBits = 8;
+    static constexpr qint32 kDurationBucketMs = 5000;
+    static constexpr float kMatchSimilarity = 0.8f;
+
+    QThreadPool m_pool;
+    std::atomic<bool> m_cancel{false};
+
+    // 以下仅 GUI 线程访问
+    QSet<QString> m_pending;                            // 已排队或正在分析
+    QHash<int, Indexed> m_indexed;                      // 槽位 → 索引信息
+    QHash<quint64, std::vector<int>> m_byContent;       // 内容哈希 → 槽位
+    QHash<quint64, std::vector<int>> m_buckets;         // LSH 桶键 → 槽位
+    QHash<int, QSet<int>> m_matches;                    // 槽位 → 与之重复的槽位（图的边）
+};
+
+#endif // DUPLICATEFINDER_H
@@ -14,7 +14,7 @@
  *   fft.rforward(in, out);   // 实数正向 FFT (实数->复数，输出 N/2+1 点)
  */
 #ifndef TTPLAYER_FFT_H
-#define TTPLAYER_FTT_H
+#define TTPLAYER_FFT_H
 
 #include <vector>
 #include <complex>
@@ -177,4 +177,4 @@ inline void FFT::rforward(const std::vector<float>& in, std::vector<FftComplex>&
     }
 }
 
-#endif // TTPLAYER_FTT_H
+#endif // TTPLAYER_FFT_H
@@ -1,6 +1,7 @@
 #include "imageslider.h"
 #include <QPainter>
 #include <QPainterPath>
+#include <algorithm>
 
 ImageSlider::ImageSlider(const QPixmap &pixmap, QWidget *parent)
     : QSlider(Qt::Horizontal, parent), m_handlePixmap(pixmap), m_currentVolume(60)
@@ -9,6 +10,68 @@ ImageSlider::ImageSlider(const QPixmap &pixmap, QWidget *parent)
     setValue(0);
 }
 
+void ImageSlider::setWaveform(std::shared_ptr<const WaveformOverview> overview)
+{
+    m_waveform = std::move(overview);
+    m_waveformDirty = true;
+    update();
+}
+
+void ImageSlider::resizeEvent(QResizeEvent *event)
+{
+    QSlider::resizeEvent(event);
+    m_waveformDirty = true;
+}
+
+void ImageSlider::ensureWaveformPixmaps()
+{
+    if (!m_waveformDirty) {
+        return;
+    }
+    m_waveformDirty = false;
+    m_playedWaveform = QPixmap();
+    m_pendingWaveform = QPixmap();
+    if (!m_waveform || m_waveform->isEmpty() || width() <= 0 || height() <= 0) {
+        return;
+    }
+
+    // 波形横跨手柄中心可到达的范围
+    const int left = m_handlePixmap.width() / 2;
+    const int span = std::max(1, width() - m_handlePixmap.width());
+    const std::vector<WaveformBucket> &level = m_waveform->levelFor(span);
+    const int bucketCount = static_cast<int>(level.size());
+    const qreal centerY = height() / 2.0;
+    const qreal halfHeight = height() / 2.0;
+
+    auto render = [&](const QColor &peakColor, const QColor &rmsColor) {
+        QPixmap pixmap(size());
+        pixmap.fill(Qt::transparent);
+        QPainter p(&pixmap);
+        for (int x = 0; x < span; ++x) {
+            // 每列合并落在该列的所有桶
+            const int begin = static_cast<int>(static_cast<qint64>(x) * bucketCount / span);
+            const int end = std::max(begin + 1, static_cast<int>(static_cast<qint64>(x + 1) * bucketCount / span));
+            int minValue = 0;
+            int maxValue = 0;
+            int rmsValue = 0;
+            for (int i = begin; i < end && i < bucketCount; ++i) {
+                minValue = std::min<int>(minValue, level[i].min);
+                maxValue = std::max<int>(maxValue, level[i].max);
+                rmsValue = std::max<int>(rmsValue, level[i].rms);
+            }
+            const qreal top = centerY - maxValue / 127.0 * halfHeight;
+            const qreal bottom = centerY - minValue / 127.0 * halfHeight;
+            p.fillRect(QRectF(left + x, top, 1, std::max<qreal>(1.0, bottom - top)), peakColor);
+            const qreal rms = rmsValue / 255.0 * halfHeight;
+            p.fillRect(QRectF(left + x, centerY - rms, 1, std::max<qreal>(1.0, 2 * rms)), rmsColor);
+        }
+        return pixmap;
+    };
+
+    m_playedWaveform = render(QColor(255, 255, 255, 110), QColor(255, 255, 255, 170));
+    m_pendingWaveform = render(QColor(255, 255, 255, 45), QColor(255, 255, 255, 80));
+}
+
 void ImageSlider::paintEvent(QPaintEvent *event)
 {
     // Don't call parent's paintEvent to avoid drawing the default slider
@@ -25,9 +88,20 @@ void ImageSlider::paintEvent(QPaintEvent *event)
     int currentVal = value();
     
     // Map current value to x coordinate
-    int handleX = static_cast<int>(availableWidth * (currentVal - minVal) / (maxVal - minVal));
+    int handleX = maxVal > minVal
+        ? static_cast<int>(static_cast<qint64>(availableWidth) * (currentVal - minVal) / (maxVal - minVal))
+        : 0;
     int handleY = (height() - m_handlePixmap.height()) / 2;  // Vertically centered
+
+    // Waveform overview behind the handle: played part left of the handle centre, pending part right of it
+    ensureWaveformPixmaps();
+    if (!m_playedWaveform.isNull()) {
+        const int split = handleX + m_handlePixmap.width() / 2;
+        painter.drawPixmap(QRect(0, 0, split, height()), m_playedWaveform, QRect(0, 0, split, height()));
+        painter.drawPixmap(QRect(split, 0, width() - split, height()), m_pendingWaveform,
+                           QRect(split, 0, width() - split, height()));
+    }
     
     // Draw the pixmap as the slider handle
     painter.drawPixmap(handleX, handleY, m_handlePixmap);
-}
\ No newline at end of file
+}
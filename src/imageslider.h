@@ -4,6 +4,9 @@
 #include <QSlider>
 #include <QPixmap>
 #include <QPaintEvent>
+#include <memory>
+
+#include "waveformcache.h"
 
 class ImageSlider : public QSlider
 {
@@ -16,15 +19,27 @@ public:
     void setCurrentVolume(int volume) { m_currentVolume = volume; }
 
     // 动态更新滑块手柄图片（用于换肤时更新）
-    void setThumbImage(const QPixmap &pixmap) { m_handlePixmap = pixmap; update(); }
+    void setThumbImage(const QPixmap &pixmap) { m_handlePixmap = pixmap; m_waveformDirty = true; update(); }
     void setPosition(qint64 pos) { setValue(static_cast<int>(pos)); }
 
+    // 在手柄后方绘制整首歌的波形概览；传入 nullptr 清除
+    void setWaveform(std::shared_ptr<const WaveformOverview> overview);
+
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
 
 private:
+    // 按当前尺寸把波形渲染为已播放 / 未播放两张缓存图（尺寸或数据变化时才重建）
+    void ensureWaveformPixmaps();
+
     QPixmap m_handlePixmap;
     int m_currentVolume;
+
+    std::shared_ptr<const WaveformOverview> m_waveform;
+    QPixmap m_playedWaveform;       // 手柄左侧（已播放）
+    QPixmap m_pendingWaveform;      // 手柄右侧（未播放）
+    bool m_waveformDirty = true;
 };
 
-#endif // IMAGESLIDER_H
\ No newline at end of file
+#endif // IMAGESLIDER_H
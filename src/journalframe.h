@@ -0,0 +1,102 @@
+/*
+ * 只追加日志的记录帧 (header-only)
+ *
+ * MediaLibrary 与 PlayQueue 共用的磁盘格式（大端）：
+ *   文件 = magic u32 | version u16 | 记录 ...
+ *   记录 = type u8 | length u32 | payload | checksum u32
+ * 校验为 FNV-1a，只用于发现写了一半的末尾记录（断电、崩溃），不防篡改。
+ *
+ * 使用方式:
+ *   file.write(journal::header(kMagic, kVersion));
+ *   file.write(journal::encode(type, payload));
+ *   int end = journal::decode(bytes, journal::kHeaderSize, [](quint8 type, const QByteArray& payload) { ... });
+ *   if (end < bytes.size()) 截掉末尾不完整的记录
+ */
+#ifndef TTPLAYER_JOURNALFRAME_H
+#define TTPLAYER_JOURNALFRAME_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QIODevice>
+#include <QtGlobal>
+#include <cstring>
+
+namespace journal {
+
+constexpr int kHeaderSize = 6;                  // magic u32 + version u16
+constexpr int kFrameOverhead = 1 + 4 + 4;       // type u8 + length u32 + checksum u32
+
+inline quint32 checksum(quint8 type, const char* data, int size)
+{
+    quint32 hash = 2166136261u;
+    hash = (hash ^ type) * 16777619u;
+    for (int i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<quint8>(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+inline void writeU32(char* out, quint32 value)
+{
+    out[0] = static_cast<char>(value >> 24);
+    out[1] = static_cast<char>(value >> 16);
+    out[2] = static_cast<char>(value >> 8);
+    out[3] = static_cast<char>(value);
+}
+
+inline quint32 readU32(const char* in)
+{
+    return (quint32(quint8(in[0])) << 24) | (quint32(quint8(in[1])) << 16)
+           | (quint32(quint8(in[2])) << 8) | quint32(quint8(in[3]));
+}
+
+inline QByteArray header(quint32 magic, quint16 version)
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << magic << version;
+    return bytes;
+}
+
+/**
+ * @brief 把一条记录的 payload 封装成帧
+ */
+inline QByteArray encode(quint8 type, const QByteArray& payload)
+{
+    QByteArray frame(kFrameOverhead + payload.size(), Qt::Uninitialized);
+    char* out = frame.data();
+    out[0] = static_cast<char>(type);
+    writeU32(out + 1, static_cast<quint32>(payload.size()));
+    std::memcpy(out + 5, payload.constData(), static_cast<size_t>(payload.size()));
+    writeU32(out + 5 + payload.size(), checksum(type, payload.constData(), payload.size()));
+    return frame;
+}
+
+/**
+ * @brief 从 offset 开始逐条解码，遇到不完整或校验失败的记录即停止
+ * @param handler 以 (type, payload) 调用；payload 不拷贝数据，只在回调期间有效
+ * @return 最后一条完整记录之后的偏移
+ */
+template <typename Handler>
+int decode(const QByteArray& bytes, int offset, Handler&& handler)
+{
+    const char* data = bytes.constData();
+    while (bytes.size() - offset >= kFrameOverhead) {
+        const quint8 type = static_cast<quint8>(data[offset]);
+        const quint32 length = readU32(data + offset + 1);
+        if (length > static_cast<quint32>(bytes.size() - offset - kFrameOverhead)) {
+            break;   // 末尾记录不完整
+        }
+        const char* payload = data + offset + 5;
+        if (readU32(payload + length) != checksum(type, payload, static_cast<int>(length))) {
+            break;
+        }
+        handler(type, QByteArray::fromRawData(payload, static_cast<int>(length)));
+        offset += kFrameOverhead + static_cast<int>(length);
+    }
+    return offset;
+}
+
+} // namespace journal
+
+#endif // TTPLAYER_JOURNALFRAME_H
@@ -0,0 +1,795 @@
+/*
+ * LibraryScanner 实现
+ */
+#include "libraryscanner.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+#ifdef Q_OS_UNIX
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// 只关心会改变“目录里有哪些歌、歌的内容”的事件；IN_CLOSE_WRITE 保证文件已写完
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                                | IN_DELETE_SELF | IN_ONLYDIR;
+#endif
+
+QString childPath(const QString& directory, const QString& name)
+{
+    return directory.endsWith('/') ? directory + name : directory + '/' + name;
+}
+
+// path 是否等于 directory 或位于其下
+bool isUnder(const QString& path, const QString& directory)
+{
+    if (!path.startsWith(directory)) {
+        return false;
+    }
+    return path.size() == directory.size() || directory.endsWith('/') || path.at(directory.size()) == '/';
+}
+
+QString normalizedDirectory(const QString& directory)
+{
+    return QDir::cleanPath(QFileInfo(directory).absoluteFilePath());
+}
+
+// 被 CUE 分轨引用的镜像不作为单曲入库：把它新的 (inode, size, mtime) 写到各分轨上，
+// 分轨的标题和起止时间不变，merge 据此判断镜像是否被改写
+void appendRestamped(const MediaLibrary::Track& image, const QStringList& virtualPaths,
+                     std::vector<MediaLibrary::Track>* tracks)
+{
+    const MediaLibrary& library = MediaLibrary::instance();
+    for (const QString& virtualPath : virtualPaths) {
+        const MediaLibrary::Track* existing = library.track(virtualPath);
+        if (!existing) {
+            continue;
+        }
+        MediaLibrary::Track stamped = *existing;
+        stamped.size = image.size;
+        stamped.modified = image.modified;
+        stamped.inode = image.inode;
+        tracks->push_back(std::move(stamped));
+    }
+}
+
+} // namespace
+
+// ========== 一次扫描的共享状态 ==========
+
+/**
+ * @brief 一次扫描（一组根目录）在工作线程之间共享的状态
+ *
+ * 每个工作线程一个目录队列：自己从队尾取、别人从队头偷。
+ * outstanding 计数已入队和正在处理的目录，子目录先入队再让父目录出账，
+ * 因此它降到 0 时整棵树一定已经遍历完。
+ */
+struct ScanWalk
+{
+    struct Queue {
+        QMutex mutex;
+        std::deque<QString> directories;
+    };
+
+    QStringList roots;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<int> outstanding{0};
+    std::atomic<int> runningWorkers{0};
+    std::atomic<int> directories{0};
+    std::atomic<int> files{0};
+
+    // 扫描开始时库中位于根目录下的歌曲（只读，工作线程并发查找）
+    QHash<QString, int> known;
+    std::vector<MediaLibrary::Track> knownStamps;   // 只填 size / modified / inode
+    std::vector<char> seen;                         // 每个下标只会被一个线程写入
+    QHash<QString, QStringList> cueImages;          // CUE 镜像文件 → 它的分轨（镜像本身不作为单曲入库）
+
+    QMutex listMutex;
+    QStringList failedDirectories;                  // 无法列出的目录，其下的歌曲不做删除判断
+    QStringList watchDirectories;                   // 回退监视器需要加入的目录
+
+    // 以下仅 GUI 线程访问
+    int added = 0;
+    int changed = 0;
+
+    void push(int worker, const QString& directory)
+    {
+        outstanding.fetch_add(1);
+        Queue& queue = *queues[worker];
+        QMutexLocker locker(&queue.mutex);
+        queue.directories.push_back(directory);
+    }
+
+    bool take(int worker, QString* directory)
+    {
+        {
+            Queue& own = *queues[worker];
+            QMutexLocker locker(&own.mutex);
+            if (!own.directories.empty()) {
+                *directory = std::move(own.directories.back());
+                own.directories.pop_back();
+                return true;
+            }
+        }
+        const int count = static_cast<int>(queues.size());
+        for (int i = 1; i < count; ++i) {
+            Queue& victim = *queues[(worker + i) % count];
+            QMutexLocker locker(&victim.mutex);
+            if (!victim.directories.empty()) {
+                *directory = std::move(victim.directories.front());
+                victim.directories.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// ========== 工作任务 ==========
+
+/**
+ * @brief 一个遍历线程：处理自己队列里的目录，空闲时窃取
+ */
+class WalkJob : public QRunnable
+{
+public:
+    WalkJob(const std::shared_ptr<ScanWalk>& walk, int worker)
+        : m_walk(walk), m_worker(worker)
+    {
+    }
+
+    void run() override
+    {
+        LibraryScanner& scanner = LibraryScanner::instance();
+        ScanWalk& walk = *m_walk;
+
+        QString directory;
+        int idleRounds = 0;
+        while (!scanner.m_cancel) {
+            if (!walk.take(m_worker, &directory)) {
+                if (walk.outstanding.load() == 0) {
+                    break;
+                }
+                // 其他线程还在列目录，稍后可能产生新的子目录
+                if (++idleRounds < 64) {
+                    QThread::yieldCurrentThread();
+                } else {
+                    QThread::usleep(500);
+                }
+                continue;
+            }
+            idleRounds = 0;
+            scanDirectory(scanner, directory);
+            walk.outstanding.fetch_sub(1);
+
+            if (m_batch.size() >= LibraryScanner::kBatchSize) {
+                postBatch(scanner);
+            }
+        }
+        if (scanner.m_cancel) {
+            return;
+        }
+        postBatch(scanner);
+
+        // 最后一个退出的线程通知 GUI 线程；之前的批次已先排进队列
+        if (walk.runningWorkers.fetch_sub(1) == 1) {
+            const std::shared_ptr<ScanWalk> finished = m_walk;
+            QMetaObject::invokeMethod(&scanner, [finished]() {
+                LibraryScanner::instance().finishWalk(finished);
+            }, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    void scanDirectory(LibraryScanner& scanner, const QString& directory)
+    {
+        ScanWalk& walk = *m_walk;
+        // 先注册监视再列目录：列目录期间新建的文件会产生事件，不会漏掉
+        scanner.watchDirectory(directory, &walk);
+        walk.directories.fetch_add(1);
+
+#ifdef Q_OS_UNIX
+        // readdir 的 d_type 可以区分目录和文件，只有音频文件才需要 stat
+        DIR* handle = ::opendir(QFile::encodeName(directory).constData());
+        if (!handle) {
+            QMutexLocker locker(&walk.listMutex);
+            walk.failedDirectories.append(directory);
+            return;
+        }
+        while (const dirent* entry = ::readdir(handle)) {
+            if (entry->d_name[0] == '.') {
+                continue;   // . .. 和隐藏文件
+            }
+            const QString name = QFile::decodeName(entry->d_name);
+            const QString path = childPath(directory, name);
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat st;
+                if (::lstat(QFile::encodeName(path).constData(), &st) != 0) {
+                    continue;
+                }
+                type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISLNK(st.st_mode) ? DT_LNK : DT_REG;
+            }
+            if (type == DT_DIR) {
+                walk.push(m_worker, path);
+            } else if ((type == DT_REG || type == DT_LNK) && LibraryScanner::isAudioFile(name)) {
+                // 指向文件的符号链接照常收录；不跟随目录符号链接，避免环
+                checkFile(path);
+            }
+        }
+        ::closedir(handle);
+#else
+        QDir dir(directory);
+        if (!dir.exists() || !dir.isReadable()) {
+            QMutexLocker locker(&walk.listMutex);
+            walk.failedDirectories.append(directory);
+            return;
+        }
+        const QFileInfoList entries = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+        for (const QFileInfo& entry : entries) {
+            if (entry.isDir()) {
+                if (!entry.isSymLink()) {
+                    walk.push(m_worker, entry.absoluteFilePath());
+                }
+            } else if (LibraryScanner::isAudioFile(entry.fileName())) {
+                checkFile(entry.absoluteFilePath());
+            }
+        }
+#endif
+    }
+
+    void checkFile(const QString& path)
+    {
+        ScanWalk& walk = *m_walk;
+        walk.files.fetch_add(1);
+
+        MediaLibrary::Track stamp;
+        if (!MediaLibrary::statFile(path, &stamp)) {
+            return;
+        }
+        const auto it = walk.known.constFind(stamp.path);
+        if (it != walk.known.constEnd()) {
+            walk.seen[*it] = 1;
+            const MediaLibrary::Track& known = walk.knownStamps[*it];
+            if (known.sameFile(stamp) && known.inode == stamp.inode) {
+                return;   // 未变化：不读内容，不写库
+            }
+        }
+        m_batch.push_back(std::move(stamp));
+    }
+
+    void postBatch(LibraryScanner& scanner)
+    {
+        if (m_batch.empty()) {
+            return;
+        }
+        std::vector<MediaLibrary::Track> batch;
+        batch.swap(m_batch);
+        const std::shared_ptr<ScanWalk> walk = m_walk;
+        QMetaObject::invokeMethod(&scanner, [walk, batch]() {
+            LibraryScanner::instance().mergeBatch(walk, batch);
+        }, Qt::QueuedConnection);
+    }
+
+    std::shared_ptr<ScanWalk> m_walk;
+    int m_worker;
+    std::vector<MediaLibrary::Track> m_batch;   // 新增或变化的文件，攒够一批再交回 GUI 线程
+};
+
+// ========== LibraryScanner ==========
+
+LibraryScanner& LibraryScanner::instance()
+{
+    static LibraryScanner inst;
+    return inst;
+}
+
+LibraryScanner::LibraryScanner(QObject* parent)
+    : QObject(parent)
+{
+    // 遍历以等待磁盘为主，线程数不必受核心数限制，但太多只会争抢同一块磁盘
+    m_pool.setMaxThreadCount(std::clamp(QThread::idealThreadCount(), 2, 8));
+
+    m_progressTimer.setInterval(kProgressMs);
+    connect(&m_progressTimer, &QTimer::timeout, this, [this]() {
+        if (m_walk) {
+            emit scanProgress(m_walk->directories.load(), m_walk->files.load());
+        }
+    });
+
+    m_settleTimer.setSingleShot(true);
+    m_settleTimer.setInterval(kSettleMs);
+    connect(&m_settleTimer, &QTimer::timeout, this, &LibraryScanner::processSettledEvents);
+
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (base.isEmpty()) {
+        base = QDir::tempPath();
+    }
+    QDir().mkpath(base);
+    m_rootsPath = QDir(base).filePath("library_roots.txt");
+    loadRoots();
+}
+
+LibraryScanner::~LibraryScanner()
+{
+    shutdown();
+}
+
+void LibraryScanner::shutdown()
+{
+    m_cancel = true;
+    m_settleTimer.stop();
+    m_progressTimer.stop();
+    m_pool.clear();
+    m_pool.waitForDone();
+    m_walk.reset();
+
+    delete m_inotifyNotifier;
+    m_inotifyNotifier = nullptr;
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd >= 0) {
+        ::close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+#endif
+    delete m_fallbackWatcher;
+    m_fallbackWatcher = nullptr;
+}
+
+bool LibraryScanner::isAudioFile(const QString& fileName)
+{
+    const int dot = fileName.lastIndexOf('.');
+    if (dot < 0) {
+        return false;
+    }
+    const QString suffix = fileName.mid(dot + 1).toLower();
+    // ape 多见于 CUE 整轨镜像
+    return suffix == "mp3" || suffix == "wav" || suffix == "flac" || suffix == "ape"
+           || suffix == "ogg" || suffix == "m4a" || suffix == "aac";
+}
+
+void LibraryScanner::loadRoots()
+{
+    QFile file(m_rootsPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QStringList lines = QString::fromUtf8(file.readAll()).split('\n');
+    for (const QString& line : lines) {
+        const QString root = line.trimmed();
+        if (!root.isEmpty()) {
+            m_roots.append(root);
+        }
+    }
+}
+
+void LibraryScanner::saveRoots()
+{
+    QSaveFile file(m_rootsPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[LibraryScanner] 无法保存根目录列表:" << m_rootsPath;
+        return;
+    }
+    file.write(m_roots.join('\n').toUtf8());
+    file.commit();
+}
+
+void LibraryScanner::addRoot(const QString& directory)
+{
+    if (m_cancel) {
+        return;
+    }
+    const QString root = normalizedDirectory(directory);
+    if (!QFileInfo(root).isDir()) {
+        return;
+    }
+
+    for (const QString& existing : m_roots) {
+        if (isUnder(root, existing)) {
+            scanDirectories(QStringList{root});
+            return;
+        }
+    }
+    // 新根目录包含旧的根目录时，旧的并入新的
+    for (int i = m_roots.size() - 1; i >= 0; --i) {
+        if (isUnder(m_roots[i], root)) {
+            m_roots.removeAt(i);
+        }
+    }
+    m_roots.append(root);
+    saveRoots();
+    qDebug() << "[LibraryScanner] 加入根目录:" << root;
+
+    startWatching();
+    scanDirectories(QStringList{root});
+}
+
+void LibraryScanner::rescan()
+{
+    if (m_cancel || m_roots.isEmpty()) {
+        return;
+    }
+    startWatching();
+    scanDirectories(m_roots);
+}
+
+void LibraryScanner::scanDirectories(const QStringList& directories)
+{
+    for (const QString& directory : directories) {
+        bool covered = false;
+        for (int i = m_queuedDirectories.size() - 1; i >= 0; --i) {
+            if (isUnder(directory, m_queuedDirectories[i])) {
+                covered = true;
+                break;
+            }
+            if (isUnder(m_queuedDirectories[i], directory)) {
+                m_queuedDirectories.removeAt(i);
+            }
+        }
+        if (!covered) {
+            m_queuedDirectories.append(directory);
+        }
+    }
+    startWalk();
+}
+
+void LibraryScanner::startWalk()
+{
+    if (m_walk || m_queuedDirectories.isEmpty() || m_cancel) {
+        return;
+    }
+
+    auto walk = std::make_shared<ScanWalk>();
+    walk->roots = m_queuedDirectories;
+    m_queuedDirectories.clear();
+
+    // 只为根目录下的歌曲建快照，扫描结束时据此找出已被删除的文件
+    MediaLibrary& library = MediaLibrary::instance();
+    for (const QString& path : library.paths()) {
+        for (const QString& root : walk->roots) {
+            if (isUnder(path, root)) {
+                const MediaLibrary::Track* track = library.track(path);
+                // CUE 分轨以镜像文件参与比对：镜像未变化时不会被当成新歌加入，消失时分轨一并删除
+                const QString file = track->audioFile();
+                if (track->isVirtual()) {
+                    walk->cueImages[file].append(path);
+                    if (walk->known.contains(file)) {
+                        break;
+                    }
+                }
+                MediaLibrary::Track stamp;
+                stamp.size = track->size;
+                stamp.modified = track->modified;
+                stamp.inode = track->inode;
+                walk->known.insert(file, static_cast<int>(walk->knownStamps.size()));
+                walk->knownStamps.push_back(stamp);
+                break;
+            }
+        }
+    }
+    walk->seen.assign(walk->knownStamps.size(), 0);
+
+    const int workers = m_pool.maxThreadCount();
+    for (int i = 0; i < workers; ++i) {
+        walk->queues.push_back(std::make_unique<ScanWalk::Queue>());
+    }
+    for (int i = 0; i < walk->roots.size(); ++i) {
+        walk->push(i % workers, walk->roots[i]);
+    }
+    walk->runningWorkers = workers;
+
+    m_walk = walk;
+    emit scanStarted();
+    m_progressTimer.start();
+    for (int i = 0; i < workers; ++i) {
+        m_pool.start(new WalkJob(walk, i));
+    }
+}
+
+void LibraryScanner::mergeBatch(const std::shared_ptr<ScanWalk>& walk, const std::vector<MediaLibrary::Track>& batch)
+{
+    if (m_cancel) {
+        return;
+    }
+    MediaLibrary& library = MediaLibrary::instance();
+    std::vector<MediaLibrary::Track> tracks;
+    tracks.reserve(batch.size());
+    for (const MediaLibrary::Track& track : batch) {
+        // 被 CUE 分轨引用的镜像改写后保留原分轨（更新其文件戳），不再作为单曲加入
+        const auto image = walk->cueImages.constFind(track.path);
+        if (image != walk->cueImages.constEnd()) {
+            appendRestamped(track, image.value(), &tracks);
+        } else {
+            tracks.push_back(track);
+        }
+    }
+    const int before = library.count();
+    const int changed = library.merge(tracks);
+    const int added = library.count() - before;
+    walk->added += added;
+    walk->changed += changed - added;
+}
+
+void LibraryScanner::finishWalk(const std::shared_ptr<ScanWalk>& walk)
+{
+    if (m_cancel) {
+        return;
+    }
+    m_progressTimer.stop();
+    m_walk.reset();
+
+    // 快照中有、这次没遇到的歌曲已从磁盘消失；列不出的目录（未挂载、无权限）下的不算
+    QStringList missing;
+    for (auto it = walk->known.constBegin(); it != walk->known.constEnd(); ++it) {
+        if (walk->seen[it.value()]) {
+            continue;
+        }
+        const bool unreadable = std::any_of(walk->failedDirectories.cbegin(), walk->failedDirectories.cend(),
+                                            [&](const QString& failed) { return isUnder(it.key(), failed); });
+        if (!unreadable) {
+            missing.append(walk->cueImages.value(it.key(), QStringList{it.key()}));
+        }
+    }
+    const int removed = MediaLibrary::instance().remove(missing);
+
+    if (m_fallbackWatcher && !walk->watchDirectories.isEmpty()) {
+        const QStringList watched = m_fallbackWatcher->directories();
+        QStringList fresh;
+        for (const QString& directory : walk->watchDirectories) {
+            if (!watched.contains(directory)) {
+                fresh.append(directory);
+            }
+        }
+        if (!fresh.isEmpty()) {
+            m_fallbackWatcher->addPaths(fresh);
+        }
+    }
+
+    qDebug() << "[LibraryScanner] 扫描完成:" << walk->directories.load() << "个目录," << walk->files.load()
+             << "个音频文件, 新增" << walk->added << "变化" << walk->changed << "删除" << removed;
+    emit scanProgress(walk->directories.load(), walk->files.load());
+    emit scanFinished(walk->added, walk->changed, removed);
+
+    startWalk();
+}
+
+// ========== 目录监视 ==========
+
+void LibraryScanner::startWatching()
+{
+    if (m_inotifyFd >= 0 || m_fallbackWatcher) {
+        return;
+    }
+#ifdef Q_OS_LINUX
+    m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd >= 0) {
+        m_inotifyNotifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+        connect(m_inotifyNotifier, &QSocketNotifier::activated, this, &LibraryScanner::readWatchEvents);
+        return;
+    }
+    qWarning() << "[LibraryScanner] inotify 不可用，回退到 QFileSystemWatcher";
+#endif
+    m_fallbackWatcher = new QFileSystemWatcher(this);
+    connect(m_fallbackWatcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString& directory) {
+        m_pendingDirectories.insert(directory);
+        m_settleTimer.start();
+    });
+}
+
+/**
+ * @brief 监视一个目录（工作线程）
+ */
+void LibraryScanner::watchDirectory(const QString& directory, ScanWalk* walk)
+{
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd >= 0) {
+        // 重复注册同一目录返回同一个 wd，只会刷新映射
+        const int wd = ::inotify_add_watch(m_inotifyFd, QFile::encodeName(directory).constData(), kWatchMask);
+        const int error = errno;
+        QMutexLocker locker(&m_watchMutex);
+        if (wd >= 0) {
+            m_watches.insert(wd, directory);
+        } else if (error == ENOSPC && !m_watchLimitWarned) {
+            m_watchLimitWarned = true;
+            qWarning() << "[LibraryScanner] inotify 监视数已达上限 (fs.inotify.max_user_watches)，"
+                          "部分目录的变化要到下次启动扫描时才能发现";
+        }
+        return;
+    }
+#endif
+    if (m_fallbackWatcher) {
+        QMutexLocker locker(&walk->listMutex);
+        walk->watchDirectories.append(directory);
+    }
+}
+
+void LibraryScanner::readWatchEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[16384];
+    for (;;) {
+        const ssize_t length = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;   // EAGAIN：已读空
+        }
+        for (const char* p = buffer; p < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                m_pendingRescan = true;   // 内核丢了事件，只能整体重扫
+                continue;
+            }
+            QString directory;
+            {
+                QMutexLocker locker(&m_watchMutex);
+                if (event->mask & IN_IGNORED) {
+                    m_watches.remove(event->wd);
+                    continue;
+                }
+                directory = m_watches.value(event->wd);
+            }
+            if (directory.isEmpty() || event->len == 0 || event->name[0] == '.') {
+                continue;
+            }
+
+            const QString name = QFile::decodeName(event->name);
+            const QString path = childPath(directory, name);
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    m_pendingRemovals.remove(path);
+                    m_pendingDirectories.insert(path);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    unwatchTree(path);
+                    m_pendingDirectories.remove(path);
+                    m_pendingRemovals.insert(path);
+                }
+            } else if (isAudioFile(name)) {
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    m_pendingRemovals.remove(path);
+                    m_pendingFiles.insert(path);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    m_pendingFiles.remove(path);
+                    m_pendingRemovals.insert(path);
+                }
+            }
+        }
+    }
+
+    if (m_pendingRescan || !m_pendingFiles.isEmpty() || !m_pendingRemovals.isEmpty()
+        || !m_pendingDirectories.isEmpty()) {
+        m_settleTimer.start();
+    }
+#endif
+}
+
+/**
+ * @brief 目录被移走后，注销它和子目录的监视（移到监视范围内时会重新注册）
+ */
+void LibraryScanner::unwatchTree(const QString& directory)
+{
+#ifdef Q_OS_LINUX
+    QMutexLocker locker(&m_watchMutex);
+    for (auto it = m_watches.begin(); it != m_watches.end();) {
+        if (isUnder(it.value(), directory)) {
+            ::inotify_rm_watch(m_inotifyFd, it.key());
+            it = m_watches.erase(it);
+        } else {
+            ++it;
+        }
+    }
+#else
+    Q_UNUSED(directory)
+#endif
+}
+
+/**
+ * @brief 处理合并窗口内积累的事件：删除、单个文件更新、新目录扫描
+ */
+void LibraryScanner::processSettledEvents()
+{
+    if (m_cancel) {
+        return;
+    }
+    if (m_pendingRescan) {
+        m_pendingRescan = false;
+        m_pendingFiles.clear();
+        m_pendingRemovals.clear();
+        m_pendingDirectories.clear();
+        qWarning() << "[LibraryScanner] 监视事件溢出，重新扫描全部根目录";
+        rescan();
+        return;
+    }
+
+    MediaLibrary& library = MediaLibrary::instance();
+
+    // CUE 镜像 → 它的分轨；镜像本身不在库中，只有遇到库中没有的路径时才建一次
+    QHash<QString, QStringList> cueImages;
+    bool cueImagesBuilt = false;
+    auto cueTracksOf = [&](const QString& path) {
+        if (!cueImagesBuilt) {
+            cueImagesBuilt = true;
+            for (int slot : library.liveSlots()) {
+                const MediaLibrary::Track& track = library.trackAt(slot);
+                if (track.isVirtual()) {
+                    cueImages[track.source].append(track.path);
+                }
+            }
+        }
+        return cueImages.value(path);
+    };
+
+    // 删除：文件直接删，CUE 镜像删掉它的分轨，目录删掉其下所有歌曲
+    QStringList removals;
+    QStringList libraryPaths;
+    for (const QString& path : std::as_const(m_pendingRemovals)) {
+        if (library.contains(path)) {
+            removals.append(path);
+            continue;
+        }
+        const QStringList cueTracks = cueTracksOf(path);
+        if (!cueTracks.isEmpty()) {
+            removals.append(cueTracks);
+            continue;
+        }
+        if (libraryPaths.isEmpty()) {
+            libraryPaths = library.paths();
+        }
+        for (const QString& candidate : std::as_const(libraryPaths)) {
+            if (isUnder(candidate, path)) {
+                removals.append(candidate);
+            }
+        }
+    }
+    m_pendingRemovals.clear();
+    const int removed = library.remove(removals);
+
+    // 写完或移入的文件：数量通常很少，直接在 GUI 线程 stat；改写的 CUE 镜像只更新其分轨的文件戳
+    std::vector<MediaLibrary::Track> stamps;
+    for (const QString& path : std::as_const(m_pendingFiles)) {
+        MediaLibrary::Track stamp;
+        if (!MediaLibrary::statFile(path, &stamp)) {
+            continue;
+        }
+        const QStringList cueTracks = library.contains(path) ? QStringList() : cueTracksOf(path);
+        if (!cueTracks.isEmpty()) {
+            appendRestamped(stamp, cueTracks, &stamps);
+        } else {
+            stamps.push_back(std::move(stamp));
+        }
+    }
+    m_pendingFiles.clear();
+    const int before = library.count();
+    const int changed = library.merge(stamps);
+    const int added = library.count() - before;
+
+    if (added > 0 || changed > added || removed > 0) {
+        emit scanFinished(added, changed - added, removed);
+    }
+
+    if (!m_pendingDirectories.isEmpty()) {
+        const QStringList directories = m_pendingDirectories.values();
+        m_pendingDirectories.clear();
+        scanDirectories(directories);
+    }
+}
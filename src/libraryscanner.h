@@ -0,0 +1,132 @@
+/*
+ * LibraryScanner - 音乐文件夹的并行增量扫描与目录监视
+ *
+ * 把拖入的文件夹记为媒体库根目录（保存在数据目录的 library_roots.txt），
+ * 启动时和加入根目录时各扫描一遍，之后依靠目录监视保持同步，不再定时重扫：
+ *   - 遍历：每个工作线程有自己的目录双端队列，从队尾取（深度优先，局部性好），
+ *     自己的队列空了就从其他线程的队头窃取（通常是更大的子树），目录树很不平衡时也能均摊负载
+ *   - 增量：(inode, size, mtime) 与库中记录一致的文件直接跳过，不读文件内容；
+ *     扫描结束后，根目录下库里有但磁盘上已不存在的歌曲被删除（根目录不可访问时不删）
+ *   - 监视：Linux 上用 inotify，遍历到目录时立即注册（先注册再列目录，中间新建的文件不会漏掉）；
+ *     其他平台回退到 QFileSystemWatcher，目录变化时增量扫描该目录
+ *   - 事件先合并 300ms 再处理，复制大量文件时不会逐个触发
+ *
+ * 扫描结果分批排队交回 GUI 线程写入 MediaLibrary，进度通过信号报告，不阻塞界面。
+ *
+ * 使用方式:
+ *   connect(&LibraryScanner::instance(), &LibraryScanner::scanProgress, ...);
+ *   LibraryScanner::instance().addRoot(folder);
+ *   LibraryScanner::instance().rescan();
+ */
+#ifndef LIBRARYSCANNER_H
+#define LIBRARYSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QSet>
+#include <QHash>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "medialibrary.h"
+
+class QSocketNotifier;
+class QFileSystemWatcher;
+struct ScanWalk;
+
+class LibraryScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LibraryScanner& instance();
+
+    /**
+     * @brief 播放器能播放的音频扩展名（与主窗口拖放规则一致）
+     */
+    static bool isAudioFile(const QString& fileName);
+
+    QStringList roots() const { return m_roots; }
+    bool isScanning() const { return m_walk != nullptr; }
+
+    /**
+     * @brief 加入一个根目录并立即扫描；已被某个根目录包含时只重扫该目录
+     */
+    void addRoot(const QString& directory);
+
+    /**
+     * @brief 增量扫描全部根目录并开始监视（启动时调用）
+     */
+    void rescan();
+
+    /**
+     * @brief 停止监视，取消扫描并等待工作线程退出（程序退出前调用）
+     */
+    void shutdown();
+
+signals:
+    void scanStarted();
+    void scanProgress(int directories, int files);
+    void scanFinished(int added, int changed, int removed);
+
+private:
+    friend class WalkJob;
+
+    LibraryScanner(QObject* parent = nullptr);
+    ~LibraryScanner();
+    LibraryScanner(const LibraryScanner&) = delete;
+    LibraryScanner& operator=(const LibraryScanner&) = delete;
+
+    void loadRoots();
+    void saveRoots();
+
+    // 扫描给定目录；已有扫描在进行时排到它结束之后
+    void scanDirectories(const QStringList& directories);
+    void startWalk();
+
+    // 在 GUI 线程中接收工作线程的结果
+    void mergeBatch(const std::shared_ptr<ScanWalk>& walk, const std::vector<MediaLibrary::Track>& batch);
+    void finishWalk(const std::shared_ptr<ScanWalk>& walk);
+
+    // 目录监视（watchDirectory 在工作线程中调用）
+    void startWatching();
+    void watchDirectory(const QString& directory, ScanWalk* walk);
+    void readWatchEvents();
+    void unwatchTree(const QString& directory);
+    void processSettledEvents();
+
+    static constexpr int kBatchSize = 256;          // 每批交回 GUI 线程的变化文件数
+    static constexpr int kSettleMs = 300;           // 监视事件合并窗口
+    static constexpr int kProgressMs = 200;         // 进度信号间隔
+
+    QString m_rootsPath;
+    QStringList m_roots;                            // 绝对路径，互不包含
+
+    QThreadPool m_pool;
+    std::atomic<bool> m_cancel{false};
+    std::shared_ptr<ScanWalk> m_walk;               // 正在进行的扫描
+    QStringList m_queuedDirectories;                // 等当前扫描结束后再扫
+    QTimer m_progressTimer;
+
+    // 监视：inotify 描述符与 wd → 目录映射（工作线程注册，受 m_watchMutex 保护）
+    int m_inotifyFd = -1;
+    QSocketNotifier* m_inotifyNotifier = nullptr;
+    QMutex m_watchMutex;
+    QHash<int, QString> m_watches;
+    bool m_watchLimitWarned = false;
+    QFileSystemWatcher* m_fallbackWatcher = nullptr;
+
+    // 尚未处理的监视事件（GUI 线程）
+    QTimer m_settleTimer;
+    QSet<QString> m_pendingFiles;
+    QSet<QString> m_pendingRemovals;
+    QSet<QString> m_pendingDirectories;
+    bool m_pendingRescan = false;
+};
+
+#endif // LIBRARYSCANNER_H
@@ -1,17 +1,50 @@
 #include <QApplication>
+#include <QGuiApplication>
 #include <QIcon>
+#include <QStringList>
+#include <cstdio>
 #include "mainwindow.h"
+#include "offlinerenderer.h"
+
+/**
+ * @brief 无窗口离线渲染：TTPlayer --render <input.mp3> [选项]
+ *
+ * 使用 offscreen 平台插件，不需要显示器，可在服务器上运行。
+ */
+static int runOfflineRender(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    OfflineRenderer::Options options;
+    QString error;
+    if (!OfflineRenderer::parseArguments(app.arguments().mid(1), &options, &error)) {
+        std::fprintf(stderr, "%s\n\n%s", qPrintable(error), qPrintable(OfflineRenderer::usage()));
+        return 2;
+    }
+
+    OfflineRenderer renderer(options);
+    return renderer.run();
+}
 
 int main(int argc, char *argv[])
 {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--render") == 0) {
+            return runOfflineRender(argc, argv);
+        }
+    }
+
     QApplication app(argc, argv);
-    
+
     // Set application icon
     app.setWindowIcon(QIcon(":/skin/Purple/TTPlayer.ico"));
-    
+
     // Create and show the main window
     MainWindow mainWindow;
     mainWindow.show();
-    
+
     return app.exec();
-}
\ No newline at end of file
+}
@@ -2,6 +2,14 @@
 // Version: 2.0 - 集成 SkinEngine，支持拖放 .skn 换肤
 #include "mainwindow.h"
 #include "playlist.h"
+#include "temposcanner.h"
+#include "medialibrary.h"
+#include "libraryscanner.h"
+#include "tagreader.h"
+#include "playqueue.h"
+#include "playlistio.h"
+#include "pathvalidator.h"
+#include "duplicatefinder.h"
 #include <QFile>
 #include <QTextStream>
 #include <QFileInfo>
@@ -51,12 +59,15 @@ MainWindow::MainWindow(QWidget *parent)
       m_currentIndex(0),
       m_shuffleMode(false),
       m_currentPlayingPath(QString()),
+      m_segmentStart(0),
+      m_segmentEnd(0),
       m_dragging(false),
       m_playlistWindow(nullptr),
       // 快捷键 / 动画
       m_spaceShortcut(nullptr),
       m_upShortcut(nullptr),
       m_downShortcut(nullptr),
+      m_shuffleShortcut(nullptr),
       m_animation(nullptr),
       m_usingExternalSkin(false)
 {
@@ -105,11 +116,58 @@ MainWindow::MainWindow(QWidget *parent)
     connect(&SkinEngine::instance(), &SkinEngine::skinChanged,
             this, &MainWindow::onSkinChanged);
 
+    // 波形概览在后台线程池生成，就绪后交给进度条
+    connect(&WaveformCache::instance(), &WaveformCache::overviewReady, this, [this](const QString &path) {
+        if (path == m_waveformPath && m_progressSlider)
+            m_progressSlider->setWaveform(WaveformCache::instance().overview(path));
+    });
+#ifdef QT_MULTIMEDIA_ENABLED
+    connect(m_player, &QMediaPlayer::sourceChanged, this, [this](const QUrl &source) {
+        // CUE 分轨只播放镜像中的一段，整个镜像的波形与进度条对不上，不显示
+        const bool segment = m_segmentStart > 0 || m_segmentEnd > 0;
+        showWaveform(source.isLocalFile() && !segment ? source.toLocalFile() : QString());
+    });
+#endif
+
+    // 文件夹扫描在后台进行，只在歌词标签上报告进度和结果
+    connect(&LibraryScanner::instance(), &LibraryScanner::scanProgress, this, [this](int directories, int files) {
+        if (m_currentLyricLabel && LibraryScanner::instance().isScanning())
+            m_currentLyricLabel->setText(QString("正在扫描音乐文件夹: %1 个目录, %2 首").arg(directories).arg(files));
+    });
+    connect(&PathValidator::instance(), &PathValidator::checkFinished, this, [this](int, int missing) {
+        if (!m_currentLyricLabel || missing == 0)
+            return;
+        m_currentLyricLabel->setText(QString("播放列表中有 %1 首歌曲的文件不存在（已标记）").arg(missing));
+        m_currentLyricLabel->fadeIn();
+    });
+    connect(&LibraryScanner::instance(), &LibraryScanner::scanFinished, this, [this](int added, int changed, int removed) {
+        if (!m_currentLyricLabel || added + changed + removed == 0)
+            return;
+        m_currentLyricLabel->setText(QString("媒体库已更新: 新增 %1 首, 变化 %2 首, 移除 %3 首")
+                                         .arg(added).arg(changed).arg(removed));
+        m_currentLyricLabel->fadeIn();
+    });
+
     initUI();
+
+    // 播放列表窗口已建好并在监听媒体库，再增量扫描已加入的文件夹并开始监视
+    LibraryScanner::instance().rescan();
 }
 
 MainWindow::~MainWindow()
 {
+    // 先停止文件夹扫描和监视，不再有新歌进入媒体库
+    LibraryScanner::instance().shutdown();
+    TagReader::instance().shutdown();
+    PathValidator::instance().shutdown();
+    // 不再接收标签 / 波形 / 节拍 / 指纹结果，等待正在读取和解码的任务退出
+    WaveformCache::instance().shutdown();
+    TempoScanner::instance().shutdown();
+    DuplicateFinder::instance().shutdown();
+    // 节拍结果已写入媒体库，最后刷新 / 压缩日志
+    MediaLibrary::instance().shutdown();
+    // 写出 PlayList 记下的最后播放位置（CUE 分轨记的是分轨和段内位置，不能从播放器的音源取）
+    PlayQueue::instance().shutdown();
 }
 
 // ============================================================
@@ -260,6 +318,7 @@ void MainWindow::applyDefaultSkinUI()
     m_spaceShortcut = new QShortcut(QKeySequence(Qt::Key_Space), this);
     m_upShortcut = new QShortcut(QKeySequence(Qt::Key_Up), this);
     m_downShortcut = new QShortcut(QKeySequence(Qt::Key_Down), this);
+    m_shuffleShortcut = new QShortcut(QKeySequence(Qt::Key_S), this);
 
     // ---- 连接信号槽 ----
     connect(m_closeBtn, &QPushButton::clicked, this, &MainWindow::exitAll);
@@ -284,7 +343,7 @@ void MainWindow::applyDefaultSkinUI()
     connect(m_progressSlider, &QSlider::sliderReleased, this, &MainWindow::sliderReleased);
     connect(m_progressSlider, &QSlider::valueChanged, this, [this]() {
         if (m_progressSlider->isSliderDown() && m_spectrumBars)
-            m_spectrumBars->updateForPosition(m_progressSlider->value());
+            m_spectrumBars->updateForPosition(m_segmentStart + m_progressSlider->value());
     });
 #ifdef QT_MULTIMEDIA_ENABLED
     connect(m_volumeSlider, &QSlider::valueChanged, this, [this](int value) {
@@ -300,6 +359,7 @@ void MainWindow::applyDefaultSkinUI()
     connect(m_spaceShortcut, &QShortcut::activated, this, &MainWindow::playAudio);
     connect(m_upShortcut, &QShortcut::activated, this, &MainWindow::increaseVolume);
     connect(m_downShortcut, &QShortcut::activated, this, &MainWindow::decreaseVolume);
+    connect(m_shuffleShortcut, &QShortcut::activated, this, &MainWindow::toggleShuffle);
 }
 
 // ============================================================
@@ -523,6 +583,7 @@ void MainWindow::rebuildFromSkinConfig()
         engine.getSpectrumMidColor(),
         engine.getSpectrumPeakColor()
     );
+    m_spectrumBars->setBandLayout(engine.getSpectrumLayout());
 
     // 如果播放器还没连接，重新连接
 #ifdef QT_MULTIMEDIA_ENABLED
@@ -546,6 +607,7 @@ void MainWindow::rebuildFromSkinConfig()
         m_spaceShortcut = new QShortcut(QKeySequence(Qt::Key_Space), this);
         m_upShortcut = new QShortcut(QKeySequence(Qt::Key_Up), this);
         m_downShortcut = new QShortcut(QKeySequence(Qt::Key_Down), this);
+        m_shuffleShortcut = new QShortcut(QKeySequence(Qt::Key_S), this);
     }
 
     // ---- 重连所有信号（防止重复连接）----
@@ -646,7 +708,7 @@ void MainWindow::showMusicList()
 }
 
 // ============================================================
-// 拖放事件 - 支持 .mp3 和 .skn 文件
+// 拖放事件 - 支持 .mp3、.skn 文件和文件夹
 // ============================================================
 
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
@@ -670,17 +732,27 @@ void MainWindow::dropEvent(QDropEvent *event)
     QString firstValidPath;
     QString sknPath;   // 记录遇到的 .skn 文件
 
+    bool foundFolder = false;
+    bool foundPlaylist = false;
+
     for (const QUrl &url : urls) {
         QString filePath = url.toLocalFile();
         QString suffix = QFileInfo(filePath).suffix().toLower();
 
-        if (suffix == "mp3" || suffix == "wav" || suffix == "flac"
-            || suffix == "ogg" || suffix == "m4a" || suffix == "aac") {
+        if (QFileInfo(filePath).isDir()) {
+            // 文件夹加入媒体库根目录：后台扫描，之后由目录监视保持同步
+            LibraryScanner::instance().addRoot(filePath);
+            foundFolder = true;
+        } else if (LibraryScanner::isAudioFile(filePath)) {
             addPlaylist(filePath);
             if (!foundValidFile) {
                 foundValidFile = true;
                 firstValidPath = filePath;
             }
+        } else if (PlaylistIO::isPlaylistFile(filePath) && m_playlistWindow) {
+            // .m3u / .m3u8 / .pls / .cue：逐条导入媒体库，CUE 镜像拆成分轨
+            m_playlistWindow->importPlaylist(filePath);
+            foundPlaylist = true;
         } else if (suffix == "skn") {
             sknPath = filePath;  // 记录 .skn 文件路径
         } else {
@@ -729,10 +801,12 @@ void MainWindow::dropEvent(QDropEvent *event)
         m_currentPlayingPath = firstValidPath;
 
 #ifdef QT_MULTIMEDIA_ENABLED
+        setPlaybackSegment(0, 0);
         m_player->setSource(QUrl::fromLocalFile(firstValidPath));
         m_player->play();
 #else
         if (m_audioPlayer) m_audioPlayer->playFile(firstValidPath);
+        showWaveform(firstValidPath);
 #endif
 
         // 切换为暂停图标（只传文件名，loadButtonImages 会自动加前缀）
@@ -750,7 +824,7 @@ void MainWindow::dropEvent(QDropEvent *event)
             m_playlistWindow->loadLyrics(firstValidPath, this);
     }
 
-    if (!foundValidFile && sknPath.isEmpty())
+    if (!foundValidFile && !foundFolder && !foundPlaylist && sknPath.isEmpty())
         event->ignore();
 }
 
@@ -760,48 +834,27 @@ void MainWindow::dropEvent(QDropEvent *event)
 
 void MainWindow::addPlaylist(const QString &filePath)
 {
-    QFile file("play_list.txt");
-    if (file.open(QIODevice::ReadWrite | QIODevice::Text)) {
-        QTextStream in(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        in.setCodec("UTF-8");
-#endif
-        QString content = in.readAll();
-
-        if (!content.contains(filePath)) {
-            file.seek(file.size());
-            QTextStream out(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-            out.setCodec("UTF-8");
-#endif
-            out << filePath << "\n";
-            qDebug("Added to playlist");
-        } else {
-            qDebug("Already exists in playlist");
-        }
-        file.close();
-
-        if (m_playlistWindow) {
-            m_playlistWindow->loadMusicFolder();
-            m_playlistWindow->updatePlaylistDisplay();
+    // 媒体库只追加一条记录，播放列表模型只插入一行，不再整体重写 / 重读列表
+    if (!m_playlistWindow) {
+        MediaLibrary::instance().add(filePath);
+        return;
+    }
+    m_playlistWindow->addPlaylist(filePath);
 
 #ifdef QT_MULTIMEDIA_ENABLED
-            if (m_player->playbackState() == QMediaPlayer::StoppedState) {
+    if (m_player->playbackState() == QMediaPlayer::StoppedState) {
 #else
-            if (true) {  // 无 Multimedia 时始终自动播放第一首
+    if (true) {  // 无 Multimedia 时始终自动播放第一首
 #endif
-                QListWidgetItem *firstItem = m_playlistWindow->findChild<QListWidget*>()->item(0);
-                if (firstItem) {
-                    QMetaObject::invokeMethod(m_playlistWindow, "selectSong", Qt::DirectConnection,
-                                             Q_ARG(QListWidgetItem*, firstItem));
-                    QString pImg = "pause.bmp";
-                    QList<QPixmap> images = loadButtonImages(pImg);
-                    if (images.size() >= 3) {
-                        int r = 5;
-                        setupHoverPressedIcon(m_playBtn,
-                            roundPixmap(images[0], r), roundPixmap(images[1], r), roundPixmap(images[2], r));
-                    }
-                }
+        if (m_playlistWindow->songCount() > 0) {
+            QMetaObject::invokeMethod(m_playlistWindow, "playRow", Qt::DirectConnection,
+                                     Q_ARG(int, 0));
+            QString pImg = "pause.bmp";
+            QList<QPixmap> images = loadButtonImages(pImg);
+            if (images.size() >= 3) {
+                int r = 5;
+                setupHoverPressedIcon(m_playBtn,
+                    roundPixmap(images[0], r), roundPixmap(images[1], r), roundPixmap(images[2], r));
             }
         }
     }
@@ -811,8 +864,7 @@ void MainWindow::playAudio()
 {
     bool hasSongs = false;
     if (m_playlistWindow) {
-        QListWidget *songList = m_playlistWindow->findChild<QListWidget*>();
-        hasSongs = songList && songList->count() > 0;
+        hasSongs = m_playlistWindow->songCount() > 0;
     }
 
 #ifdef QT_MULTIMEDIA_ENABLED
@@ -843,15 +895,14 @@ void MainWindow::playAudio()
     } else {
         // 未播放（暂停/停止）-> 播放
         if (m_player->source().isEmpty() && m_playlistWindow) {
-            // 没有音源，从列表选一首
-            QListWidget *songList = m_playlistWindow->findChild<QListWidget*>();
-            if (songList && songList->count() > 0) {
-                QListWidgetItem *firstItem = songList->item(0);
-                if (firstItem) {
-                    QMetaObject::invokeMethod(m_playlistWindow, "selectSong", Qt::DirectConnection,
-                                             Q_ARG(QListWidgetItem*, firstItem));
-                    return;
-                }
+            // 没有音源：先从上次退出时的歌曲和位置继续，否则从列表选一首
+            if (m_playlistWindow->resumeLastSession()) {
+                return;
+            }
+            if (m_playlistWindow->songCount() > 0) {
+                QMetaObject::invokeMethod(m_playlistWindow, "playRow", Qt::DirectConnection,
+                                         Q_ARG(int, 0));
+                return;
             }
         }
         m_player->play();
@@ -869,14 +920,10 @@ void MainWindow::playAudio()
     } else {
         // 未开始播放，从列表选一首
         if (!hasSource && m_playlistWindow) {
-            QListWidget *songList = m_playlistWindow->findChild<QListWidget*>();
-            if (songList && songList->count() > 0) {
-                QListWidgetItem *firstItem = songList->item(0);
-                if (firstItem) {
-                    QMetaObject::invokeMethod(m_playlistWindow, "selectSong", Qt::DirectConnection,
-                                             Q_ARG(QListWidgetItem*, firstItem));
-                    return;
-                }
+            if (m_playlistWindow->songCount() > 0) {
+                QMetaObject::invokeMethod(m_playlistWindow, "playRow", Qt::DirectConnection,
+                                         Q_ARG(int, 0));
+                return;
             }
         }
         if (!m_currentPlayingPath.isEmpty() && m_audioPlayer) {
@@ -1035,15 +1082,43 @@ void MainWindow::mouseReleaseEvent(QMouseEvent *event)
 // 滑块与音量
 // ============================================================
 
+void MainWindow::showWaveform(const QString &filePath)
+{
+    m_waveformPath = filePath;
+    if (!m_progressSlider)
+        return;
+
+    // 内存中已有则立即显示；否则先清掉上一首的波形，等待 overviewReady
+    WaveformCache &cache = WaveformCache::instance();
+    m_progressSlider->setWaveform(cache.overview(filePath));
+    if (!filePath.isEmpty())
+        cache.request(filePath);
+}
+
+void MainWindow::setPlaybackSegment(qint64 startMs, qint64 endMs)
+{
+    m_segmentStart = startMs;
+    m_segmentEnd = endMs;
+#ifdef QT_MULTIMEDIA_ENABLED
+    // 同一镜像中切换分轨不会重新加载音源，也就不会再收到 durationChanged
+    if (m_player && m_progressSlider && m_player->duration() > 0) {
+        setSliderDuration(m_player->duration());
+        updateSliderPosition(m_player->position());
+    }
+#endif
+}
+
 void MainWindow::updateSliderPosition(qint64 position)
 {
     if (!m_progressSlider->isSliderDown())
-        m_progressSlider->setPosition(position);
+        m_progressSlider->setPosition(qMax<qint64>(0, position - m_segmentStart));
 }
 
 void MainWindow::setSliderDuration(qint64 duration)
 {
-    m_progressSlider->setRange(0, duration);
+    // CUE 分轨：进度条只覆盖镜像中的这一段
+    const qint64 end = m_segmentEnd > 0 ? qMin(m_segmentEnd, duration) : duration;
+    m_progressSlider->setRange(0, static_cast<int>(qMax<qint64>(0, end - m_segmentStart)));
 }
 
 void MainWindow::sliderPressed()
@@ -1056,7 +1131,7 @@ void MainWindow::sliderPressed()
 
 void MainWindow::sliderReleased()
 {
-    qint64 position = m_progressSlider->value();
+    qint64 position = m_segmentStart + m_progressSlider->value();
 #ifdef QT_MULTIMEDIA_ENABLED
     m_player->setPosition(position);
 #else
@@ -1069,7 +1144,14 @@ void MainWindow::sliderReleased()
     if (m_playlistWindow) {
         QTimer *lyricTimer = m_playlistWindow->findChild<QTimer*>("lyricsUpdateTimer");
         if (lyricTimer) {
-            lyricTimer->start(100);
+            // 暂停中拖动只刷新一次歌词，恢复播放时 PlayList 会重新启动定时器
+#ifdef QT_MULTIMEDIA_ENABLED
+            const bool playing = m_player->playbackState() == QMediaPlayer::PlayingState;
+#else
+            const bool playing = true;
+#endif
+            if (playing)
+                lyricTimer->start(100);
             QMetaObject::invokeMethod(m_playlistWindow, "updateLyrics", Qt::DirectConnection);
         }
     }
@@ -1085,6 +1167,19 @@ void MainWindow::decreaseVolume()
     m_volumeSlider->setValue(qMax(m_volumeSlider->value() - 15, 0));
 }
 
+void MainWindow::toggleShuffle()
+{
+    m_shuffleMode = !m_shuffleMode;
+    if (m_playlistWindow) {
+        m_playlistWindow->setShuffle(m_shuffleMode);
+    }
+    if (m_currentLyricLabel) {
+        m_currentLyricLabel->setText(m_shuffleMode ? "随机播放（同一歌手错开）" : "顺序播放");
+        m_currentLyricLabel->adjustSize();
+        m_currentLyricLabel->fadeIn();
+    }
+}
+
 // ============================================================
 // 皮肤变化回调
 // ============================================================
@@ -55,6 +55,7 @@ private slots:
     void sliderReleased();
     void increaseVolume();
     void decreaseVolume();
+    void toggleShuffle();
 
     // 皮肤相关槽函数
     void onSkinChanged(const QString& skinName);
@@ -62,6 +63,8 @@ private slots:
     // 供 PlayList 通过 invokeMethod 调用
     Q_INVOKABLE void setupHoverPressedIcon(QPushButton *button, const QPixmap &normalPixmap,
                                           const QPixmap &hoverPixmap, const QPixmap &pressedPixmap);
+    // 进度条只显示音源中的 [startMs, endMs) 一段（CUE 分轨）；endMs 为 0 表示到末尾，(0, 0) 为整首
+    Q_INVOKABLE void setPlaybackSegment(qint64 startMs, qint64 endMs);
 
 private:
     // UI 初始化与重建
@@ -76,6 +79,9 @@ private:
     QPixmap roundPixmap(const QPixmap &pixmap, int radius);
     void addPlaylist(const QString &filePath);
 
+    // 切歌时更新进度条背后的波形概览（未就绪时先清空，后台生成后再显示）
+    void showWaveform(const QString &filePath);
+
     // 播放按钮图标切换
     void switchToPauseIcon();
     void switchToPlayIcon();
@@ -109,6 +115,9 @@ private:
     int m_currentIndex;
     bool m_shuffleMode;
     QString m_currentPlayingPath;
+    QString m_waveformPath;       // 进度条当前应显示其波形的歌曲
+    qint64 m_segmentStart;        // 正在播放的 CUE 分轨在镜像中的起止（毫秒），普通歌曲为 0
+    qint64 m_segmentEnd;
 
     // Drag support
     bool m_dragging;
@@ -121,6 +130,7 @@ private:
     QShortcut *m_spaceShortcut;
     QShortcut *m_upShortcut;
     QShortcut *m_downShortcut;
+    QShortcut *m_shuffleShortcut;
 
     // Animation
     QPropertyAnimation *m_animation;
@@ -0,0 +1,454 @@
+/*
+ * MediaLibrary 实现
+ */
+#include "medialibrary.h"
+#include "journalframe.h"
+#include "playlistio.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+constexpr quint32 kJournalMagic = 0x54544D4C;   // "TTML"
+constexpr quint16 kJournalVersion = 1;
+
+} // namespace
+
+QString MediaLibrary::Track::displayName() const
+{
+    if (title.isEmpty()) {
+        return QFileInfo(path).completeBaseName();
+    }
+    return artist.isEmpty() ? title : artist + " - " + title;
+}
+
+MediaLibrary& MediaLibrary::instance()
+{
+    static MediaLibrary inst;
+    return inst;
+}
+
+MediaLibrary::MediaLibrary(QObject* parent)
+    : QObject(parent)
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (base.isEmpty()) {
+        base = QDir::tempPath();
+    }
+    QDir().mkpath(base);
+    m_journalPath = QDir(base).filePath("library.db");
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!load()) {
+        // 首次运行：导入旧版播放列表（相对当前目录，与旧版本的读写位置一致）
+        importPlaylistFile("play_list.txt");
+    }
+    qDebug() << "[MediaLibrary] 已载入" << m_liveCount << "首歌曲, 用时" << timer.elapsed() << "ms";
+}
+
+MediaLibrary::~MediaLibrary()
+{
+    shutdown();
+}
+
+void MediaLibrary::shutdown()
+{
+    if (m_journalRecords >= kCompactMinRecords && m_journalRecords > 2 * m_liveCount) {
+        compact();
+    } else if (m_journal.isOpen()) {
+        m_journal.flush();
+    }
+}
+
+QStringList MediaLibrary::paths() const
+{
+    QStringList result;
+    result.reserve(m_liveCount);
+    for (const Track& track : m_tracks) {
+        if (!track.path.isEmpty()) {
+            result.append(track.path);
+        }
+    }
+    return result;
+}
+
+std::vector<int> MediaLibrary::liveSlots() const
+{
+    std::vector<int> result;
+    result.reserve(static_cast<size_t>(m_liveCount));
+    for (size_t i = 0; i < m_tracks.size(); ++i) {
+        if (!m_tracks[i].path.isEmpty()) {
+            result.push_back(static_cast<int>(i));
+        }
+    }
+    return result;
+}
+
+const MediaLibrary::Track* MediaLibrary::track(const QString& filePath) const
+{
+    const auto it = m_index.constFind(filePath);
+    return it == m_index.constEnd() ? nullptr : &m_tracks[*it];
+}
+
+bool MediaLibrary::add(const QString& filePath)
+{
+    return add(QStringList{filePath}) > 0;
+}
+
+int MediaLibrary::add(const QStringList& filePaths)
+{
+    int added = 0;
+    for (const QString& filePath : filePaths) {
+        Track track;
+        if (filePath.isEmpty() || m_index.contains(QFileInfo(filePath).absoluteFilePath())
+            || !statFile(filePath, &track)) {
+            continue;
+        }
+        applyPut(track);
+        appendRecord(PutRecord, track);
+        emit trackAdded(track.path);
+        ++added;
+    }
+    if (added > 0 && m_journal.isOpen()) {
+        m_journal.flush();
+    }
+    return added;
+}
+
+bool MediaLibrary::remove(const QString& filePath)
+{
+    return remove(QStringList{filePath}) > 0;
+}
+
+int MediaLibrary::remove(const QStringList& filePaths)
+{
+    int removed = 0;
+    for (const QString& filePath : filePaths) {
+        if (!m_index.contains(filePath)) {
+            continue;
+        }
+        emit aboutToRemoveTrack(filePath);
+        applyRemove(filePath);
+        Track track;
+        track.path = filePath;
+        appendRecord(RemoveRecord, track);
+        emit trackRemoved(filePath);
+        ++removed;
+    }
+    if (removed > 0 && m_journal.isOpen()) {
+        m_journal.flush();
+    }
+    return removed;
+}
+
+int MediaLibrary::merge(const std::vector<Track>& scanned)
+{
+    int changed = 0;
+    for (const Track& track : scanned) {
+        const Track* existing = this->track(track.path);
+        if (!existing) {
+            applyPut(track);
+            appendRecord(PutRecord, track);
+            emit trackAdded(track.path);
+            ++changed;
+        } else if (!existing->sameFile(track)) {
+            applyPut(track);
+            appendRecord(PutRecord, track);
+            emit fileChanged(track.path);
+            ++changed;
+        } else if (existing->inode != track.inode) {
+            // 旧记录没有 inode：补上，分析结果不变
+            Track stamped = *existing;
+            stamped.inode = track.inode;
+            applyPut(stamped);
+            appendRecord(PutRecord, stamped);
+        }
+    }
+    if (m_journal.isOpen()) {
+        m_journal.flush();
+    }
+    return changed;
+}
+
+bool MediaLibrary::update(const Track& track)
+{
+    return update(std::vector<Track>{track}) > 0;
+}
+
+int MediaLibrary::update(const std::vector<Track>& tracks)
+{
+    int updated = 0;
+    for (const Track& track : tracks) {
+        if (!m_index.contains(track.path)) {
+            continue;
+        }
+        applyPut(track);
+        appendRecord(PutRecord, track);
+        emit trackUpdated(track.path);
+        ++updated;
+    }
+    if (updated > 0 && m_journal.isOpen()) {
+        m_journal.flush();
+    }
+    return updated;
+}
+
+void MediaLibrary::setTempo(const QString& filePath, float bpm, qint32 durationMs)
+{
+    const Track* existing = track(filePath);
+    if (!existing) {
+        return;
+    }
+    Track changed = *existing;
+    changed.bpm = bpm;
+    if (durationMs > 0) {
+        changed.durationMs = durationMs;
+    }
+    update(changed);
+}
+
+void MediaLibrary::setFingerprint(const QString& filePath, quint64 contentHash, const QByteArray& fingerprint,
+                                  qint32 durationMs)
+{
+    const Track* existing = track(filePath);
+    if (!existing) {
+        return;
+    }
+    Track changed = *existing;
+    changed.fingerprinted = true;
+    changed.contentHash = contentHash;
+    changed.fingerprint = fingerprint;
+    if (changed.durationMs <= 0 && durationMs > 0) {
+        changed.durationMs = durationMs;
+    }
+    update(changed);
+}
+
+bool MediaLibrary::applyPut(const Track& track)
+{
+    const auto it = m_index.constFind(track.path);
+    if (it != m_index.constEnd()) {
+        m_tracks[*it] = track;
+        return false;
+    }
+    m_index.insert(track.path, static_cast<int>(m_tracks.size()));
+    m_tracks.push_back(track);
+    ++m_liveCount;
+    return true;
+}
+
+bool MediaLibrary::applyRemove(const QString& filePath)
+{
+    const auto it = m_index.find(filePath);
+    if (it == m_index.end()) {
+        return false;
+    }
+    m_tracks[*it] = Track();   // 墓碑：保持其他记录的下标不变
+    m_index.erase(it);
+    --m_liveCount;
+    return true;
+}
+
+bool MediaLibrary::statFile(const QString& filePath, Track* track)
+{
+    const QFileInfo info(filePath);
+#ifdef Q_OS_UNIX
+    // 一次 stat 拿到全部三项（QFileInfo 不提供 inode）
+    struct stat st;
+    if (::stat(QFile::encodeName(filePath).constData(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    track->path = info.absoluteFilePath();
+    track->size = static_cast<qint64>(st.st_size);
+#ifdef Q_OS_LINUX
+    track->modified = static_cast<qint64>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#else
+    track->modified = static_cast<qint64>(st.st_mtime) * 1000;
+#endif
+    track->inode = static_cast<quint64>(st.st_ino);
+#else
+    if (!info.isFile()) {
+        return false;
+    }
+    track->path = info.absoluteFilePath();
+    track->size = info.size();
+    track->modified = info.lastModified().toMSecsSinceEpoch();
+#endif
+    return true;
+}
+
+QString MediaLibrary::virtualTrackPath(const QString& imagePath, int trackNumber)
+{
+    return imagePath + QString("#%1").arg(trackNumber, 2, 10, QChar('0'));
+}
+
+/**
+ * @brief 日志格式：记录帧见 journalframe.h（magic "TTML"）
+ *   Put 的 payload（QDataStream）：path, size, modified, durationMs, bpm(f32), title, artist, album, inode, tagsLoaded,
+ *   source, startMs, endMs, fingerprinted, contentHash, fingerprint
+ *   （末尾字段可以缺省，读取旧记录时取默认值）
+ *   Remove 的 payload：path
+ */
+bool MediaLibrary::load()
+{
+    QFile file(m_journalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    file.close();
+
+    if (bytes.size() < journal::kHeaderSize || !bytes.startsWith(journal::header(kJournalMagic, kJournalVersion))) {
+        qWarning() << "[MediaLibrary] 无法识别的媒体库文件，重新建立:" << m_journalPath;
+        QFile::remove(m_journalPath);
+        return false;
+    }
+
+    const int offset = journal::decode(bytes, journal::kHeaderSize, [this](quint8 type, const QByteArray& payload) {
+        QDataStream in(payload);
+        in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        Track track;
+        in >> track.path;
+        if (type == PutRecord) {
+            in >> track.size >> track.modified >> track.durationMs >> track.bpm
+               >> track.title >> track.artist >> track.album;
+            if (!in.atEnd()) {
+                in >> track.inode;
+            }
+            if (!in.atEnd()) {
+                in >> track.tagsLoaded;
+            }
+            if (!in.atEnd()) {
+                in >> track.source >> track.startMs >> track.endMs;
+            }
+            if (!in.atEnd()) {
+                in >> track.fingerprinted >> track.contentHash >> track.fingerprint;
+            }
+            if (in.status() == QDataStream::Ok) {
+                applyPut(track);
+            }
+        } else if (type == RemoveRecord) {
+            applyRemove(track.path);
+        }
+        ++m_journalRecords;
+    });
+
+    if (offset < bytes.size()) {
+        qWarning() << "[MediaLibrary] 丢弃日志末尾" << (bytes.size() - offset) << "字节不完整的记录";
+        QFile::resize(m_journalPath, offset);
+    }
+
+    // 去掉墓碑，让内存表保持紧凑
+    if (static_cast<int>(m_tracks.size()) != m_liveCount) {
+        std::vector<Track> live;
+        live.reserve(m_liveCount);
+        m_index.clear();
+        for (Track& track : m_tracks) {
+            if (!track.path.isEmpty()) {
+                m_index.insert(track.path, static_cast<int>(live.size()));
+                live.push_back(std::move(track));
+            }
+        }
+        m_tracks.swap(live);
+    }
+    return true;
+}
+
+/**
+ * @brief 导入旧版 play_list.txt（每行一个路径，UTF-8），只在首次运行时执行
+ */
+void MediaLibrary::importPlaylistFile(const QString& listPath)
+{
+    if (!QFile::exists(listPath)) {
+        return;
+    }
+    // 每行一个路径正是不带 #EXTINF 的 M3U：相对路径、file:// 和非 UTF-8 编码都按 M3U 处理
+    QStringList paths;
+    if (PlaylistIO::read(listPath, [&paths](const PlaylistIO::Entry& entry) { paths.append(entry.path); }) < 0) {
+        return;
+    }
+    const int imported = add(paths);
+    qDebug() << "[MediaLibrary] 已从" << listPath << "导入" << imported << "首歌曲";
+}
+
+bool MediaLibrary::openJournal()
+{
+    if (m_journal.isOpen()) {
+        return true;
+    }
+    m_journal.setFileName(m_journalPath);
+    const bool fresh = !m_journal.exists() || m_journal.size() == 0;
+    if (!m_journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "[MediaLibrary] 无法写入媒体库文件:" << m_journalPath;
+        return false;
+    }
+    if (fresh) {
+        m_journal.write(journal::header(kJournalMagic, kJournalVersion));
+    }
+    return true;
+}
+
+void MediaLibrary::appendRecord(RecordType type, const Track& track)
+{
+    if (!openJournal()) {
+        return;
+    }
+    m_journal.write(encodeRecord(type, track));
+    ++m_journalRecords;
+}
+
+QByteArray MediaLibrary::encodeRecord(RecordType type, const Track& track)
+{
+    QByteArray payload;
+    {
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        out << track.path;
+        if (type == PutRecord) {
+            out << track.size << track.modified << track.durationMs << track.bpm
+                << track.title << track.artist << track.album << track.inode
+                << track.tagsLoaded << track.source << track.startMs << track.endMs
+                << track.fingerprinted << track.contentHash << track.fingerprint;
+        }
+    }
+    return journal::encode(type, payload);
+}
+
+/**
+ * @brief 把日志压缩为只含有效记录的快照（QSaveFile：写完才替换）
+ */
+void MediaLibrary::compact()
+{
+    m_journal.close();
+
+    QSaveFile file(m_journalPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[MediaLibrary] 无法压缩媒体库文件:" << m_journalPath;
+        return;
+    }
+    file.write(journal::header(kJournalMagic, kJournalVersion));
+    int records = 0;
+    for (const Track& track : m_tracks) {
+        if (!track.path.isEmpty()) {
+            file.write(encodeRecord(PutRecord, track));
+            ++records;
+        }
+    }
+
+    if (file.commit()) {
+        qDebug() << "[MediaLibrary] 日志已压缩:" << m_journalRecords << "→" << records << "条记录";
+        m_journalRecords = records;
+    }
+}
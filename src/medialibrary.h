@@ -0,0 +1,213 @@
+/*
+ * MediaLibrary - 媒体库（替代每次改动都整体重写的 play_list.txt）
+ *
+ * 每首歌一条记录：路径、文件大小、修改时间、inode、时长、节拍和标签。
+ * 全部记录常驻内存（按加入顺序排列 + 路径哈希索引），磁盘上是一个只追加的日志文件：
+ *   - 加入 / 更新 / 删除一首歌只在文件末尾追加一条带校验的记录，O(1)
+ *   - 启动时顺序读一遍日志即可重建内存表，不对任何文件做 stat
+ *   - 日志中过期记录（被更新或删除的）多于有效记录时，退出前用 QSaveFile 压缩为快照
+ *   - 末尾记录不完整或校验失败（写入途中断电）时截掉，之前的记录不受影响
+ *
+ * 首次运行（尚无日志文件）时从当前目录的 play_list.txt 导入一次，原文件保持不动。
+ * 只在 GUI 线程中使用，无需加锁；后台任务通过排队调用把结果交回 GUI 线程后再写入。
+ *
+ * 使用方式:
+ *   MediaLibrary::instance().add(path);
+ *   QStringList playlist = MediaLibrary::instance().paths();
+ *   const MediaLibrary::Track* track = MediaLibrary::instance().track(path);
+ */
+#ifndef MEDIALIBRARY_H
+#define MEDIALIBRARY_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QFile>
+#include <QByteArray>
+#include <vector>
+
+class MediaLibrary : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 一首歌的库记录
+     */
+    struct Track {
+        QString path;               // 绝对路径，同时是记录的键
+        qint64 size = 0;            // 文件大小（字节）
+        qint64 modified = 0;        // 修改时间（毫秒时间戳）
+        quint64 inode = 0;          // 文件系统 inode，0 表示未知（非 Unix 平台或旧记录）
+        bool tagsLoaded = false;    // 是否已读过标签（读过但文件没有标签时三项均为空）
+        qint32 durationMs = 0;      // 时长，0 表示未知
+        float bpm = -1.0f;          // 节拍速度；-1 表示尚未分析，0 表示分析过但无法估计
+        QString title;
+        QString artist;
+        QString album;
+        // CUE 分轨：整轨镜像中的一段。source 为镜像文件，path 为 virtualTrackPath() 生成的键
+        QString source;             // 空表示普通文件（音频就在 path）
+        qint64 startMs = 0;         // 在镜像中的起点
+        qint64 endMs = 0;           // 在镜像中的终点，0 表示到文件末尾
+        // 查重（DuplicateFinder）：内容哈希与声学指纹
+        bool fingerprinted = false; // 是否已分析（无法解码时两项为空，不再重试）
+        quint64 contentHash = 0;    // 不含标签的音频数据哈希，0 表示未知
+        QByteArray fingerprint;     // 色度指纹，格式见 DuplicateFinder
+
+        bool hasTempo() const { return bpm >= 0.0f; }
+        bool isVirtual() const { return !source.isEmpty(); }
+        QString audioFile() const { return source.isEmpty() ? path : source; }
+
+        // 列表中显示的名字："歌手 - 标题"，缺标题时退回到不含扩展名的文件名
+        QString displayName() const;
+
+        // (inode, size, mtime) 与磁盘上的文件一致时，分析结果仍然有效；任一方 inode 未知时不比较
+        bool sameFile(const Track& other) const
+        {
+            return size == other.size && modified == other.modified
+                   && (inode == 0 || other.inode == 0 || inode == other.inode);
+        }
+    };
+
+    static MediaLibrary& instance();
+
+    int count() const { return m_liveCount; }
+    bool contains(const QString& filePath) const { return m_index.contains(filePath); }
+
+    /**
+     * @brief 按加入顺序返回所有歌曲路径
+     */
+    QStringList paths() const;
+
+    /**
+     * @brief 查找记录；不存在时返回 nullptr。指针在下一次修改媒体库之前有效
+     */
+    const Track* track(const QString& filePath) const;
+
+    /**
+     * @brief 记录在内存表中的槽位；不存在时返回 -1
+     *
+     * 删除只留下墓碑、新歌总是追加到末尾，所以程序运行期间槽位不会变化，
+     * 视图可以只保存槽位（每行 4 字节）而不复制路径。
+     */
+    int slot(const QString& filePath) const { return m_index.value(filePath, -1); }
+    const Track& trackAt(int slot) const { return m_tracks[static_cast<size_t>(slot)]; }
+
+    /**
+     * @brief 按加入顺序返回所有有效槽位
+     */
+    std::vector<int> liveSlots() const;
+
+    /**
+     * @brief 加入一首歌（只 stat 这一个文件并追加一条记录）
+     * @return 新加入返回 true；已在库中或文件不存在返回 false
+     */
+    bool add(const QString& filePath);
+
+    /**
+     * @brief 批量加入，只在最后刷新一次日志
+     * @return 实际新加入的歌曲数
+     */
+    int add(const QStringList& filePaths);
+
+    /**
+     * @brief 合并扫描结果（LibraryScanner 使用），只在最后刷新一次日志
+     *
+     * 新文件直接加入；已有记录的文件内容变化时（sameFile 为 false）整体替换，
+     * 节拍、时长和标签随之清空并发出 fileChanged；只补上了 inode 的记录保留分析结果和标签。
+     * @return 新加入或被替换的歌曲数
+     */
+    int merge(const std::vector<Track>& scanned);
+
+    /**
+     * @brief 从库中删除一首歌（追加一条删除记录）
+     */
+    bool remove(const QString& filePath);
+
+    /**
+     * @brief 批量删除，只在最后刷新一次日志
+     * @return 实际删除的歌曲数
+     */
+    int remove(const QStringList& filePaths);
+
+    /**
+     * @brief 用新内容替换已有记录（以 track.path 为键），不存在时不做任何事
+     */
+    bool update(const Track& track);
+
+    /**
+     * @brief 批量替换（TagReader 使用），只在最后刷新一次日志
+     * @return 实际替换的歌曲数
+     */
+    int update(const std::vector<Track>& tracks);
+
+    /**
+     * @brief 写入节拍分析结果（TempoScanner 使用），时长顺带更新
+     */
+    void setTempo(const QString& filePath, float bpm, qint32 durationMs);
+
+    /**
+     * @brief 写入查重分析结果（DuplicateFinder 使用），未知的时长顺带补上
+     */
+    void setFingerprint(const QString& filePath, quint64 contentHash, const QByteArray& fingerprint, qint32 durationMs);
+
+    /**
+     * @brief 刷新日志；过期记录过多时压缩为快照（程序退出前调用）
+     */
+    void shutdown();
+
+    /**
+     * @brief 读取文件的 (inode, size, mtime) 并填入 track，path 设为绝对路径；可在任意线程调用
+     * @return 不是普通文件时返回 false
+     */
+    static bool statFile(const QString& filePath, Track* track);
+
+    /**
+     * @brief CUE 分轨在库中的键：镜像路径 + "#" + 两位音轨号（不对应磁盘上的文件）
+     */
+    static QString virtualTrackPath(const QString& imagePath, int trackNumber);
+
+signals:
+    void trackAdded(const QString& filePath);               // 新记录总是位于最大的槽位
+    void aboutToRemoveTrack(const QString& filePath);       // 删除前发出，此时槽位仍可查询
+    void trackRemoved(const QString& filePath);
+    void trackUpdated(const QString& filePath);
+    void fileChanged(const QString& filePath);     // 磁盘上的文件被改写，旧的分析结果已清空
+
+private:
+    enum RecordType : quint8 {
+        PutRecord = 1,      // 加入或整体替换一首歌
+        RemoveRecord = 2    // 删除一首歌
+    };
+
+    MediaLibrary(QObject* parent = nullptr);
+    ~MediaLibrary();
+    MediaLibrary(const MediaLibrary&) = delete;
+    MediaLibrary& operator=(const MediaLibrary&) = delete;
+
+    // 读取日志并重建内存表；返回日志文件是否存在
+    bool load();
+    void importPlaylistFile(const QString& listPath);
+
+    // 只修改内存表，不写日志（load 与公开接口共用）
+    bool applyPut(const Track& track);
+    bool applyRemove(const QString& filePath);
+
+    void appendRecord(RecordType type, const Track& track);
+    static QByteArray encodeRecord(RecordType type, const Track& track);
+    bool openJournal();
+    void compact();
+
+    static constexpr int kCompactMinRecords = 1024;   // 日志至少这么长才考虑压缩
+
+    QString m_journalPath;
+    QFile m_journal;                        // 以追加方式保持打开
+    int m_journalRecords = 0;               // 日志中的记录总数（含过期记录）
+
+    std::vector<Track> m_tracks;            // 按加入顺序；被删除的位置 path 为空（墓碑）
+    QHash<QString, int> m_index;            // 路径 → m_tracks 下标
+    int m_liveCount = 0;
+};
+
+#endif // MEDIALIBRARY_H
@@ -8,7 +8,6 @@
  */
 #include <QFile>
 #include <QDebug>
-#include <QDateTime>
 #include <algorithm>
 #include <cmath>
 
@@ -28,11 +27,9 @@ MP3Decoder::MP3Decoder(QObject* parent)
     : QThread(parent),
       m_currentPosition(0),
       m_sampleRate(0),
-      m_channels(0),
-      m_fft(std::make_unique<FFT>(FFT_SIZE)),
-      m_fftIn(FFT_SIZE)
+      m_channels(0)
 {
-    // FFT 已在初始化列表中创建 (替代原来的 kiss_fft_alloc)
+    // STFT（含 FFT 对象和窗函数）已在成员初始化器中创建
 }
 
 /**
@@ -43,6 +40,60 @@ void MP3Decoder::setSpectrumCallback(SpectrumCallback callback)
     m_spectrumCallback = callback;
 }
 
+/**
+ * @brief 设置 STFT 步长
+ */
+void MP3Decoder::setHopSize(int hopSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_hopSize = qBound(DEFAULT_FFT_SIZE / 8, hopSize, MAX_FFT_SIZE);
+}
+
+/**
+ * @brief 设置 STFT 窗口长度
+ */
+void MP3Decoder::setFftSize(int fftSize)
+{
+    if (fftSize < MIN_FFT_SIZE || fftSize > MAX_FFT_SIZE || (fftSize & (fftSize - 1)) != 0) {
+        qWarning() << "[MP3Decoder] 非法的 FFT 长度:" << fftSize;
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_fftSize = fftSize;
+}
+
+/**
+ * @brief 设置离线模式
+ */
+void MP3Decoder::setOffline(bool offline)
+{
+    QMutexLocker locker(&m_mutex);
+    m_offline = offline;
+}
+
+/**
+ * @brief 设置频谱分析的声道模式
+ */
+void MP3Decoder::setChannelMode(StftAnalyzer::ChannelMode mode)
+{
+    QMutexLocker locker(&m_mutex);
+    m_channelMode = mode;
+}
+
+/**
+ * @brief 激活 / 挂起实时解码
+ */
+void MP3Decoder::setActive(bool active)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_active != active) {
+        m_active = active;
+        // 挂起期间播放位置没有前进，重新激活时从最近一次报告的位置重新外推
+        m_positionClock.start();
+        m_wakeUp.wakeAll();
+    }
+}
+
 /**
  * @brief 析构函数
  * 
@@ -69,7 +120,8 @@ bool MP3Decoder::openFile(const QString& filePath)
 
     m_filePath = filePath;
     m_currentPosition = 0;
-    m_decodedPosition = 0;
+    m_positionClock.start();
+    m_decodedFrames = 0;
 
     QFile file(m_filePath);
     if (!file.open(QIODevice::ReadOnly)) {
@@ -111,12 +163,17 @@ bool MP3Decoder::openFile(const QString& filePath)
  * @param position 播放位置（毫秒）
  *
  * 用于同步解码器的播放位置与媒体播放器的位置。
- * 解码线程会根据这个位置来解码相应的音频帧。
+ * 解码线程从这个位置按经过的时间外推，按音频节奏解码相应的音频帧。
  */
 void MP3Decoder::setPosition(qint64 position)
 {
     QMutexLocker locker(&m_mutex);
-    m_currentPosition = position;
+    // 位置不变时不重启外推时钟：播放器报告位置的粒度可能比调用频率粗
+    if (position != m_currentPosition) {
+        m_currentPosition = position;
+        m_positionClock.start();
+        m_wakeUp.wakeAll();
+    }
 }
 
 /**
@@ -164,63 +221,46 @@ std::vector<float> MP3Decoder::getSpectrumData()
  * 
  * 设置线程停止标志，使解码线程安全退出。
  * 解码线程会在检查到这个标志后结束运行。
- * 同时请求中断线程，确保线程能够及时响应停止请求。
+ * 同时请求中断线程并唤醒挂起中的线程，确保线程能够及时响应停止请求。
  */
 void MP3Decoder::stopDecoding()
 {
     requestInterruption();
+    // 在锁内唤醒：线程在等待前会检查中断标志，不会错过这次唤醒
+    QMutexLocker locker(&m_mutex);
+    m_wakeUp.wakeAll();
 }
 
 /**
- * @brief 使用 FFT 计算音频信号的频谱（防饱和优化版）
- * @param samples 时域样本数据（浮点，归一化到 [-1,1]）
+ * @brief 把一帧解码数据送入 STFT，按固定 hop 输出频谱
+ * @param interleaved 交织 PCM 样本
+ * @param frames 每声道样本数
+ * @param channels 声道数
+ *
+ * 一个 MP3 帧（1152 样本）可能产出 0~N 帧频谱，取决于 hop 大小。
+ * 立体声模式下每帧包含 L/R（或 M/S）两个平面，由一次批量 FFT 得到。
  */
-void MP3Decoder::computeSpectrum(const std::vector<float>& samples)
+void MP3Decoder::computeSpectrum(const mp3d_sample_t* interleaved, int frames, int channels)
 {
-    if (samples.empty() || !m_fft) return;
-
-    const int n = FFT_SIZE;
-    const int halfN = n / 2;
-
-    // 1. 加窗 (Hanning window)
-    for (int i = 0; i < n; ++i) {
-        float sample = (i < static_cast<int>(samples.size())) ? samples[i] : 0.0f;
-        float window = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (n - 1)));
-        m_fftIn[i] = FftComplex(sample * window, 0.0f);
-    }
-
-    // 2. 执行 FFT
-    std::vector<FftComplex> fullOutput(FFT_SIZE);
-    m_fft->forward(m_fftIn, fullOutput);
-
-    // 3. 提取前 N/2 点频谱幅度值（线性，原始值）
-    // 策略：只做最基本的归一化，所有感知映射交给 Spectrumbars 统一处理
-    // 这与 Spectralizer 的做法一致：FFT → 原始幅度 → 回调中处理
-    std::vector<float> normalized(halfN);
-
-    for (int i = 0; i < halfN && i < static_cast<int>(fullOutput.size()); ++i) {
-        float re = fullOutput[i].r;
-        float im = fullOutput[i].i;
-        float mag = std::sqrt(re*re + im*im);
-        normalized[i] = mag;   // 原始 FFT 幅度值，不做任何非线性变换
-    }
-
-    // 4. 线程安全更新
-    {
-        QMutexLocker locker(&m_mutex);
-        m_spectrumData = normalized;
-    }
+    m_stft.push(interleaved, frames, channels, [this](const SpectrumFrame& frame) {
+        // 线程安全更新（assign 复用已有容量，不会重复分配；仅保存第一个平面）
+        {
+            QMutexLocker locker(&m_mutex);
+            m_spectrumData.assign(frame.planes[0], frame.planes[0] + frame.binCount);
+        }
 
-    if (m_spectrumCallback) {
-        m_spectrumCallback(normalized);
-    }
+        if (m_spectrumCallback) {
+            m_spectrumCallback(frame, m_sampleRate);
+        }
+    });
 }
 
 /**
  * @brief 线程执行函数
  * 
  * 在单独的线程中执行MP3解码，生成音频数据和频谱数据。
- * 根据当前播放位置解码相应的音频帧，并通过回调函数通知观察者。
+ * 实时模式下解码游标跟随外推的播放位置连续前进，并通过回调函数通知观察者；
+ * 离线模式从头到尾全速解码。
  */
 void MP3Decoder::run()
 {
@@ -230,47 +270,76 @@ void MP3Decoder::run()
         return;
     }
 
-    qDebug() << "[MP3Decoder] 解码线程开始运行, sampleRate=" << m_sampleRate << "channels=" << m_channels;
+    bool offline;
+    {
+        QMutexLocker locker(&m_mutex);
+        offline = m_offline;
+    }
+
+    qDebug() << "[MP3Decoder] 解码线程开始运行, sampleRate=" << m_sampleRate << "channels=" << m_channels
+             << (offline ? "(离线)" : "");
 
     const size_t maxBufferSize = static_cast<size_t>(m_sampleRate) * 2; // 2秒缓冲
-    const int numBands = 41;
+    const int channels = qMax(1, m_channels);
     mp3d_sample_t buffer[MINIMP3_MAX_SAMPLES_PER_FRAME];
+    std::vector<float> samples;
+    samples.reserve(MINIMP3_MAX_SAMPLES_PER_FRAME);
 
-    // 用于跟踪上次 seek 的位置
-    bool m_isFirstFrame = true;
-    qint64 lastSeekPosition = -1;
-    qint64 lastProcessTime = 0;
+    // 首次进入时跳转到播放位置；离线模式之后不再跳转
+    bool needSeek = true;
     int frameCount = 0;
 
     try {
         while (!isInterruptionRequested()) {
-            // 1. 获取目标位置
-            qint64 targetPos;
+            // 1. 获取播放位置（按上次更新后经过的时间外推）和分析参数
+            qint64 playbackPos;
+            int fftSize;
+            int hopSize;
+            StftAnalyzer::ChannelMode channelMode;
             {
                 QMutexLocker locker(&m_mutex);
-                targetPos = m_currentPosition;
+                // 暂停或不可见时挂起，直到重新激活或被要求退出
+                while (!m_active && !offline && !isInterruptionRequested()) {
+                    m_wakeUp.wait(&m_mutex);
+                }
+                playbackPos = m_currentPosition;
+                if (!offline && m_positionClock.isValid()) {
+                    playbackPos += m_positionClock.elapsed();
+                }
+                fftSize = m_fftSize;
+                hopSize = qMin(m_hopSize, m_fftSize);
+                channelMode = m_channelMode;
+            }
+            if (fftSize != m_stft.fftSize() || hopSize != m_stft.hopSize()
+                || channelMode != m_stft.channelMode()) {
+                m_stft.configure(fftSize, hopSize, channelMode);
             }
 
-            // 2. 判断是否需要跳转（首次或跳转超过100ms）
-            bool shouldSeek = m_isFirstFrame || std::abs(targetPos - lastSeekPosition) > 100;
-
-            // 确保即使位置没有变化，也至少每50ms处理一次新帧
-            qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-            bool shouldProcess = (currentTime - lastProcessTime) > 50;
-
-            if (shouldSeek) {
-                size_t samplePos = static_cast<size_t>(targetPos * static_cast<double>(m_sampleRate) / 1000.0);
-                if (mp3dec_ex_seek(&m_mp3d, samplePos) == 0) {
-                    lastSeekPosition = targetPos;
-                    m_isFirstFrame = false;
-                    lastProcessTime = currentTime;
+            // 2. 按音频节奏解码：解码游标落后于播放位置时连续解码追上，超前时等待；
+            //    只有相差超过阈值（拖动进度、切歌等真正的跳转）才重新 seek 并清空 STFT 历史
+            const qint64 decodedPos = m_decodedFrames * 1000 / m_sampleRate;
+            const qint64 lag = playbackPos - decodedPos;
+            if (needSeek || (!offline && std::abs(lag) > RESYNC_THRESHOLD_MS)) {
+                // 从目标位置之前一个窗口处开始解码（预读）：窗口填满前 STFT 不输出，
+                // 跳转后的第一帧正好落在播放位置上，常数 Q 的长窗口也不会留下一段空白
+                const qint64 targetFrame = qMax<qint64>(0, playbackPos) * m_sampleRate / 1000;
+                const qint64 startFrame = qMax<qint64>(0, targetFrame - (m_stft.fftSize() - m_stft.hopSize()));
+                // mp3dec_ex_seek 的位置按交织样本计数
+                if (mp3dec_ex_seek(&m_mp3d, static_cast<uint64_t>(startFrame) * channels) == 0) {
+                    // 跳转后采样不连续，丢弃滑动窗口中的旧历史
+                    m_stft.reset();
+                    m_decodedFrames = startFrame;
+                    needSeek = false;
                 } else {
-                    qWarning() << "[MP3Decoder] MP3跳转失败:" << targetPos << "ms";
+                    qWarning() << "[MP3Decoder] MP3跳转失败:" << playbackPos << "ms";
+                    QMutexLocker locker(&m_mutex);
+                    m_wakeUp.wait(&m_mutex, MAX_WAIT_MS);
+                    continue;
                 }
-            } else if (shouldProcess) {
-                lastProcessTime = currentTime;
-            } else {
-                msleep(1);
+            } else if (!offline && lag <= 0) {
+                // 已解码到播放位置：等播放追上一帧；位置更新、挂起或停止时会被提前唤醒
+                QMutexLocker locker(&m_mutex);
+                m_wakeUp.wait(&m_mutex, static_cast<unsigned long>(qBound<qint64>(1, -lag + 1, MAX_WAIT_MS)));
                 continue;
             }
 
@@ -278,23 +347,30 @@ void MP3Decoder::run()
             size_t samplesRead = mp3dec_ex_read(&m_mp3d, buffer, MINIMP3_MAX_SAMPLES_PER_FRAME);
 
             if (samplesRead == 0) {
-                // 文件结束
-                msleep(10);
+                // 文件结束（离线模式下线程随之退出）
+                if (offline) {
+                    break;
+                }
+                // 挂起直到播放位置跳回文件中（需要重新 seek）或被要求退出，文件末尾不再空转
+                QMutexLocker locker(&m_mutex);
+                while (!isInterruptionRequested() && m_currentPosition >= decodedPos - RESYNC_THRESHOLD_MS) {
+                    m_wakeUp.wait(&m_mutex);
+                }
                 continue;
             } else if (static_cast<qint64>(samplesRead) < 0) {
                 qWarning() << "[MP3Decoder] MP3解码错误, code=" << samplesRead;
                 break;
             }
+            m_decodedFrames += static_cast<qint64>(samplesRead) / channels;
+
+            // 4. 转换为浮点样本（复用缓冲区）并更新音频缓冲（容量受限，不会无限增长）
+            //    离线模式没有播放端读取音频缓冲，直接跳过
+            if (!offline) {
+                samples.clear();
+                for (size_t i = 0; i < samplesRead; ++i) {
+                    samples.push_back(buffer[i] / 32768.0f);
+                }
 
-            // 4. 转换为浮点样本
-            std::vector<float> samples;
-            samples.reserve(samplesRead);
-            for (size_t i = 0; i < samplesRead; ++i) {
-                samples.push_back(buffer[i] / 32768.0f);
-            }
-
-            // 5. 更新音频缓冲（容量受限，不会无限增长）
-            {
                 QMutexLocker locker(&m_mutex);
                 m_audioData.insert(m_audioData.end(), samples.begin(), samples.end());
                 if (m_audioData.size() > maxBufferSize) {
@@ -303,19 +379,14 @@ void MP3Decoder::run()
                 }
             }
 
-            // 6. 使用 FFT 计算真实频谱
-            computeSpectrum(samples);
+            // 5. 送入 STFT，按固定 hop 计算真实频谱
+            computeSpectrum(buffer, static_cast<int>(samplesRead) / channels, channels);
 
-            // 7. 每 100 帧输出一次日志（约每 2-3 秒）
+            // 6. 每 100 帧输出一次日志（约每 2-3 秒）
             ++frameCount;
             if (frameCount % 100 == 0) {
                 qDebug() << "[MP3Decoder] 已解码" << frameCount << "帧, 正常运行中";
             }
-
-            // 8. 动态休眠，避免CPU占用过高
-            if (m_audioData.size() < maxBufferSize / 2) {
-                msleep(1);
-            }
         }
     } catch (const std::exception& e) {
         qCritical() << "[MP3Decoder] *** 线程异常退出 *** :" << e.what()
@@ -10,6 +10,8 @@
 
 #include <QThread>    // 线程支持
 #include <QMutex>     // 互斥锁
+#include <QWaitCondition> // 挂起 / 唤醒解码线程
+#include <QElapsedTimer>  // 播放位置外推
 #include <QString>    // 字符串处理
 #include <vector>     // 标准向量容器
 #include <functional> // 函数对象
@@ -17,6 +19,7 @@
 #include "minimp3.h"     // 提供 mp3dec_t 等基础类型
 #include "minimp3_ex.h"  // 提供 mp3dec_ex_t 声明
 #include "fft.h"         // 自有 FFT 实现（替代 kissfft）
+#include "stft.h"        // 重叠帧 STFT 分析级
 
 /**
  * @class MP3Decoder
@@ -29,18 +32,70 @@
 class MP3Decoder : public QThread
 {
 public:
-    typedef std::function<void(const std::vector<float>&)> SpectrumCallback;
+    // 频谱回调：frame 含 1~2 个频谱平面（每平面 fftSize()/2 点原始幅度），
+    // sampleRate 为当前文件采样率
+    typedef std::function<void(const SpectrumFrame& frame, int sampleRate)> SpectrumCallback;
 
     MP3Decoder(QObject* parent = nullptr);
     ~MP3Decoder();
 
     bool openFile(const QString& filePath);
+    /**
+     * @brief 报告当前播放位置（毫秒）
+     *
+     * 实时模式下解码线程按音频节奏解码：从最近一次报告的位置按经过的时间外推，
+     * 解码游标始终跟在播放位置上，STFT 的输入连续，频谱帧按 sampleRate / hopSize 均匀产出。
+     * 与外推位置相差超过 RESYNC_THRESHOLD_MS 时视为跳转，重新 seek 并清空 STFT 历史。
+     */
     void setPosition(qint64 position);
     std::vector<float> getAudioData(int numSamples);
     std::vector<float> getSpectrumData();
     void stopDecoding();
     void setSpectrumCallback(SpectrumCallback callback);
 
+    /**
+     * @brief 设置 STFT 步长（样本数）
+     * @param hopSize 推荐 fftSize()/2（50% 重叠）~ fftSize()/4（75% 重叠），超过 FFT 长度时按 FFT 长度处理
+     *
+     * 频谱回调的触发频率 = sampleRate / hopSize，与 MP3 帧长无关。
+     * 可在任意线程调用，解码线程会在下一帧前应用新值。
+     */
+    void setHopSize(int hopSize);
+
+    /**
+     * @brief 设置频谱分析的声道模式
+     * @param mode Mono（下混）/ Stereo（L/R 两个平面）/ MidSide（M/S 两个平面）
+     *
+     * 可在任意线程调用，解码线程会在下一帧前应用新值。
+     */
+    void setChannelMode(StftAnalyzer::ChannelMode mode);
+
+    /**
+     * @brief 设置 STFT 窗口长度（必须是 2 的幂，范围 MIN_FFT_SIZE ~ MAX_FFT_SIZE）
+     *
+     * 常数 Q 分析需要更长的窗口才能分辨低频（见 SpectrumProcessor::fftSizeFor）。
+     * 可在任意线程调用，解码线程会在下一帧前应用新值。
+     */
+    void setFftSize(int fftSize);
+
+    /**
+     * @brief 离线模式：从头到尾尽快解码一遍，不跟随播放位置
+     *
+     * 只在开头 seek 一次，不节流、不休眠、不维护音频缓冲，文件结束后线程退出
+     * （isFinished() 变为 true）。频谱回调可以阻塞以形成背压。
+     * 必须在 openFile() 之前调用。
+     */
+    void setOffline(bool offline);
+
+    /**
+     * @brief 激活 / 挂起实时解码
+     *
+     * 挂起后解码线程阻塞在条件变量上，不再解码也不占用 CPU（暂停播放或可视化不可见时使用）；
+     * 重新激活后立即唤醒，并跳转到最新的播放位置继续解码。离线模式忽略此设置。
+     * 可在任意线程调用。
+     */
+    void setActive(bool active);
+
     int sampleRate() {
         QMutexLocker locker(&m_mutex);
         return m_sampleRate;
@@ -51,30 +106,48 @@ public:
         return m_channels;
     }
 
+    // 频谱回调中幅度谱对应的 FFT 长度（回调给出 fftSize()/2 个 bin）
+    int fftSize() {
+        QMutexLocker locker(&m_mutex);
+        return m_fftSize;
+    }
+
 protected:
     void run() override;
 
 private:
-    static constexpr int FFT_SIZE = 1024;
-    static constexpr int SPECTRUM_BINS = 41;
+    static constexpr int DEFAULT_FFT_SIZE = 1024;
+    static constexpr int MIN_FFT_SIZE = 256;
+    static constexpr int MAX_FFT_SIZE = 8192;
+    static constexpr int DEFAULT_HOP_SIZE = DEFAULT_FFT_SIZE / 2;
+    // 实时模式下解码位置与播放位置相差超过该值才视为跳转（重新 seek 并清空 STFT 历史），
+    // 差距以内连续解码追赶或等待播放追上，STFT 的输入保持连续
+    static constexpr qint64 RESYNC_THRESHOLD_MS = 250;
+    static constexpr unsigned long MAX_WAIT_MS = 50;
 
-    // 使用自有 FFT 替代 kiss_fft_cfg
-    std::unique_ptr<FFT> m_fft;                  // 自有 FFT 对象
-    std::vector<FftComplex> m_fftIn;             // FFT 输入缓冲区
-    void computeSpectrum(const std::vector<float>& timeDomainSamples);
+    // 重叠帧 STFT：下混 → 滑动窗口 → 每 hop 输出一帧频谱（仅解码线程访问）
+    StftAnalyzer m_stft{DEFAULT_FFT_SIZE, DEFAULT_HOP_SIZE};
+    int m_fftSize = DEFAULT_FFT_SIZE;            // 请求的窗口长度（受 m_mutex 保护）
+    int m_hopSize = DEFAULT_HOP_SIZE;            // 请求的步长（受 m_mutex 保护）
+    StftAnalyzer::ChannelMode m_channelMode = StftAnalyzer::Mono;  // 请求的声道模式（受 m_mutex 保护）
+    void computeSpectrum(const mp3d_sample_t* interleaved, int frames, int channels);
 
     QString m_filePath;
     qint64 m_currentPosition = 0;
+    QElapsedTimer m_positionClock;               // 距 m_currentPosition 上次变化的时间（受 m_mutex 保护）
     QMutex m_mutex;
     std::vector<float> m_audioData;
     std::vector<float> m_spectrumData;
     int m_sampleRate = 0;
     int m_channels = 0;
     SpectrumCallback m_spectrumCallback;
+    bool m_offline = false;                      // 离线模式（受 m_mutex 保护）
+    bool m_active = true;                        // 是否需要实时解码（受 m_mutex 保护）
+    QWaitCondition m_wakeUp;                     // 激活、位置变化或停止时唤醒解码线程
 
     QByteArray m_fileData;
     mp3dec_ex_t m_mp3d;
-    qint64 m_decodedPosition = 0;
+    qint64 m_decodedFrames = 0;                  // 解码游标（每声道样本数，仅解码线程访问）
 };
 
 #endif // MP3DECODER_H
@@ -0,0 +1,522 @@
+/*
+ * OfflineRenderer 实现
+ */
+#include "offlinerenderer.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QPainter>
+#include <QRunnable>
+#include <QDebug>
+#include <array>
+#include <cstdio>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "mp3decoder.h"
+#include "spectrumdynamics.h"
+
+namespace {
+
+/**
+ * @brief 解码线程 → 分析（调用）线程的有界频谱帧队列
+ *
+ * 与 SpectrumAnalyzer 的队列不同，这里不能丢帧：队列满时解码线程等待，
+ * 解码速度自动与分析 / 绘制速度匹配。槽位通过 swap 交换，容量稳定后不再分配。
+ */
+class OfflineFrameQueue
+{
+public:
+    struct Frame {
+        std::vector<float> magnitudes;   // planeCount 个平面首尾相接
+        std::vector<FftComplex> bins;    // 同上（仅常数 Q 布局时填充）
+        int binCount = 0;
+        int planeCount = 1;
+        int sampleRate = 0;
+    };
+
+    explicit OfflineFrameQueue(bool wantBins) : m_wantBins(wantBins) {}
+
+    // 解码线程调用：写入一帧，队列满时等待；已中止时直接丢弃
+    void push(const SpectrumFrame& frame, int sampleRate)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_count == kDepth && !m_aborted) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (m_aborted) return;
+
+        Frame& slot = m_slots[(m_head + m_count) % kDepth];
+        const size_t total = static_cast<size_t>(frame.planeCount) * frame.binCount;
+        if (m_wantBins && frame.bins[0]) {
+            slot.magnitudes.clear();
+            slot.bins.resize(total);
+            for (int p = 0; p < frame.planeCount; ++p) {
+                std::copy(frame.bins[p], frame.bins[p] + frame.binCount,
+                          slot.bins.begin() + static_cast<size_t>(p) * frame.binCount);
+            }
+        } else {
+            slot.bins.clear();
+            slot.magnitudes.resize(total);
+            for (int p = 0; p < frame.planeCount; ++p) {
+                std::copy(frame.planes[p], frame.planes[p] + frame.binCount,
+                          slot.magnitudes.begin() + static_cast<size_t>(p) * frame.binCount);
+            }
+        }
+        slot.binCount = frame.binCount;
+        slot.planeCount = frame.planeCount;
+        slot.sampleRate = sampleRate;
+        ++m_count;
+        m_notEmpty.wakeOne();
+    }
+
+    // 调用线程：取出一帧；队列已空且解码结束（或已中止）时返回 false
+    bool pop(Frame& out)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_count == 0 && !m_finished && !m_aborted) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_aborted || m_count == 0) return false;
+
+        std::swap(out, m_slots[m_head]);
+        m_head = (m_head + 1) % kDepth;
+        --m_count;
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    // 解码线程结束时调用
+    void finish()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_finished = true;
+        m_notEmpty.wakeAll();
+    }
+
+    // 出错时调用：唤醒双方，之后 push 丢弃、pop 返回 false
+    void abort()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_aborted = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+private:
+    static constexpr int kDepth = 32;
+
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    std::array<Frame, kDepth> m_slots;
+    int m_head = 0;
+    int m_count = 0;
+    bool m_finished = false;
+    bool m_aborted = false;
+    const bool m_wantBins;
+};
+
+// 解析 "1280x360" 形式的尺寸
+bool parseSize(const QString& text, QSize* size)
+{
+    const QStringList parts = text.toLower().split('x');
+    if (parts.size() != 2) return false;
+    bool okW = false;
+    bool okH = false;
+    const int w = parts[0].toInt(&okW);
+    const int h = parts[1].toInt(&okH);
+    if (!okW || !okH || w < 16 || h < 16 || w > 8192 || h > 8192) return false;
+    *size = QSize(w, h);
+    return true;
+}
+
+} // namespace
+
+// ========== 绘制任务 ==========
+
+/**
+ * @brief 一个视频帧：用渲染器拷贝绘制到 QImage，再交给 OfflineRenderer 写出
+ */
+class OfflineFrameJob : public QRunnable
+{
+public:
+    OfflineFrameJob(OfflineRenderer* owner, const SpectrumRenderer& renderer, int index,
+                    const float* levels, const float* peaks, int barCount, int planeCount)
+        : m_owner(owner), m_renderer(renderer), m_index(index),
+          m_levels(levels, levels + barCount * planeCount),
+          m_peaks(peaks, peaks + barCount * planeCount),
+          m_barCount(barCount), m_planeCount(planeCount)
+    {
+    }
+
+    void run() override
+    {
+        if (m_owner->m_failed.load(std::memory_order_relaxed)) {
+            m_owner->m_inFlight.release();
+            return;
+        }
+
+        // 视频帧需要不透明背景
+        QImage image(m_renderer.size(), QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::black);
+        {
+            QPainter painter(&image);
+            m_renderer.paint(painter, image.rect(), m_levels.data(), m_peaks.data(),
+                             m_barCount, m_planeCount);
+        }
+        m_owner->writeImage(m_index, image);   // 真正写出后由 writeImage 归还在途名额
+    }
+
+private:
+    OfflineRenderer* m_owner;
+    SpectrumRenderer m_renderer;     // 渐变条隐式共享，拷贝不复制像素
+    int m_index;
+    std::vector<float> m_levels;
+    std::vector<float> m_peaks;
+    int m_barCount;
+    int m_planeCount;
+};
+
+// ========== 命令行 ==========
+
+QString OfflineRenderer::usage()
+{
+    return QStringLiteral(
+        "用法: TTPlayer --render <input.mp3> [选项]\n"
+        "  --out <路径>        PNG: 输出目录（默认 <文件名>_frames）; raw: 输出文件，- 表示标准输出（默认）\n"
+        "  --format png|raw    输出格式（默认 png）; raw 为连续的 RGBA8888 帧\n"
+        "  --fps <N>           视频帧率（默认 60）\n"
+        "  --size <W>x<H>      画面尺寸（默认 1280x360）\n"
+        "  --bars <N>          N 柱对数分布（默认 41）\n"
+        "  --octave <N>        1/N 倍频程频带\n"
+        "  --cqt <N>           N 柱常数 Q 分析\n"
+        "  --channels mono|stereo|midside  声道模式（默认 mono）\n"
+        "  --split             双平面时上下分屏（默认左右镜像）\n");
+}
+
+bool OfflineRenderer::parseArguments(const QStringList& arguments, Options* options, QString* error)
+{
+    Options parsed;
+    bool outGiven = false;
+
+    for (int i = 0; i < arguments.size(); ++i) {
+        const QString& arg = arguments[i];
+        const bool hasValue = i + 1 < arguments.size();
+        auto intValue = [&](int minValue, int maxValue, int* out) {
+            bool ok = false;
+            const int value = hasValue ? arguments[++i].toInt(&ok) : 0;
+            if (!ok || value < minValue || value > maxValue) {
+                *error = QStringLiteral("%1 需要 %2~%3 之间的整数").arg(arg).arg(minValue).arg(maxValue);
+                return false;
+            }
+            *out = value;
+            return true;
+        };
+
+        if (arg == "--split") {
+            parsed.stereoLayout = SpectrumRenderer::SplitBars;
+            continue;
+        }
+        if (!arg.startsWith("--")) {
+            *error = QStringLiteral("无法识别的参数: %1").arg(arg);
+            return false;
+        }
+        if (!hasValue) {
+            *error = QStringLiteral("%1 缺少参数值").arg(arg);
+            return false;
+        }
+
+        int value = 0;
+        if (arg == "--render") {
+            parsed.inputPath = arguments[++i];
+        } else if (arg == "--out") {
+            parsed.outputPath = arguments[++i];
+            outGiven = true;
+        } else if (arg == "--format") {
+            const QString format = arguments[++i].toLower();
+            if (format == "png") {
+                parsed.format = Png;
+            } else if (format == "raw" || format == "rgba") {
+                parsed.format = RawRgba;
+            } else {
+                *error = QStringLiteral("不支持的输出格式: %1").arg(format);
+                return false;
+            }
+        } else if (arg == "--fps") {
+            if (!intValue(1, 240, &parsed.fps)) return false;
+        } else if (arg == "--size") {
+            if (!parseSize(arguments[++i], &parsed.size)) {
+                *error = QStringLiteral("--size 需要 <宽>x<高>，例如 1280x360");
+                return false;
+            }
+        } else if (arg == "--bars") {
+            if (!intValue(1, SpectrumProcessor::kMaxBars, &value)) return false;
+            parsed.layout = BandLayout::logarithmic(value);
+        } else if (arg == "--octave") {
+            if (!intValue(1, 24, &value)) return false;
+            parsed.layout = BandLayout::fractionalOctave(value);
+        } else if (arg == "--cqt") {
+            if (!intValue(1, SpectrumProcessor::kMaxBars, &value)) return false;
+            parsed.layout = BandLayout::constantQ(value);
+        } else if (arg == "--channels") {
+            const QString mode = arguments[++i].toLower();
+            if (mode == "mono") {
+                parsed.channelMode = StftAnalyzer::Mono;
+            } else if (mode == "stereo") {
+                parsed.channelMode = StftAnalyzer::Stereo;
+            } else if (mode == "midside" || mode == "ms") {
+                parsed.channelMode = StftAnalyzer::MidSide;
+            } else {
+                *error = QStringLiteral("不支持的声道模式: %1").arg(mode);
+                return false;
+            }
+        } else {
+            *error = QStringLiteral("无法识别的参数: %1").arg(arg);
+            return false;
+        }
+    }
+
+    if (parsed.inputPath.isEmpty()) {
+        *error = QStringLiteral("缺少输入文件（--render <input.mp3>）");
+        return false;
+    }
+    if (!outGiven) {
+        parsed.outputPath = parsed.format == Png
+            ? QFileInfo(parsed.inputPath).completeBaseName() + "_frames"
+            : QStringLiteral("-");
+    }
+    if (parsed.format == Png && parsed.outputPath == "-") {
+        *error = QStringLiteral("PNG 序列不能写到标准输出，请使用 --format raw");
+        return false;
+    }
+
+    *options = parsed;
+    return true;
+}
+
+// ========== 渲染 ==========
+
+OfflineRenderer::OfflineRenderer(const Options& options)
+    : m_options(options)
+{
+    m_renderer.setSize(options.size);
+    m_renderer.setStereoLayout(options.stereoLayout);
+    // 每个线程最多两个在途帧：既能填满线程池，又限制了重排缓冲和内存占用（名额在帧写出后才归还）
+    m_inFlight.release(qMax(2, m_pool.maxThreadCount() * 2));
+}
+
+int OfflineRenderer::run()
+{
+    // 1. 准备输出
+    if (m_options.format == Png) {
+        if (!QDir().mkpath(m_options.outputPath)) {
+            qWarning() << "[OfflineRenderer] 无法创建输出目录:" << m_options.outputPath;
+            return 1;
+        }
+    } else if (m_options.outputPath == "-") {
+#ifdef Q_OS_WIN
+        _setmode(_fileno(stdout), _O_BINARY);   // 避免换行符转换破坏原始帧
+#endif
+        if (!m_output.open(stdout, QIODevice::WriteOnly)) {
+            qWarning() << "[OfflineRenderer] 无法打开标准输出";
+            return 1;
+        }
+    } else {
+        m_output.setFileName(m_options.outputPath);
+        if (!m_output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "[OfflineRenderer] 无法写入:" << m_options.outputPath;
+            return 1;
+        }
+    }
+
+    // 2. 启动离线解码（队列满时解码线程阻塞）
+    const int fftSize = SpectrumProcessor::fftSizeFor(m_options.layout);
+    OfflineFrameQueue queue(m_options.layout.scale == BandLayout::ConstantQ);
+    MP3Decoder decoder;
+    decoder.setOffline(true);
+    decoder.setFftSize(fftSize);
+    decoder.setHopSize(kHopSize);
+    decoder.setChannelMode(m_options.channelMode);
+    decoder.setSpectrumCallback([&queue](const SpectrumFrame& frame, int sampleRate) {
+        queue.push(frame, sampleRate);
+    });
+    // 直接连接：在解码线程退出时执行
+    QObject::connect(&decoder, &QThread::finished, [&queue]() { queue.finish(); });
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    if (!decoder.openFile(m_options.inputPath)) {
+        qWarning() << "[OfflineRenderer] 无法解码:" << m_options.inputPath;
+        return 1;
+    }
+    const int hopSize = qMin(kHopSize, fftSize);
+
+    // 3. 分析并按视频帧时刻推进柱高动态（调用线程，严格按时间顺序）
+    SpectrumProcessor processor(m_options.layout);
+    SpectrumDynamics dynamics;
+    int barCount = SpectrumProcessor::barCountFor(m_options.layout);
+    int planeCount = m_options.channelMode == StftAnalyzer::Mono ? 1 : 2;
+    std::vector<float> targets(static_cast<size_t>(barCount) * planeCount, 0.0f);
+    dynamics.setSlotCount(barCount * planeCount);
+    layoutBars(barCount, planeCount);
+
+    const float frameSeconds = 1.0f / m_options.fps;
+    int videoFrames = 0;
+    qint64 endSample = 0;      // 当前分析窗口末尾对应的采样位置
+    int sampleRate = 0;
+    OfflineFrameQueue::Frame frame;
+
+    while (!m_failed.load() && queue.pop(frame)) {
+        if (processor.configure(frame.sampleRate, frame.binCount * 2)) {
+            qDebug() << "[OfflineRenderer] 频带表已重建, sampleRate=" << frame.sampleRate
+                     << "bars=" << processor.barCount();
+        }
+
+        const size_t second = frame.planeCount > 1 ? frame.binCount : 0;
+        if (processor.needsComplexBins()) {
+            if (frame.bins.empty()) continue;
+            const FftComplex* planes[SpectrumProcessor::kMaxPlanes] = {
+                frame.bins.data(), frame.bins.data() + second
+            };
+            processor.processComplex(planes, frame.planeCount, frame.binCount);
+        } else {
+            if (frame.magnitudes.empty()) continue;
+            const float* planes[SpectrumProcessor::kMaxPlanes] = {
+                frame.magnitudes.data(), frame.magnitudes.data() + second
+            };
+            processor.process(planes, frame.planeCount, frame.binCount);
+        }
+
+        // 第一帧在窗口填满时输出，之后每 hop 一帧
+        endSample = endSample == 0 ? frame.binCount * 2 : endSample + hopSize;
+        sampleRate = frame.sampleRate;
+        const double analysisTime = static_cast<double>(endSample) / sampleRate;
+
+        // 本分析帧之前的视频帧显示上一帧的结果（与实时播放时看到的一致）
+        while (!m_failed.load() && videoFrames * static_cast<double>(frameSeconds) < analysisTime) {
+            dynamics.advance(targets.data(), frameSeconds);
+            submitFrame(videoFrames++, dynamics.levels(), dynamics.peaks(), barCount, planeCount);
+        }
+
+        if (processor.barCount() != barCount || processor.planeCount() != planeCount) {
+            barCount = processor.barCount();
+            planeCount = processor.planeCount();
+            targets.assign(static_cast<size_t>(barCount) * planeCount, 0.0f);
+            dynamics.setSlotCount(barCount * planeCount);
+            dynamics.reset();
+            layoutBars(barCount, planeCount);
+        }
+        for (int plane = 0; plane < planeCount; ++plane) {
+            const float* bars = processor.bars(plane);
+            std::copy(bars, bars + barCount, targets.begin() + static_cast<size_t>(plane) * barCount);
+        }
+    }
+
+    // 4. 收尾：出错时让解码线程尽快退出，然后等待全部帧写出
+    if (m_failed.load()) {
+        queue.abort();
+        decoder.stopDecoding();
+    }
+    decoder.wait();
+    m_pool.waitForDone();
+    if (m_output.isOpen()) {
+        m_output.close();
+    }
+
+    if (m_failed.load()) {
+        QMutexLocker locker(&m_writeMutex);
+        qWarning() << "[OfflineRenderer] 渲染失败:" << m_failure;
+        return 1;
+    }
+
+    const double seconds = elapsed.elapsed() / 1000.0;
+    const double audioSeconds = sampleRate > 0 ? static_cast<double>(endSample) / sampleRate : 0.0;
+    qInfo().noquote() << QStringLiteral("[OfflineRenderer] 完成: %1 帧 (%2 秒音频), 用时 %3 秒, %4 倍实时速度")
+                             .arg(videoFrames)
+                             .arg(audioSeconds, 0, 'f', 1)
+                             .arg(seconds, 0, 'f', 1)
+                             .arg(seconds > 0.0 ? audioSeconds / seconds : 0.0, 0, 'f', 1);
+    return 0;
+}
+
+/**
+ * @brief 把画布宽度平均分给所有柱（镜像布局下两个平面共享宽度），约 1/4 作为间距
+ */
+void OfflineRenderer::layoutBars(int barCount, int planeCount)
+{
+    const bool mirrored = planeCount > 1 && m_options.stereoLayout == SpectrumRenderer::MirroredBars;
+    const int columns = qMax(1, mirrored ? barCount * 2 : barCount);
+    const int stride = qMax(1, m_options.size.width() / columns);
+    const int barWidth = qMax(1, stride - qMax(1, stride / 4));
+    m_renderer.setBarSize(barWidth, stride - barWidth);
+    m_renderer.prepare(planeCount);
+}
+
+void OfflineRenderer::submitFrame(int index, const float* levels, const float* peaks, int barCount, int planeCount)
+{
+    m_inFlight.acquire();
+    m_pool.start(new OfflineFrameJob(this, m_renderer, index, levels, peaks, barCount, planeCount));
+}
+
+/**
+ * @brief 写出一帧（工作线程）
+ *
+ * PNG 每帧独立成文件，直接并行写出；原始帧必须按帧序拼接，
+ * 先完成的帧暂存在重排缓冲中，轮到它时才写出。
+ * 在途名额在帧真正写出（或确定不再写出）时才归还，因此重排缓冲最多容纳在途上限那么多帧。
+ */
+void OfflineRenderer::writeImage(int index, const QImage& image)
+{
+    if (m_options.format == Png) {
+        const QString path = QDir(m_options.outputPath).filePath(QString::asprintf("frame_%06d.png", index));
+        if (!image.save(path, "PNG")) {
+            fail(QStringLiteral("无法写入 %1").arg(path));
+        }
+        m_inFlight.release();
+        return;
+    }
+
+    QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+    QMutexLocker locker(&m_writeMutex);
+    if (m_failed.load()) {
+        // 已失败：帧序无法再接上，不再暂存
+        locker.unlock();
+        m_inFlight.release();
+        return;
+    }
+    m_reorder.emplace(index, std::move(rgba));
+    for (auto it = m_reorder.find(m_nextWrite); it != m_reorder.end(); it = m_reorder.find(m_nextWrite)) {
+        const QImage& next = it->second;
+        const qint64 bytes = next.sizeInBytes();
+        if (m_output.write(reinterpret_cast<const char*>(next.constBits()), bytes) != bytes) {
+            // 在锁内记录失败，之后完成的帧不会再进入重排缓冲；已暂存的帧一并丢弃并归还名额
+            if (!m_failed.exchange(true)) {
+                m_failure = QStringLiteral("写入输出失败: %1").arg(m_output.errorString());
+            }
+            const int parked = static_cast<int>(m_reorder.size());
+            m_reorder.clear();
+            locker.unlock();
+            m_inFlight.release(parked);
+            return;
+        }
+        m_reorder.erase(it);
+        ++m_nextWrite;
+        m_inFlight.release();
+    }
+}
+
+void OfflineRenderer::fail(const QString& message)
+{
+    QMutexLocker locker(&m_writeMutex);
+    if (!m_failed.exchange(true)) {
+        m_failure = message;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * OfflineRenderer - 无窗口的频谱离线渲染（图片序列 / 原始视频帧）
+ *
+ * 把一首歌的频谱柱按固定帧率渲染为 PNG 序列或 RGBA8888 原始帧流，
+ * 不打开窗口、不经过声卡，速度只受 CPU 限制（通常远快于实时）。
+ * 解码、分析、绘制与编码使用和播放时完全相同的代码：
+ *   MP3Decoder（离线模式） → SpectrumProcessor → SpectrumDynamics → SpectrumRenderer
+ *
+ * 流水线:
+ *   - 解码线程：全速解码 + STFT，频谱帧写入有界队列（队列满时阻塞，形成背压）
+ *   - 调用线程：频带映射 / 计权 / 卷积，按视频帧时刻推进柱高动态
+ *     （动态模型有状态，必须按时间顺序逐帧推进）
+ *   - QThreadPool：每个视频帧独立绘制并编码；PNG 由任务直接写文件，
+ *     原始帧经重排缓冲按帧序写出。同时在途的帧数受信号量限制
+ *
+ * 使用方式（命令行）:
+ *   TTPlayer --render song.mp3 --out frames/                     # frames/frame_000000.png ...
+ *   TTPlayer --render song.mp3 --format raw --out - --fps 60 --size 1280x360 \
+ *       | ffmpeg -f rawvideo -pix_fmt rgba -s 1280x360 -r 60 -i - -i song.mp3 out.mp4
+ */
+#ifndef OFFLINERENDERER_H
+#define OFFLINERENDERER_H
+
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QImage>
+#include <QFile>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <atomic>
+#include <map>
+
+#include "spectrumprocessor.h"
+#include "spectrumrenderer.h"
+#include "stft.h"
+
+class OfflineRenderer
+{
+public:
+    enum Format {
+        Png,        // 每帧一个 PNG 文件
+        RawRgba     // 连续的 RGBA8888 原始帧（可直接管道给 ffmpeg）
+    };
+
+    struct Options {
+        QString inputPath;
+        QString outputPath;     // Png：输出目录；RawRgba：输出文件，"-" 表示标准输出
+        Format format = Png;
+        int fps = 60;
+        QSize size{1280, 360};
+        BandLayout layout;
+        StftAnalyzer::ChannelMode channelMode = StftAnalyzer::Mono;
+        SpectrumRenderer::StereoLayout stereoLayout = SpectrumRenderer::MirroredBars;
+    };
+
+    /**
+     * @brief 解析命令行参数（arguments 不含程序名）
+     * @return 参数合法时返回 true；否则 error 给出原因
+     */
+    static bool parseArguments(const QStringList& arguments, Options* options, QString* error);
+
+    // 命令行用法说明
+    static QString usage();
+
+    explicit OfflineRenderer(const Options& options);
+
+    /**
+     * @brief 渲染整首歌曲（阻塞直到全部帧写出）
+     * @return 进程退出码，0 表示成功
+     */
+    int run();
+
+private:
+    friend class OfflineFrameJob;
+
+    /**
+     * @brief 按画布宽度与柱数量设置柱宽和间距，并重建渐变条
+     */
+    void layoutBars(int barCount, int planeCount);
+
+    /**
+     * @brief 以当前柱高提交一个视频帧的绘制任务（阻塞直到有空闲的在途名额）
+     */
+    void submitFrame(int index, const float* levels, const float* peaks, int barCount, int planeCount);
+
+    // 以下在工作线程中调用
+    void writeImage(int index, const QImage& image);
+    void fail(const QString& message);
+
+    static constexpr int kHopSize = 256;        // 分析步长：44.1kHz 下约 172 帧/秒，高于常见视频帧率
+
+    Options m_options;
+    SpectrumRenderer m_renderer;                // 已 prepare 的模板，每个任务持有一份拷贝
+
+    QThreadPool m_pool;
+    QSemaphore m_inFlight;                      // 同时在途（已提交未写出，含重排缓冲中的帧）的帧数上限
+
+    // 原始帧按帧序写出（受 m_writeMutex 保护）
+    QMutex m_writeMutex;
+    QFile m_output;
+    std::map<int, QImage> m_reorder;            // 先完成、尚未轮到写出的帧
+    int m_nextWrite = 0;
+
+    std::atomic<bool> m_failed{false};
+    QString m_failure;                          // 首个错误（受 m_writeMutex 保护）
+};
+
+#endif // OFFLINERENDERER_H
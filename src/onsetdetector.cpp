@@ -0,0 +1,244 @@
+/*
+ * OnsetDetector 实现
+ */
+#include "onsetdetector.h"
+#include "simdkernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float kMinFlux = 0.02f;          // 低于此通量（近乎静音时的噪声起伏）不判定为起始点
+constexpr float kTempoCenterBpm = 120.0f;  // 节拍先验的中心
+constexpr float kTempoSpreadOctaves = 1.0f;
+
+// 去均值后的自相关（按重叠长度归一化）
+double autocorrelation(const float* envelope, int count, double mean, int lag)
+{
+    double sum = 0.0;
+    for (int i = 0; i + lag < count; ++i) {
+        sum += (envelope[i] - mean) * (envelope[i + lag] - mean);
+    }
+    return sum / (count - lag);
+}
+
+} // namespace
+
+bool OnsetDetector::configure(int sampleRate, int fftSize, int hopSize)
+{
+    if (sampleRate <= 0 || fftSize <= 0 || hopSize <= 0) {
+        return false;
+    }
+    if (sampleRate == m_sampleRate && fftSize == m_fftSize && hopSize == m_hopSize) {
+        return false;
+    }
+    m_sampleRate = sampleRate;
+    m_fftSize = fftSize;
+    m_hopSize = hopSize;
+    m_frameRate = static_cast<float>(sampleRate) / hopSize;
+    m_magnitudeScale = 4.0f / fftSize;   // 2/N 单边谱 × Hann 窗相干增益 1/0.5
+
+    // 对数频带边界；低频处相邻边界落在同一 bin 时合并
+    const int binCount = fftSize / 2;
+    const float maxFreq = std::min(kMaxFreq, sampleRate * 0.5f);
+    const float step = std::pow(2.0f, 1.0f / kBandsPerOctave);
+    m_bandEdges.clear();
+    for (float freq = kMinFreq; ; freq *= step) {
+        const int bin = std::clamp(static_cast<int>(std::lround(freq * fftSize / sampleRate)), 1, binCount);
+        if (m_bandEdges.empty() || bin > m_bandEdges.back()) {
+            m_bandEdges.push_back(bin);
+        }
+        if (freq >= maxFreq) break;
+    }
+    if (m_bandEdges.size() < 2) {
+        m_bandEdges = {1, binCount};
+    }
+    const size_t bandCount = m_bandEdges.size() - 1;
+    m_current.assign(bandCount, 0.0f);
+    m_previous.assign(bandCount, 0.0f);
+
+    m_fluxHistory.assign(std::max(4, static_cast<int>(std::lround(kThresholdSeconds * m_frameRate))), 0.0f);
+    m_minGapFrames = std::max(1, static_cast<int>(std::lround(kMinGapSeconds * m_frameRate)));
+
+    const int historyFrames = std::max(1, static_cast<int>(std::lround(kHistorySeconds * m_frameRate)));
+    m_envelopeHistory.assign(historyFrames, 0.0f);
+    m_envelopeScratch.assign(historyFrames, 0.0f);
+    m_tempoInterval = std::max(1, static_cast<int>(std::lround(kTempoIntervalSeconds * m_frameRate)));
+
+    reset();
+    return true;
+}
+
+void OnsetDetector::reset()
+{
+    std::fill(m_previous.begin(), m_previous.end(), 0.0f);
+    m_primed = false;
+
+    std::fill(m_fluxHistory.begin(), m_fluxHistory.end(), 0.0f);
+    m_fluxPos = 0;
+    m_fluxFill = 0;
+    m_fluxSum = 0.0;
+    m_fluxSquares = 0.0;
+
+    m_flux = m_lastFlux = m_prevFlux = 0.0f;
+    m_lastThreshold = m_lastMean = m_lastDeviation = 0.0f;
+    m_sinceOnset = 0;
+    m_onsetStrength = 0.0f;
+
+    m_envelope = 0.0f;
+    std::fill(m_envelopeHistory.begin(), m_envelopeHistory.end(), 0.0f);
+    m_envelopePos = 0;
+    m_envelopeFill = 0;
+    m_sinceTempo = 0;
+    m_tempo = Tempo();
+}
+
+bool OnsetDetector::process(const float* magnitudes)
+{
+    if (!magnitudes || m_bandEdges.size() < 2) {
+        return false;
+    }
+
+    // 1. 频带能量 + 对数压缩
+    const int bandCount = static_cast<int>(m_bandEdges.size()) - 1;
+    for (int band = 0; band < bandCount; ++band) {
+        float sum = 0.0f;
+        for (int bin = m_bandEdges[band]; bin < m_bandEdges[band + 1]; ++bin) {
+            sum += magnitudes[bin];
+        }
+        m_current[band] = std::log1p(kCompression * m_magnitudeScale * sum);
+    }
+
+    // 2. 谱通量（按频带数归一化，与 FFT 长度无关）
+    const float flux = m_primed
+        ? simd::rectifiedFlux(m_current.data(), m_previous.data(), bandCount) / bandCount
+        : 0.0f;
+    std::swap(m_current, m_previous);
+    m_primed = true;
+
+    // 3. 自适应阈值：统计只用之前的帧，避免当前峰值抬高自己的阈值
+    const double mean = m_fluxFill > 0 ? m_fluxSum / m_fluxFill : 0.0;
+    const double variance = m_fluxFill > 0 ? std::max(0.0, m_fluxSquares / m_fluxFill - mean * mean) : 0.0;
+    const float deviation = static_cast<float>(std::sqrt(variance));
+    const float threshold = kThresholdRatio * static_cast<float>(mean) + kSensitivity * deviation;
+
+    const int historySize = static_cast<int>(m_fluxHistory.size());
+    if (m_fluxFill == historySize) {
+        const float oldest = m_fluxHistory[m_fluxPos];
+        m_fluxSum -= oldest;
+        m_fluxSquares -= static_cast<double>(oldest) * oldest;
+    } else {
+        ++m_fluxFill;
+    }
+    m_fluxHistory[m_fluxPos] = flux;
+    m_fluxSum += flux;
+    m_fluxSquares += static_cast<double>(flux) * flux;
+    m_fluxPos = (m_fluxPos + 1) % historySize;
+
+    // 4. 上一帧是局部极大值且超过它当时的阈值 → 起始点
+    bool onset = false;
+    ++m_sinceOnset;
+    if (m_lastFlux > m_prevFlux && m_lastFlux >= flux && m_lastFlux > m_lastThreshold
+        && m_lastFlux > kMinFlux && m_sinceOnset > m_minGapFrames) {
+        onset = true;
+        m_sinceOnset = 0;
+        m_onsetStrength = std::clamp((m_lastFlux - m_lastMean) / (3.0f * m_lastDeviation + 1e-6f), 0.0f, 1.0f);
+    }
+    m_prevFlux = m_lastFlux;
+    m_lastFlux = flux;
+    m_lastThreshold = threshold;
+    m_lastMean = static_cast<float>(mean);
+    m_lastDeviation = deviation;
+    m_flux = flux;
+
+    // 5. 起始强度包络，定期重新估计节拍
+    m_envelope = std::max(0.0f, flux - static_cast<float>(mean));
+    const int envelopeSize = static_cast<int>(m_envelopeHistory.size());
+    m_envelopeHistory[m_envelopePos] = m_envelope;
+    m_envelopePos = (m_envelopePos + 1) % envelopeSize;
+    m_envelopeFill = std::min(m_envelopeFill + 1, envelopeSize);
+
+    if (++m_sinceTempo >= m_tempoInterval) {
+        m_sinceTempo = 0;
+        // 按时间顺序展开环形缓冲（容量在 configure 中已分配）
+        const int oldest = m_envelopeFill < envelopeSize ? 0 : m_envelopePos;
+        for (int i = 0; i < m_envelopeFill; ++i) {
+            m_envelopeScratch[i] = m_envelopeHistory[(oldest + i) % envelopeSize];
+        }
+        const Tempo estimate = estimateTempo(m_envelopeScratch.data(), m_envelopeFill, m_frameRate);
+        if (estimate.bpm > 0.0f) {
+            m_tempo = estimate;
+        }
+    }
+
+    return onset;
+}
+
+/**
+ * @brief 自相关节拍估计
+ *
+ * 每个候选延迟的得分 = 先验权重 × (ac(lag) + 0.5 × ac(2·lag))：
+ * 先验是以 120 BPM 为中心、宽 1 个倍频程的对数高斯，用来在倍速 / 半速之间取舍；
+ * 加上两倍延迟处的自相关可以奖励在整小节上也成立的节拍周期。
+ * 最佳延迟再用抛物线插值细化到亚帧精度。
+ */
+OnsetDetector::Tempo OnsetDetector::estimateTempo(const float* envelope, int count, float frameRate)
+{
+    Tempo result;
+    if (!envelope || count <= 0 || frameRate <= 0.0f) {
+        return result;
+    }
+
+    const int minLag = std::max(1, static_cast<int>(std::floor(60.0f * frameRate / kMaxBpm)));
+    const int maxLag = static_cast<int>(std::ceil(60.0f * frameRate / kMinBpm));
+    if (count < 2 * maxLag + 2) {
+        return result;
+    }
+
+    double mean = 0.0;
+    for (int i = 0; i < count; ++i) {
+        mean += envelope[i];
+    }
+    mean /= count;
+
+    const double energy = autocorrelation(envelope, count, mean, 0);
+    if (energy <= 0.0) {
+        return result;
+    }
+
+    auto score = [&](int lag) {
+        const double bpm = 60.0 * frameRate / lag;
+        const double octaves = std::log2(bpm / kTempoCenterBpm) / kTempoSpreadOctaves;
+        const double weight = std::exp(-0.5 * octaves * octaves);
+        return weight * (autocorrelation(envelope, count, mean, lag)
+                         + 0.5 * autocorrelation(envelope, count, mean, 2 * lag));
+    };
+
+    int bestLag = 0;
+    double best = 0.0;
+    for (int lag = minLag; lag <= maxLag; ++lag) {
+        const double s = score(lag);
+        if (s > best) {
+            best = s;
+            bestLag = lag;
+        }
+    }
+    if (bestLag == 0) {
+        return result;
+    }
+
+    double lag = bestLag;
+    if (bestLag > minLag && bestLag < maxLag) {
+        const double before = score(bestLag - 1);
+        const double after = score(bestLag + 1);
+        const double curvature = before - 2.0 * best + after;
+        if (curvature < 0.0) {
+            lag += std::clamp(0.5 * (before - after) / curvature, -0.5, 0.5);
+        }
+    }
+
+    result.bpm = static_cast<float>(60.0 * frameRate / lag);
+    result.confidence = static_cast<float>(std::clamp(autocorrelation(envelope, count, mean, bestLag) / energy, 0.0, 1.0));
+    return result;
+}
@@ -0,0 +1,120 @@
+/*
+ * OnsetDetector - 谱通量起始点检测与节拍速度估计
+ *
+ * 输入与频谱可视化相同的 STFT 幅度谱（fft.h / stft.h），逐帧处理:
+ *   Step 1: 把 FFT bin 合并为对数分布的频带（每倍频程 6 个，30 Hz ~ 16 kHz），取对数压缩
+ *   Step 2: 谱通量 = 各频带相对上一帧的能量上升量之和（SIMD 半波整流差分）
+ *   Step 3: 自适应阈值（由最近约 0.5 秒通量的均值和标准差得出）+ 局部极大值 → 起始点
+ *   Step 4: 通量超出均值的部分构成起始强度包络，对其做自相关，
+ *           在 60~200 BPM 对应的延迟中取（以 120 BPM 为中心加权后）最强者为节拍速度
+ *
+ * 两种用法:
+ *   - 实时：播放时在分析线程中逐帧 process()，起始点用于视觉节拍脉冲，
+ *           每秒用最近 8 秒的包络重新估计一次 tempo()
+ *   - 离线：TempoScanner 对整首歌逐帧 process() 并收集 envelope()，
+ *           最后对全曲包络调用 estimateTempo()
+ *
+ * 本类不依赖 Qt，也不加锁，由调用方保证单线程使用；process() 不做堆分配。
+ */
+#ifndef ONSETDETECTOR_H
+#define ONSETDETECTOR_H
+
+#include <vector>
+
+class OnsetDetector
+{
+public:
+    static constexpr float kMinBpm = 60.0f;
+    static constexpr float kMaxBpm = 200.0f;
+
+    struct Tempo {
+        float bpm = 0.0f;           // 0 表示尚无可靠估计
+        float confidence = 0.0f;    // 自相关峰值 / 零延迟自相关，0~1
+    };
+
+    /**
+     * @brief 按采样率、FFT 长度和步长重建频带表（参数未变时不做任何事）
+     * @return 频带表是否被重建（重建时同时清空历史）
+     */
+    bool configure(int sampleRate, int fftSize, int hopSize);
+
+    // 清空通量历史、阈值统计和节拍包络（切歌 / 跳转后调用）
+    void reset();
+
+    /**
+     * @brief 处理一帧幅度谱（fftSize / 2 个原始幅度）
+     * @return 是否检测到起始点。局部极大值需要看到下一帧才能确认，因此有一帧延迟
+     */
+    bool process(const float* magnitudes);
+
+    float flux() const { return m_flux; }                   // 本帧谱通量
+    float envelope() const { return m_envelope; }           // 本帧起始强度（通量超出均值的部分）
+    float onsetStrength() const { return m_onsetStrength; } // 最近一次起始点的相对强度，0~1
+    float frameRate() const { return m_frameRate; }         // 每秒处理的帧数
+
+    /**
+     * @brief 实时节拍估计（每秒基于最近 kHistorySeconds 秒的包络更新一次）
+     */
+    Tempo tempo() const { return m_tempo; }
+
+    /**
+     * @brief 对一段起始强度包络做自相关，估计节拍速度
+     * @param envelope 每帧一个值，按时间顺序
+     * @param frameRate 包络的帧率（每秒帧数）
+     * @return 包络短于两个最慢节拍周期时返回 bpm = 0
+     */
+    static Tempo estimateTempo(const float* envelope, int count, float frameRate);
+
+private:
+    static constexpr int kBandsPerOctave = 6;
+    static constexpr float kMinFreq = 30.0f;
+    static constexpr float kMaxFreq = 16000.0f;
+    static constexpr float kCompression = 1000.0f;     // log(1 + λ·x) 的 λ
+    static constexpr float kThresholdSeconds = 0.5f;   // 自适应阈值的统计窗口
+    static constexpr float kThresholdRatio = 1.25f;    // 阈值 = kThresholdRatio × 均值 + kSensitivity × 标准差
+    static constexpr float kSensitivity = 1.5f;
+    static constexpr float kMinGapSeconds = 0.05f;     // 两个起始点之间的最短间隔
+    static constexpr float kHistorySeconds = 8.0f;     // 实时节拍估计使用的包络长度
+    static constexpr float kTempoIntervalSeconds = 1.0f;
+
+    int m_sampleRate = 0;
+    int m_fftSize = 0;
+    int m_hopSize = 0;
+    float m_frameRate = 0.0f;
+    float m_magnitudeScale = 0.0f;          // 原始幅度 → 满幅正弦为 1
+
+    std::vector<int> m_bandEdges;           // bandCount + 1 个 bin 边界
+    std::vector<float> m_current;           // 本帧对数频带能量
+    std::vector<float> m_previous;          // 上一帧对数频带能量
+    bool m_primed = false;                  // 是否已有上一帧
+
+    // 自适应阈值：最近 kThresholdSeconds 秒通量的环形缓冲与滑动和
+    std::vector<float> m_fluxHistory;
+    int m_fluxPos = 0;
+    int m_fluxFill = 0;
+    double m_fluxSum = 0.0;
+    double m_fluxSquares = 0.0;
+
+    // 局部极大值判定（前两帧的通量与阈值）
+    float m_flux = 0.0f;
+    float m_lastFlux = 0.0f;
+    float m_lastThreshold = 0.0f;
+    float m_lastMean = 0.0f;
+    float m_lastDeviation = 0.0f;
+    float m_prevFlux = 0.0f;
+    int m_minGapFrames = 1;
+    int m_sinceOnset = 0;
+    float m_onsetStrength = 0.0f;
+
+    // 实时节拍：起始强度包络的环形缓冲
+    float m_envelope = 0.0f;
+    std::vector<float> m_envelopeHistory;
+    std::vector<float> m_envelopeScratch;   // 按时间顺序展开后交给 estimateTempo
+    int m_envelopePos = 0;
+    int m_envelopeFill = 0;
+    int m_tempoInterval = 1;
+    int m_sinceTempo = 0;
+    Tempo m_tempo;
+};
+
+#endif // ONSETDETECTOR_H
@@ -0,0 +1,192 @@
+/*
+ * PathValidator 实现
+ */
+#include "pathvalidator.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QTimer>
+#include <QDebug>
+
+#include "medialibrary.h"
+
+// ========== 工作任务 ==========
+
+/**
+ * @brief 一批歌曲的存在性检查
+ */
+class ValidateJob : public QRunnable
+{
+public:
+    ValidateJob(const QStringList& filePaths, const QStringList& audioFiles)
+        : m_filePaths(filePaths)
+        , m_audioFiles(audioFiles)
+    {
+    }
+
+    void run() override
+    {
+        PathValidator& validator = PathValidator::instance();
+        QStringList missing;
+
+        QElapsedTimer timer;
+        timer.start();
+        QString lastFile;
+        bool lastExists = true;
+        for (int i = 0; i < m_filePaths.size(); ++i) {
+            if (validator.m_cancel) {
+                return;
+            }
+            // 同一镜像的 CUE 分轨相邻排列，只 stat 一次
+            const QString& audioFile = m_audioFiles.at(i);
+            if (audioFile != lastFile) {
+                lastFile = audioFile;
+                lastExists = QFileInfo::exists(audioFile);
+            }
+            if (!lastExists) {
+                missing.append(m_filePaths.at(i));
+            }
+        }
+        qDebug() << "[PathValidator] 检查" << m_filePaths.size() << "首, 不存在" << missing.size()
+                 << "首, 用时" << timer.elapsed() << "ms";
+
+        const QStringList filePaths = m_filePaths;
+        QMetaObject::invokeMethod(&validator, [filePaths, missing]() {
+            PathValidator::instance().finishJob(filePaths, missing);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QStringList m_filePaths;
+    QStringList m_audioFiles;
+};
+
+// ========== PathValidator ==========
+
+PathValidator& PathValidator::instance()
+{
+    static PathValidator inst;
+    return inst;
+}
+
+PathValidator::PathValidator(QObject* parent)
+    : QObject(parent)
+{
+    // 本地盘上 stat 很快；网络盘上每次都要等一个往返，多几个线程同时等
+    m_pool.setMaxThreadCount(4);
+
+    // 文件又出现了（重新加入、被改写、扫描到）：取消标记；删除的歌不再记着
+    MediaLibrary& library = MediaLibrary::instance();
+    connect(&library, &MediaLibrary::trackAdded, this, [this](const QString& filePath) { setMissing(filePath, false); });
+    connect(&library, &MediaLibrary::fileChanged, this, [this](const QString& filePath) { setMissing(filePath, false); });
+    connect(&library, &MediaLibrary::trackRemoved, this, [this](const QString& filePath) { m_missing.remove(filePath); });
+}
+
+PathValidator::~PathValidator()
+{
+    shutdown();
+}
+
+void PathValidator::shutdown()
+{
+    m_cancel = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void PathValidator::check(const QStringList& filePaths)
+{
+    if (m_cancel || filePaths.isEmpty()) {
+        return;
+    }
+    // 队列为空时直接共享调用方的列表，不复制
+    m_queued.append(filePaths);
+    if (!m_dispatchScheduled) {
+        m_dispatchScheduled = true;
+        QTimer::singleShot(0, this, &PathValidator::dispatch);
+    }
+}
+
+void PathValidator::dispatch()
+{
+    m_dispatchScheduled = false;
+    if (m_cancel) {
+        return;
+    }
+
+    const MediaLibrary& library = MediaLibrary::instance();
+    QStringList batch;
+    QStringList audioFiles;
+    int batches = 0;
+    while (m_queuedNext < m_queued.size() && batches < kDispatchBatches) {
+        const QString& filePath = m_queued.at(m_queuedNext++);
+        if (m_pending.contains(filePath)) {
+            continue;
+        }
+        const MediaLibrary::Track* track = library.track(filePath);
+        if (!track) {
+            continue;
+        }
+        m_pending.insert(filePath);
+        batch.append(filePath);
+        audioFiles.append(track->audioFile());
+        if (batch.size() == kBatchSize) {
+            m_pool.start(new ValidateJob(batch, audioFiles));
+            batch.clear();
+            audioFiles.clear();
+            ++batches;
+        }
+    }
+    if (!batch.isEmpty()) {
+        m_pool.start(new ValidateJob(batch, audioFiles));
+    }
+
+    if (m_queuedNext < m_queued.size()) {
+        m_dispatchScheduled = true;
+        QTimer::singleShot(0, this, &PathValidator::dispatch);
+    } else {
+        m_queued.clear();
+        m_queuedNext = 0;
+    }
+}
+
+void PathValidator::finishJob(const QStringList& filePaths, const QStringList& missing)
+{
+    for (const QString& filePath : filePaths) {
+        m_pending.remove(filePath);
+    }
+    if (m_cancel) {
+        return;
+    }
+
+    const QSet<QString> absent(missing.cbegin(), missing.cend());
+    const MediaLibrary& library = MediaLibrary::instance();
+    for (const QString& filePath : filePaths) {
+        // 检查期间被删除的歌不再标记
+        if (library.contains(filePath)) {
+            setMissing(filePath, absent.contains(filePath));
+        }
+    }
+
+    m_checked += filePaths.size();
+    if (m_pending.isEmpty() && m_queued.isEmpty()) {
+        qDebug() << "[PathValidator] 检查完成:" << m_checked << "首, 不存在" << m_missing.size() << "首";
+        emit checkFinished(m_checked, m_missing.size());
+        m_checked = 0;
+    }
+}
+
+void PathValidator::setMissing(const QString& filePath, bool missing)
+{
+    const bool marked = m_missing.contains(filePath);
+    if (marked == missing) {
+        return;
+    }
+    if (missing) {
+        m_missing.insert(filePath);
+    } else {
+        m_missing.remove(filePath);
+    }
+    emit missingChanged(filePath, missing);
+}
@@ -0,0 +1,91 @@
+/*
+ * PathValidator - 播放列表中文件是否仍然存在的后台检查
+ *
+ * 启动时列表直接从 MediaLibrary 的内存表显示，不对任何文件做 stat；
+ * 之后把全部路径分批交给线程池检查，每批结果排队交回 GUI 线程，
+ * 不存在的歌曲随检查进度在列表中标记出来（不从库中删除：网络盘、移动硬盘可能只是暂时没有挂载）。
+ *   - 网络盘上一次 stat 可能要几十毫秒，检查在多个线程上并行，界面从不等待
+ *   - CUE 分轨检查它的镜像文件
+ *   - 已标记的文件重新出现（加入、改写、扫描到）时取消标记
+ * 播放时才发现文件不存在的歌同样只做标记并跳到下一首；从库中删除只由 LibraryScanner 进行。
+ *
+ * 使用方式:
+ *   PathValidator::instance().check(MediaLibrary::instance().paths());
+ *   connect(&PathValidator::instance(), &PathValidator::missingChanged, ...);
+ *   bool missing = PathValidator::instance().isMissing(path);
+ */
+#ifndef PATHVALIDATOR_H
+#define PATHVALIDATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QSet>
+#include <atomic>
+
+class PathValidator : public QObject
+{
+    Q_OBJECT
+
+public:
+    static PathValidator& instance();
+
+    /**
+     * @brief 排队检查这些歌曲的文件是否存在（已在排队的跳过）
+     *
+     * 只把清单记下来；分批交给线程池的工作在之后的事件循环中分片进行，
+     * 整个播放列表一次交进来也不会让 GUI 线程停顿。
+     */
+    void check(const QStringList& filePaths);
+
+    /**
+     * @brief 最近一次检查时文件不存在
+     */
+    bool isMissing(const QString& filePath) const { return m_missing.contains(filePath); }
+
+    int missingCount() const { return m_missing.size(); }
+
+    /**
+     * @brief 直接标记或取消标记（播放时已经对文件做过 stat，不必再排队检查）
+     */
+    void setMissing(const QString& filePath, bool missing);
+
+    /**
+     * @brief 取消排队中的检查并等待正在运行的任务退出（程序退出前调用）
+     */
+    void shutdown();
+
+signals:
+    void missingChanged(const QString& filePath, bool missing);
+    void checkFinished(int checked, int missing);   // 排队的检查全部完成
+
+private:
+    friend class ValidateJob;
+
+    PathValidator(QObject* parent = nullptr);
+    ~PathValidator();
+    PathValidator(const PathValidator&) = delete;
+    PathValidator& operator=(const PathValidator&) = delete;
+
+    // 把排队的清单分批交给线程池，每次最多 kDispatchBatches 批
+    void dispatch();
+    // 在 GUI 线程中接收一批结果
+    void finishJob(const QStringList& filePaths, const QStringList& missing);
+
+    static constexpr int kBatchSize = 128;      // 每个任务检查的文件数，结果一次交回
+    static constexpr int kDispatchBatches = 8;  // 每轮事件循环最多交出的批数
+
+    QThreadPool m_pool;
+    std::atomic<bool> m_cancel{false};
+
+    // 以下仅 GUI 线程访问
+    QStringList m_queued;                       // 尚未交给线程池的路径
+    int m_queuedNext = 0;
+    bool m_dispatchScheduled = false;
+    QSet<QString> m_pending;                    // 已交给线程池或正在检查
+    QSet<QString> m_missing;
+    int m_checked = 0;                          // 本轮已检查的文件数
+};
+
+#endif // PATHVALIDATOR_H
@@ -1,5 +1,16 @@
 #include "playlist.h"
 #include "mainwindow.h"
+#include "waveformcache.h"
+#include "temposcanner.h"
+#include "medialibrary.h"
+#include "libraryscanner.h"
+#include "tagreader.h"
+#include "playlistmodel.h"
+#include "playlistfiltermodel.h"
+#include "playqueue.h"
+#include "playlistio.h"
+#include "pathvalidator.h"
+#include "duplicatefinder.h"
 #include <QFile>
 #include <QTextStream>
 #include <QFileInfo>
@@ -14,6 +25,10 @@
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QRect>
+#include <QShortcut>
+#include <QKeySequence>
+#include <QMenu>
+#include <QFileDialog>
 #ifdef QT_MULTIMEDIA_ENABLED
 #include <QAudioOutput>
 #endif
@@ -26,6 +41,10 @@ PlayList::PlayList(int x, int y, int width, int height, MainWindow *mainWindow)
       m_height(height),
       m_mainWindow(mainWindow),
       m_dragging(false),
+      m_shuffleEnabled(false),
+      m_segmentStart(0),
+      m_segmentEnd(0),
+      m_startupNext(0),
       m_currentLyricIndex(-1)
 {
     // Enable drag and drop
@@ -51,22 +70,42 @@ void PlayList::initUI()
     
     // Create UI elements
     m_closeBtn = new QPushButton(this);
-    m_songList = new QListWidget(this);
+    m_songList = new QListView(this);
+    m_filterEdit = new QLineEdit(this);
+    m_model = new PlaylistModel(this);
+    m_filter = new PlaylistFilterModel(m_model, this);
+    m_songList->setModel(m_filter);
+    // Every row has the same height, so the view never measures rows it does not show
+    m_songList->setUniformItemSizes(true);
+    m_songList->setEditTriggers(QAbstractItemView::NoEditTriggers);
     
     // Set playlist transparent style
     m_songList->setStyleSheet(
-        "QListWidget {"
+        "QListView {"
         "    background-color: transparent;"
         "    border: none;"
         "}"
-        "QListWidget::item {"
+        "QListView::item {"
         "    background-color: transparent;"
         "    color: white;"
         "}"
-        "QListWidget::item:selected {"
+        "QListView::item:selected {"
         "    background-color: rgba(100, 100, 100, 100);"
         "}"
     );
+
+    // Type-to-filter box: title, artist, album, file/folder name or pinyin initials
+    m_filterEdit->setPlaceholderText("搜索 标题 / 歌手 / 专辑 / 拼音首字母");
+    m_filterEdit->setClearButtonEnabled(true);
+    m_filterEdit->setStyleSheet(
+        "QLineEdit {"
+        "    background-color: rgba(255, 255, 255, 40);"
+        "    border: none;"
+        "    border-radius: 4px;"
+        "    color: white;"
+        "    padding: 0px 4px;"
+        "}"
+    );
     
     // Load background image
     QString backgroundPath = ":/skin/Purple/playlist_skin.bmp";
@@ -88,6 +127,7 @@ void PlayList::initUI()
     
     // Position UI elements
     m_closeBtn->setGeometry(280, 7, 17, 15);
+    m_filterEdit->setGeometry(10, 28, 291, 18);
     m_songList->setGeometry(10, 50, 291, 128);
     
     // Setup close button
@@ -109,18 +149,84 @@ void PlayList::initUI()
     // Start fade-in animation
     startAnimation(0, 1);
     
-    // Load music playlist
-    loadMusicFolder();
+    // Rows come straight from the library's memory table; the background work (existence checks,
+    // tags, waveforms, tempo) is queued once the event loop runs, after the windows are shown
+    QTimer::singleShot(0, this, &PlayList::loadMusicFolder);
+
+    // The model follows the library row by row; only background work is queued here
+    MediaLibrary &library = MediaLibrary::instance();
+    // CUE tracks carry their tags from the sheet and are only a segment of the image: no analysis
+    connect(&library, &MediaLibrary::trackAdded, this, [](const QString &path) {
+        if (MediaLibrary::instance().track(path)->isVirtual()) {
+            return;
+        }
+        TagReader::instance().load(QStringList{path});
+        WaveformCache::instance().prefetch(QStringList{path});
+        TempoScanner::instance().scan(QStringList{path});
+        DuplicateFinder::instance().scan(QStringList{path});
+    });
+    connect(&library, &MediaLibrary::fileChanged, this, [](const QString &path) {
+        if (MediaLibrary::instance().track(path)->isVirtual()) {
+            return;
+        }
+        // Rewritten on disk: the old tags, overview and tempo no longer apply
+        TagReader::instance().load(QStringList{path});
+        WaveformCache::instance().prefetch(QStringList{path});
+        TempoScanner::instance().scan(QStringList{path});
+        DuplicateFinder::instance().scan(QStringList{path});
+    });
     
     // Create lyrics timer with object name for easier access
     m_lyricTimer = new QTimer(this);
     m_lyricTimer->setObjectName("lyricsUpdateTimer");
     connect(m_lyricTimer, &QTimer::timeout, this, &PlayList::updateLyrics);
-    m_lyricTimer->start(100);  // Check lyrics every 100ms
+    m_lyricTimer->setInterval(100);  // Check lyrics every 100ms while playing
+#ifndef QT_MULTIMEDIA_ENABLED
+    m_lyricTimer->start();
+#endif
     
     // Connect signals and slots
     connect(m_closeBtn, &QPushButton::clicked, this, &PlayList::exitAll);
-    connect(m_songList, &QListWidget::itemDoubleClicked, this, &PlayList::selectSong);
+    connect(m_songList, &QListView::doubleClicked, this, [this](const QModelIndex &index) {
+        playRow(index.row());
+    });
+    m_songList->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_songList, &QListView::customContextMenuRequested, this, &PlayList::showContextMenu);
+    // Every keystroke re-queries the search index; no per-row filtering pass
+    connect(m_filterEdit, &QLineEdit::textChanged, m_filter, &PlaylistFilterModel::setFilterText);
+    // Keep the shuffle order in step with the whole list, one row at a time. It follows the
+    // source model, not the filter: typing a filter must not clear the shuffle history,
+    // next/previous just skip songs the filter hides
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &, int first, int last) {
+        for (int row = first; row <= last; ++row) {
+            addToShuffle(row);
+        }
+    });
+    connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex &, int first, int last) {
+        for (int row = first; row <= last; ++row) {
+            m_shuffle.remove(m_model->slot(row));
+        }
+    });
+    connect(m_model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        // Tags arrive after the row: refresh the artist used for spreading
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            addToShuffle(row);
+        }
+    });
+    connect(m_model, &QAbstractItemModel::modelReset, this, &PlayList::rebuildShuffle);
+    connect(m_filterEdit, &QLineEdit::returnPressed, this, [this]() {
+        if (m_filter->rowCount() > 0) {
+            playRow(0);
+        }
+    });
+    QShortcut *findShortcut = new QShortcut(QKeySequence::Find, this);
+    connect(findShortcut, &QShortcut::activated, this, [this]() {
+        m_filterEdit->setFocus();
+        m_filterEdit->selectAll();
+    });
+    QShortcut *clearShortcut = new QShortcut(QKeySequence(Qt::Key_Escape), m_filterEdit);
+    clearShortcut->setContext(Qt::WidgetShortcut);
+    connect(clearShortcut, &QShortcut::activated, m_filterEdit, &QLineEdit::clear);
     
     // Connect to media player signals to handle end of media
 #ifdef QT_MULTIMEDIA_ENABLED
@@ -133,6 +239,37 @@ void PlayList::initUI()
                     QTimer::singleShot(500, this, &PlayList::nextSong);
                 }
             });
+            // Lyrics only move while playing; keep the timer idle otherwise
+            connect(player, &QMediaPlayer::playbackStateChanged, this, [this, player](QMediaPlayer::PlaybackState state) {
+                if (state == QMediaPlayer::PlayingState) {
+                    m_lyricTimer->start();
+                    updateLyrics();
+                } else {
+                    m_lyricTimer->stop();
+                    // Paused or stopped: write the resume point now rather than at the next interval
+                    PlayQueue::instance().savePosition(m_currentPath, qMax<qint64>(0, player->position() - m_segmentStart), true);
+                }
+            });
+            // A source set elsewhere (a file dropped on the main window) is a whole file
+            connect(player, &QMediaPlayer::sourceChanged, this, [this](const QUrl &source) {
+                const MediaLibrary::Track *track = MediaLibrary::instance().track(m_currentPath);
+                const QString playing = source.toLocalFile();
+                if (playing != (track ? track->audioFile() : m_currentPath)) {
+                    m_currentPath = playing;
+                    m_segmentStart = 0;
+                    m_segmentEnd = 0;
+                }
+            });
+            connect(player, &QMediaPlayer::positionChanged, this, [this](qint64 position) {
+                // A CUE track ends inside the image: move on as soon as the next track's start is reached
+                if (m_segmentEnd > 0 && position >= m_segmentEnd) {
+                    m_segmentEnd = 0;
+                    nextSong();
+                    return;
+                }
+                // Resume point for the next start, relative to the track; PlayQueue appends at most one record per few seconds
+                PlayQueue::instance().savePosition(m_currentPath, qMax<qint64>(0, position - m_segmentStart));
+            });
         }
     }
 #endif
@@ -140,57 +277,96 @@ void PlayList::initUI()
 
 void PlayList::loadMusicFolder()
 {
-    m_playlist.clear();
-    
-    QFile file("play_list.txt");
-    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        in.setCodec("UTF-8");
-#endif
-        
-        QStringList validPaths;
-        
-        while (!in.atEnd()) {
-            QString line = in.readLine().trimmed();
-            if (!line.isEmpty()) {
-                // Check if file exists before adding to playlist
-                QFileInfo fileInfo(line);
-                if (fileInfo.exists() && fileInfo.isFile()) {
-                    validPaths.append(line);
-                }
-            }
-        }
-        
-        file.close();
-        
-        // Update the playlist with only valid paths
-        m_playlist = validPaths;
-        
-        // Save the updated playlist file if any invalid paths were removed
-        if (validPaths.size() < m_playlist.size()) {
-            updatePlaylistFile();
+    // The library keeps the playlist in memory; no file is read or stat'ed here. Queueing every
+    // song with the background workers still costs a little per song, so it is spread over
+    // event-loop turns and the window stays responsive however long the playlist is
+    m_startupPaths = MediaLibrary::instance().paths();
+    m_startupNext = 0;
+    // Whether each file still exists is checked in the background; the validator slices its own
+    // queue and missing rows are marked as results arrive
+    PathValidator::instance().check(m_startupPaths);
+    queueStartupSlice();
+}
+
+void PlayList::queueStartupSlice()
+{
+    const int kSliceSize = 512;
+    const MediaLibrary &library = MediaLibrary::instance();
+    const int end = qMin(m_startupNext + kSliceSize, static_cast<int>(m_startupPaths.size()));
+    QStringList paths;
+    paths.reserve(end - m_startupNext);
+    for (; m_startupNext < end; ++m_startupNext) {
+        const QString &path = m_startupPaths.at(m_startupNext);
+        const MediaLibrary::Track *track = library.track(path);
+        if (track && !track->isVirtual()) {
+            paths.append(path);
         }
     }
+
+    // Read tags for tracks that have never been tagged; cached ones come straight from the library
+    TagReader::instance().load(paths);
+    // Build waveform overviews for the whole playlist in the background
+    WaveformCache::instance().prefetch(paths);
+    // Estimate BPM for tracks that have not been scanned yet
+    TempoScanner::instance().scan(paths);
+    // Fingerprint new tracks for duplicate detection; ones analysed before go straight into the index
+    DuplicateFinder::instance().scan(paths);
+
+    if (m_startupNext < m_startupPaths.size()) {
+        QTimer::singleShot(0, this, &PlayList::queueStartupSlice);
+    } else {
+        m_startupPaths.clear();
+        m_startupNext = 0;
+    }
 }
 
 void PlayList::updatePlaylistDisplay()
 {
-    m_songList->clear();
-    for (const QString &path : m_playlist) {
-        // Extract filename without extension
-        QFileInfo fileInfo(path);
-        QString nameWithoutExt = fileInfo.baseName();
-        
-        // Create list item with center alignment
-        QListWidgetItem *item = new QListWidgetItem(nameWithoutExt);
-        item->setTextAlignment(Qt::AlignCenter);
-        
-        // Store the full path as item data for easier access
-        item->setData(Qt::UserRole, path);
-        
-        m_songList->addItem(item);
+    m_model->reload();
+}
+
+int PlayList::songCount() const
+{
+    return m_filter->rowCount();
+}
+
+void PlayList::setShuffle(bool enabled)
+{
+    if (enabled == m_shuffleEnabled) {
+        return;
+    }
+    m_shuffleEnabled = enabled;
+    rebuildShuffle();
+}
+
+void PlayList::rebuildShuffle()
+{
+    const int playing = m_shuffle.current();
+    m_shuffle.clear();
+    if (!m_shuffleEnabled) {
+        return;
+    }
+    const int count = m_model->rowCount();
+    for (int row = 0; row < count; ++row) {
+        addToShuffle(row);
     }
+    // The song being played stays the start of the new order, so it is not drawn again soon
+    const int current = playing >= 0 ? playing : m_filter->slot(m_songList->currentIndex().row());
+    m_shuffle.jumpTo(current);
+}
+
+void PlayList::addToShuffle(int row)
+{
+    if (!m_shuffleEnabled) {
+        return;
+    }
+    const int slot = m_model->slot(row);
+    if (slot < 0) {
+        return;
+    }
+    // Group key for artist spreading; 0 means unknown artist (never spread)
+    const QString artist = MediaLibrary::instance().trackAt(slot).artist;
+    m_shuffle.insert(slot, artist.isEmpty() ? 0u : (static_cast<uint>(qHash(artist.toCaseFolded())) | 1u));
 }
 
 QPropertyAnimation* PlayList::startAnimation(float start, float end)
@@ -224,7 +400,12 @@ void PlayList::dropEvent(QDropEvent *event)
     if (!urls.isEmpty()) {
         for (const QUrl &url : urls) {
             QString filePath = url.toLocalFile();
-            if (filePath.toLower().endsWith(".mp3")) {
+            if (QFileInfo(filePath).isDir()) {
+                // Folders become library roots: scanned in the background and watched from then on
+                LibraryScanner::instance().addRoot(filePath);
+            } else if (PlaylistIO::isPlaylistFile(filePath)) {
+                importPlaylist(filePath);
+            } else if (filePath.toLower().endsWith(".mp3")) {
                 qDebug("Dropped file path: %s", qUtf8Printable(filePath));
                 addPlaylist(filePath);
             } else {
@@ -238,32 +419,12 @@ void PlayList::dropEvent(QDropEvent *event)
 
 void PlayList::addPlaylist(const QString &filePath)
 {
-    QFile file("play_list.txt");
-    if (file.open(QIODevice::ReadWrite | QIODevice::Text)) {
-        // Check if file already contains this path
-        QTextStream in(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        in.setCodec("UTF-8");
-#endif
-        QString content = in.readAll();
-        
-        if (!content.contains(filePath)) {
-            // Append the new path
-            file.seek(file.size());
-            QTextStream out(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-            out.setCodec("UTF-8");
-#endif
-            out << filePath << "\n";
-            qDebug("Added to playlist");
-        } else {
-            qDebug("Already exists in playlist");
-        }
-        
-        file.close();
-        loadMusicFolder();
-        updatePlaylistDisplay();
+    // One appended library record; the model inserts the row
+    if (!MediaLibrary::instance().add(filePath)) {
+        qDebug("Already exists in playlist");
+        return;
     }
+    qDebug("Added to playlist");
 }
 
 QPixmap PlayList::roundPixmap(const QPixmap &pixmap, int radius)
@@ -344,50 +505,74 @@ void PlayList::mouseReleaseEvent(QMouseEvent *event)
     }
 }
 
-void PlayList::selectSong(QListWidgetItem *item)
+void PlayList::playRow(int row)
 {
-    if (!item || !m_mainWindow) {
+    if (!m_mainWindow) {
         return;
     }
     
-    // Get the file path directly from the item data
-    QString filePath = item->data(Qt::UserRole).toString();
+    // Rows are view rows; the filter maps them back to the library record's path
+    QString filePath = m_filter->index(row, 0).data(PlaylistModel::PathRole).toString();
     if (filePath.isEmpty()) {
-        // Fall back to the old method if data is not available
-        int index = m_songList->row(item);
-        if (index >= 0 && index < m_playlist.size()) {
-            filePath = m_playlist[index];
-        } else {
-            return;
-        }
+        return;
     }
-    
+    if (m_shuffleEnabled) {
+        m_shuffle.jumpTo(m_filter->slot(row));
+    }
+    if (!playFile(filePath) && PathValidator::instance().isMissing(filePath)) {
+        // The file is gone: go on to the next song (rows already marked missing are passed over)
+        QTimer::singleShot(0, this, &PlayList::nextSong);
+    }
+}
+
+bool PlayList::playFile(const QString &filePath, qint64 startMs)
+{
+    if (!m_mainWindow) {
+        return false;
+    }
+
+    // A seek still waiting for the previous song to load must not land on this one
+    disconnect(m_pendingSeek);
+
+    // CUE tracks play a segment of their image file
+    const MediaLibrary::Track *track = MediaLibrary::instance().track(filePath);
+    const QString audioFile = track ? track->audioFile() : filePath;
+    const qint64 segmentStart = track ? track->startMs : 0;
+    const qint64 segmentEnd = track ? track->endMs : 0;
+
     // Check if file exists
-    QFileInfo fileInfo(filePath);
+    QFileInfo fileInfo(audioFile);
     if (!fileInfo.exists()) {
         // Show error message in lyrics label
         FadingLabel *lyricLabel = m_mainWindow->findChild<FadingLabel*>();
         if (lyricLabel) {
-            lyricLabel->setText(QString("音频文件不存在: \"%1\"\n请拖入MP3文件播放").arg(filePath));
+            lyricLabel->setText(QString("音频文件不存在: \"%1\"\n请拖入MP3文件播放").arg(audioFile));
             lyricLabel->fadeIn();
         }
         
-        // Remove the non-existent file from the playlist
-        int index = m_songList->row(item);
-        if (index >= 0 && index < m_playlist.size()) {
-            m_playlist.removeAt(index);
-            delete m_songList->takeItem(index);
-            
-            // Update the playlist file
-            updatePlaylistFile();
-        }
-        return;
+        // Keep the library entry (the drive may just be unmounted); the row is marked missing
+        PathValidator::instance().setMissing(filePath, true);
+        return false;
     }
+    PathValidator::instance().setMissing(filePath, false);   // back again (e.g. remounted)
     
 #ifdef QT_MULTIMEDIA_ENABLED
     QMediaPlayer *player = m_mainWindow->findChild<QMediaPlayer*>();
     if (player) {
-        player->setSource(QUrl::fromLocalFile(filePath));
+        // The next track of the same image: seek instead of reloading, so the music does not stop
+        const QUrl source = QUrl::fromLocalFile(audioFile);
+        const bool sameImage = track && track->isVirtual() && player->source() == source
+                               && player->mediaStatus() != QMediaPlayer::InvalidMedia;
+        m_currentPath = filePath;
+        m_segmentStart = segmentStart;
+        m_segmentEnd = segmentEnd;
+        QMetaObject::invokeMethod(m_mainWindow, "setPlaybackSegment", Qt::DirectConnection,
+                                  Q_ARG(qint64, segmentStart), Q_ARG(qint64, segmentEnd));
+        if (sameImage) {
+            player->setPosition(segmentStart + startMs);
+        } else {
+            player->setSource(source);
+        }
 
         // Set volume
         ImageSlider *volumeSlider = m_mainWindow->findChild<ImageSlider*>();
@@ -427,80 +612,327 @@ void PlayList::selectSong(QListWidgetItem *item)
             }
         }
 
-        loadLyrics(filePath, m_mainWindow);
+        // A .lrc next to a CUE image is timed against the whole image, like the player position
+        loadLyrics(audioFile, m_mainWindow);
 
-        // Update the selected item in the list
-        m_songList->setCurrentItem(item);
+        // Resume point or CUE track start: seek once the new source has loaded (earlier seeks are dropped)
+        const qint64 seekTo = segmentStart + startMs;
+        if (!sameImage && seekTo > 0) {
+            m_pendingSeek = connect(player, &QMediaPlayer::mediaStatusChanged, this, [this, player, seekTo](QMediaPlayer::MediaStatus status) {
+                if (status == QMediaPlayer::LoadedMedia || status == QMediaPlayer::BufferedMedia) {
+                    disconnect(m_pendingSeek);
+                    player->setPosition(seekTo);
+                } else if (status == QMediaPlayer::InvalidMedia || status == QMediaPlayer::NoMedia) {
+                    disconnect(m_pendingSeek);   // never loads: nothing to seek
+                }
+            });
+        }
+
+        // Update the selected row in the list (queued songs may be filtered out of view)
+        const int row = m_filter->rowOfSlot(MediaLibrary::instance().slot(filePath));
+        if (row >= 0) {
+            m_songList->setCurrentIndex(m_filter->index(row, 0));
+        }
+        PlayQueue::instance().recordPlayed(filePath);
     }
+    return true;
 #else
-    Q_UNUSED(filePath)
+    Q_UNUSED(startMs)
+    Q_UNUSED(segmentStart)
+    Q_UNUSED(segmentEnd)
+    return false;
 #endif
 }
 
-// Add a new method to update the playlist file
-void PlayList::updatePlaylistFile()
+void PlayList::showContextMenu(const QPoint &pos)
 {
-    QFile file("play_list.txt");
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        out.setCodec("UTF-8");
-#endif
-        
-        for (const QString &path : m_playlist) {
-            out << path << "\n";
+    const int kMenuItems = 20;
+    auto trackName = [](const QString &filePath) {
+        const MediaLibrary::Track *track = MediaLibrary::instance().track(filePath);
+        return track ? track->displayName() : QFileInfo(filePath).completeBaseName();
+    };
+
+    QMenu menu(this);
+    const QString filePath = m_songList->indexAt(pos).data(PlaylistModel::PathRole).toString();
+    if (!filePath.isEmpty()) {
+        menu.addAction("下一首播放", this, [filePath]() { PlayQueue::instance().enqueueNext(filePath); });
+        menu.addAction("添加到播放队列", this, [filePath]() { PlayQueue::instance().enqueueLast(filePath); });
+    }
+
+    // Up next: clicking an entry plays it now and takes it out of the queue
+    const QStringList upNext = PlayQueue::instance().upNext();
+    if (!upNext.isEmpty()) {
+        QMenu *queueMenu = menu.addMenu(QString("接下来播放 (%1)").arg(upNext.size()));
+        for (int i = 0; i < qMin(upNext.size(), kMenuItems); ++i) {
+            const QString queued = upNext.at(i);
+            queueMenu->addAction(trackName(queued), this, [this, i, queued]() {
+                if (PlayQueue::instance().removeAt(i)) {
+                    playFile(queued);
+                }
+            });
         }
-        
-        file.close();
+        queueMenu->addSeparator();
+        queueMenu->addAction("清空播放队列", this, []() { PlayQueue::instance().clear(); });
+    }
+
+    const QStringList history = PlayQueue::instance().history();
+    if (!history.isEmpty()) {
+        QMenu *historyMenu = menu.addMenu("最近播放");
+        for (int i = 0; i < qMin(history.size(), kMenuItems); ++i) {
+            const QString played = history.at(i);
+            historyMenu->addAction(trackName(played), this, [this, played]() { playFile(played); });
+        }
+    }
+
+    // Duplicates: one submenu per group, each version labelled with its folder; clicking plays it
+    const std::vector<QStringList> duplicates = DuplicateFinder::instance().groups();
+    if (!duplicates.empty()) {
+        QMenu *duplicateMenu = menu.addMenu(QString("重复的歌曲 (%1 组)").arg(static_cast<int>(duplicates.size())));
+        for (size_t i = 0; i < qMin(duplicates.size(), static_cast<size_t>(kMenuItems)); ++i) {
+            const QStringList &group = duplicates[i];
+            QMenu *groupMenu = duplicateMenu->addMenu(QString("%1 (%2 个版本)").arg(trackName(group.first())).arg(group.size()));
+            for (const QString &version : group) {
+                const QString folder = QFileInfo(version).dir().dirName();
+                groupMenu->addAction(QString("%1 — %2").arg(trackName(version), folder), this, [this, version]() {
+                    playFile(version);
+                });
+            }
+        }
+    }
+
+    if (m_filter->rowCount() > 0) {
+        menu.addSeparator();
+        menu.addAction("导出播放列表...", this, &PlayList::exportPlaylist);
+    }
+
+    if (!menu.isEmpty()) {
+        menu.exec(m_songList->viewport()->mapToGlobal(pos));
+    }
+}
+
+bool PlayList::resumeLastSession()
+{
+    // The song and position that were playing when the player last closed
+    const PlayQueue &queue = PlayQueue::instance();
+    const MediaLibrary::Track *track = MediaLibrary::instance().track(queue.resumePath());
+    const QString audioFile = track ? track->audioFile() : queue.resumePath();
+    if (audioFile.isEmpty() || !QFileInfo::exists(audioFile)) {
+        return false;
+    }
+    return playFile(queue.resumePath(), queue.resumePosition());
+}
+
+void PlayList::importPlaylist(const QString &playlistPath)
+{
+    const int kBatchSize = 256;
+    MediaLibrary &library = MediaLibrary::instance();
+    const int before = library.count();
+
+    // Entries stream in one at a time and go to the library in batches (one journal flush each)
+    std::vector<MediaLibrary::Track> tracks;
+    QHash<QString, MediaLibrary::Track> images;   // CUE image -> its stat, taken once per image
+    auto flush = [&]() {
+        library.merge(tracks);
+        tracks.clear();
+    };
+    const int entries = PlaylistIO::read(playlistPath, [&](const PlaylistIO::Entry &entry) {
+        if (entry.cueTrack > 0) {
+            auto image = images.find(entry.path);
+            if (image == images.end()) {
+                MediaLibrary::Track stamp;
+                if (!MediaLibrary::statFile(entry.path, &stamp)) {
+                    stamp.path.clear();
+                }
+                image = images.insert(entry.path, stamp);
+            }
+            if (image->path.isEmpty()) {
+                return;   // The image file is missing
+            }
+            // One virtual track per CUE track: the image's stat, the sheet's tags and the segment
+            MediaLibrary::Track track = *image;
+            track.source = image->path;
+            track.path = MediaLibrary::virtualTrackPath(image->path, entry.cueTrack);
+            track.startMs = entry.startMs;
+            track.endMs = entry.endMs;
+            track.durationMs = entry.durationMs;
+            track.title = entry.title;
+            track.artist = entry.artist;
+            track.album = entry.album;
+            track.tagsLoaded = true;
+            tracks.push_back(track);
+        } else {
+            // The #EXTINF / PLS name and length show until the file's own tags are read;
+            // songs already in the library keep their record
+            MediaLibrary::Track track;
+            if (library.contains(entry.path) || !MediaLibrary::statFile(entry.path, &track)) {
+                return;
+            }
+            track.durationMs = entry.durationMs;
+            track.title = entry.title;
+            track.artist = entry.artist;
+            tracks.push_back(track);
+        }
+        if (static_cast<int>(tracks.size()) >= kBatchSize) {
+            flush();
+        }
+    });
+    flush();
+
+    // An image that was in the library as a single song is replaced by its tracks
+    for (auto image = images.cbegin(); image != images.cend(); ++image) {
+        if (!image->path.isEmpty()) {
+            library.remove(image->path);
+        }
+    }
+
+    const int added = qMax(0, library.count() - before);
+    qDebug() << "[PlayList] 导入播放列表" << playlistPath << ":" << entries << "条, 新增" << added << "首";
+    FadingLabel *lyricLabel = m_mainWindow ? m_mainWindow->findChild<FadingLabel*>() : nullptr;
+    if (lyricLabel) {
+        lyricLabel->setText(entries < 0 ? QString("无法打开播放列表: %1").arg(QFileInfo(playlistPath).fileName())
+                                        : QString("已导入播放列表 %1: %2 条, 新增 %3 首")
+                                              .arg(QFileInfo(playlistPath).fileName()).arg(entries).arg(added));
+        lyricLabel->fadeIn();
+    }
+}
+
+void PlayList::exportPlaylist()
+{
+    const QString target = QFileDialog::getSaveFileName(this, "导出播放列表", QDir::home().filePath("playlist.m3u8"),
+                                                        "M3U8 播放列表 (*.m3u8);;PLS 播放列表 (*.pls)");
+    if (target.isEmpty()) {
+        return;
+    }
+
+    // The visible rows, in view order
+    const MediaLibrary &library = MediaLibrary::instance();
+    std::vector<PlaylistIO::Entry> entries;
+    entries.reserve(static_cast<size_t>(m_filter->rowCount()));
+    for (int row = 0; row < m_filter->rowCount(); ++row) {
+        const MediaLibrary::Track &track = library.trackAt(m_filter->slot(row));
+        PlaylistIO::Entry entry;
+        entry.path = track.audioFile();
+        if (track.isVirtual()) {
+            // M3U and PLS cannot address part of a file: a CUE image is written once, under its album
+            if (!entries.empty() && entries.back().path == entry.path) {
+                continue;
+            }
+            entry.title = track.album;
+            entry.artist = track.artist;
+        } else {
+            entry.title = track.title;
+            entry.artist = track.artist;
+            entry.durationMs = track.durationMs;
+        }
+        entries.push_back(entry);
+    }
+
+    const bool written = PlaylistIO::write(target, entries);
+    FadingLabel *lyricLabel = m_mainWindow ? m_mainWindow->findChild<FadingLabel*>() : nullptr;
+    if (lyricLabel) {
+        lyricLabel->setText(written ? QString("已导出 %1 首到 %2").arg(static_cast<int>(entries.size())).arg(QFileInfo(target).fileName())
+                                    : QString("无法写入播放列表: %1").arg(target));
+        lyricLabel->fadeIn();
     }
 }
 
 void PlayList::nextSong()
 {
-    if (m_playlist.isEmpty() || !m_mainWindow) {
+    if (!m_mainWindow) {
+        return;
+    }
+
+    // Songs the user queued come first; missing files are skipped
+    PlayQueue &queue = PlayQueue::instance();
+    while (!queue.isEmpty()) {
+        if (playFile(queue.takeNext())) {
+            return;
+        }
+    }
+
+    const int count = m_filter->rowCount();
+    if (count == 0) {
+        return;
+    }
+
+    if (m_shuffleEnabled) {
+        // Next in the shuffle order: O(1), no repeat until every song has played.
+        // Songs hidden by the filter or marked missing are passed over; two rounds reach a playable one if there is any
+        int row = -1;
+        for (int tries = 2 * m_shuffle.size(); row < 0 && tries > 0; --tries) {
+            row = m_filter->rowOfSlot(m_shuffle.next());
+            if (row >= 0 && m_filter->index(row, 0).data(PlaylistModel::MissingRole).toBool()) {
+                row = -1;
+            }
+        }
+        if (row >= 0) {
+            m_songList->setCurrentIndex(m_filter->index(row, 0));
+            playRow(row);
+        }
         return;
     }
     
     // Get current index
-    int currentIndex = m_songList->currentRow();
+    int currentIndex = m_songList->currentIndex().row();
     if (currentIndex < 0) {
         // No song selected, start with the first one
         currentIndex = 0;
     }
     
-    // Calculate next index (with wrap-around)
-    int nextIndex = (currentIndex + 1) % m_playlist.size();
+    // Calculate next index (with wrap-around), passing over songs marked missing
+    int nextIndex = (currentIndex + 1) % count;
+    for (int tries = count; m_filter->index(nextIndex, 0).data(PlaylistModel::MissingRole).toBool(); nextIndex = (nextIndex + 1) % count) {
+        if (--tries == 0) {
+            return;   // every song is missing
+        }
+    }
     
     // Select the next song
-    m_songList->setCurrentRow(nextIndex);
-    QListWidgetItem *item = m_songList->item(nextIndex);
-    if (item) {
-        selectSong(item);
-    }
+    m_songList->setCurrentIndex(m_filter->index(nextIndex, 0));
+    playRow(nextIndex);
 }
 
 void PlayList::previousSong()
 {
-    if (m_playlist.isEmpty() || !m_mainWindow) {
+    const int count = m_filter->rowCount();
+    if (count == 0 || !m_mainWindow) {
+        return;
+    }
+
+    if (m_shuffleEnabled) {
+        // Back through the shuffle history, passing over songs the filter hides;
+        // nothing before the start of the current round
+        const int playing = m_shuffle.current();
+        int row = -1;
+        for (int slot = m_shuffle.previous(); slot >= 0; slot = m_shuffle.previous()) {
+            row = m_filter->rowOfSlot(slot);
+            if (row >= 0) {
+                break;
+            }
+        }
+        if (row < 0 && playing >= 0) {
+            m_shuffle.jumpTo(playing);   // no visible song before it: stay where we were
+        }
+        if (row >= 0) {
+            m_songList->setCurrentIndex(m_filter->index(row, 0));
+            playRow(row);
+        }
         return;
     }
     
     // Get current index
-    int currentIndex = m_songList->currentRow();
+    int currentIndex = m_songList->currentIndex().row();
     if (currentIndex < 0) {
         // No song selected, start with the last one
         currentIndex = 0;
     }
     
     // Calculate previous index (with wrap-around)
-    int prevIndex = (currentIndex - 1 + m_playlist.size()) % m_playlist.size();
+    int prevIndex = (currentIndex - 1 + count) % count;
     
     // Select the previous song
-    m_songList->setCurrentRow(prevIndex);
-    QListWidgetItem *item = m_songList->item(prevIndex);
-    if (item) {
-        selectSong(item);
-    }
+    m_songList->setCurrentIndex(m_filter->index(prevIndex, 0));
+    playRow(prevIndex);
 }
 
 void PlayList::loadLyrics(const QString &audioPath, MainWindow *mainWindow)
@@ -3,7 +3,8 @@
 
 #include <QWidget>
 #include <QPushButton>
-#include <QListWidget>
+#include <QListView>
+#include <QLineEdit>
 #include <QPropertyAnimation>
 #include <QTimer>
 #ifdef QT_MULTIMEDIA_ENABLED
@@ -11,7 +12,11 @@
 #endif
 #include <QPair>
 
+#include "shufflequeue.h"
+
 class MainWindow;
+class PlaylistModel;
+class PlaylistFilterModel;
 
 class PlayList : public QWidget
 {
@@ -29,6 +34,11 @@ public:
     Q_INVOKABLE void nextSong();
     Q_INVOKABLE void previousSong();
     void addPlaylist(const QString &filePath);
+    int songCount() const;
+    void setShuffle(bool enabled);
+    bool isShuffle() const { return m_shuffleEnabled; }
+    bool resumeLastSession();
+    void importPlaylist(const QString &playlistPath);
 
 protected:
     void mousePressEvent(QMouseEvent *event) override;
@@ -39,17 +49,23 @@ protected:
 
 private slots:
     void exitAll();
-    Q_INVOKABLE void selectSong(QListWidgetItem *item);
+    Q_INVOKABLE void playRow(int row);
 
 private:
     void initUI();
     QPixmap roundPixmap(const QPixmap &pixmap, int radius);
     QList<QPixmap> cropImageIntoFourHorizontal(const QString &imagePath);
-    void updatePlaylistFile();
+    void rebuildShuffle();
+    void addToShuffle(int row);
+    bool playFile(const QString &filePath, qint64 startMs = 0);
+    void showContextMenu(const QPoint &pos);
+    void exportPlaylist();
+    void queueStartupSlice();
 
     // UI Elements
     QPushButton *m_closeBtn;
-    QListWidget *m_songList;
+    QListView *m_songList;
+    QLineEdit *m_filterEdit;
     
     // Window positioning
     int m_x;
@@ -64,8 +80,26 @@ private:
     // Main window reference
     MainWindow *m_mainWindow;
     
-    // Playlist data
-    QStringList m_playlist;
+    // Playlist data (rows are library slots; see PlaylistModel)
+    PlaylistModel *m_model;
+    // What the view shows: the rows of m_model matching the filter box
+    PlaylistFilterModel *m_filter;
+
+    // Shuffle order over every row of m_model (library slots); next/previous skip rows the filter hides
+    ShuffleQueue m_shuffle;
+    bool m_shuffleEnabled;
+
+    // What is playing: the library path (a CUE track's virtual path) and,
+    // for CUE tracks, the segment of the image file it covers (end 0 = to the end)
+    QString m_currentPath;
+    qint64 m_segmentStart;
+    qint64 m_segmentEnd;
+    // Resume point / CUE track start waiting for the current source to load (one at a time)
+    QMetaObject::Connection m_pendingSeek;
+
+    // Startup: the library's paths, handed to the background workers a slice per event-loop turn
+    QStringList m_startupPaths;
+    int m_startupNext;
     
     // Lyrics
     QList<QPair<qint64, QString>> m_lyrics;
@@ -0,0 +1,283 @@
+/*
+ * PlaylistFilterModel 实现
+ */
+#include "playlistfiltermodel.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+
+#include "medialibrary.h"
+#include "playlistmodel.h"
+
+PlaylistFilterModel::PlaylistFilterModel(PlaylistModel* source, QObject* parent)
+    : QAbstractProxyModel(parent)
+    , m_source(source)
+{
+    setSourceModel(source);
+
+    connect(source, &QAbstractItemModel::rowsInserted, this, &PlaylistFilterModel::sourceRowsInserted);
+    connect(source, &QAbstractItemModel::rowsAboutToBeRemoved, this, &PlaylistFilterModel::sourceRowsAboutToBeRemoved);
+    connect(source, &QAbstractItemModel::rowsRemoved, this, &PlaylistFilterModel::sourceRowsRemoved);
+    connect(source, &QAbstractItemModel::dataChanged, this, &PlaylistFilterModel::sourceDataChanged);
+    connect(source, &QAbstractItemModel::modelAboutToBeReset, this, &PlaylistFilterModel::beginResetModel);
+    connect(source, &QAbstractItemModel::modelReset, this, &PlaylistFilterModel::sourceModelReset);
+
+    m_indexTimer.setInterval(0);
+    connect(&m_indexTimer, &QTimer::timeout, this, &PlaylistFilterModel::indexSlice);
+
+    // 空筛选词不需要索引：所有行立即可见，索引在之后的空闲时间里分片建立
+    rebuildRows();
+    startIndexing();
+}
+
+void PlaylistFilterModel::setFilterText(const QString& text)
+{
+    const QString filter = text.trimmed();
+    if (filter == m_filter) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    beginResetModel();
+    m_filter = filter;
+    rebuildRows();
+    endResetModel();
+    qDebug() << "[PlaylistFilter] 筛选" << m_filter << "命中" << m_rows.size() << "/" << m_source->rowCount()
+             << "，用时" << timer.nsecsElapsed() / 1000 << "us";
+}
+
+int PlaylistFilterModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int PlaylistFilterModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+QModelIndex PlaylistFilterModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (parent.isValid() || column != 0 || row < 0 || row >= static_cast<int>(m_rows.size())) {
+        return QModelIndex();
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex PlaylistFilterModel::parent(const QModelIndex& child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+QModelIndex PlaylistFilterModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+    if (!proxyIndex.isValid() || proxyIndex.row() >= static_cast<int>(m_rows.size())) {
+        return QModelIndex();
+    }
+    return m_source->index(m_rows[static_cast<size_t>(proxyIndex.row())]);
+}
+
+QModelIndex PlaylistFilterModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+    if (!sourceIndex.isValid()) {
+        return QModelIndex();
+    }
+    const auto it = std::lower_bound(m_rows.begin(), m_rows.end(), sourceIndex.row());
+    if (it == m_rows.end() || *it != sourceIndex.row()) {
+        return QModelIndex();
+    }
+    return createIndex(static_cast<int>(it - m_rows.begin()), 0);
+}
+
+int PlaylistFilterModel::slot(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_rows.size())) {
+        return -1;
+    }
+    return m_source->slot(m_rows[static_cast<size_t>(row)]);
+}
+
+int PlaylistFilterModel::rowOfSlot(int slot) const
+{
+    const int sourceRow = m_source->rowOfSlot(slot);
+    if (sourceRow < 0) {
+        return -1;
+    }
+    return mapFromSource(m_source->index(sourceRow)).row();
+}
+
+void PlaylistFilterModel::startIndexing()
+{
+    // 只记下槽位（每首 4 字节）；槽位在运行期间不变，之后的插入和删除不影响这份清单
+    const int count = m_source->rowCount();
+    m_unindexed.resize(static_cast<size_t>(count));
+    for (int row = 0; row < count; ++row) {
+        m_unindexed[static_cast<size_t>(row)] = m_source->slot(row);
+    }
+    m_unindexedNext = 0;
+    m_indexClock.start();
+    m_indexTimer.start();
+}
+
+void PlaylistFilterModel::indexSlice()
+{
+    QElapsedTimer slice;
+    slice.start();
+    while (m_unindexedNext < m_unindexed.size() && slice.elapsed() < kIndexSliceMs) {
+        const int slot = m_unindexed[m_unindexedNext++];
+        const int row = m_source->rowOfSlot(slot);
+        if (row < 0) {
+            continue;   // 等待期间已被删除
+        }
+        indexSlot(slot);
+        if (!m_filter.isEmpty()) {
+            updateVisibility(row);
+        }
+    }
+    if (m_unindexedNext < m_unindexed.size()) {
+        return;
+    }
+    m_indexTimer.stop();
+    qDebug() << "[PlaylistFilter] 索引" << m_unindexed.size() << "首歌，用时" << m_indexClock.elapsed() << "ms（分片）";
+    m_unindexed = std::vector<int>();
+    m_unindexedNext = 0;
+}
+
+void PlaylistFilterModel::indexRow(int sourceRow)
+{
+    indexSlot(m_source->slot(sourceRow));
+}
+
+void PlaylistFilterModel::indexSlot(int slot)
+{
+    if (slot < 0) {
+        return;
+    }
+    const MediaLibrary::Track& track = MediaLibrary::instance().trackAt(slot);
+    const QFileInfo info(track.path);
+    m_index.insert(slot, QStringList{track.title, track.artist, track.album,
+                                     info.completeBaseName(), info.dir().dirName()});
+}
+
+bool PlaylistFilterModel::accepts(int sourceRow) const
+{
+    return m_filter.isEmpty() || m_index.matches(m_source->slot(sourceRow), m_filter);
+}
+
+void PlaylistFilterModel::rebuildRows()
+{
+    m_rows.clear();
+    if (m_filter.isEmpty()) {
+        m_rows.resize(static_cast<size_t>(m_source->rowCount()));
+        for (size_t row = 0; row < m_rows.size(); ++row) {
+            m_rows[row] = static_cast<int>(row);
+        }
+        return;
+    }
+    // 槽位与源行同序，命中的槽位升序映射回来仍是升序
+    for (int slot : m_index.query(m_filter)) {
+        const int row = m_source->rowOfSlot(slot);
+        if (row >= 0) {
+            m_rows.push_back(row);
+        }
+    }
+}
+
+void PlaylistFilterModel::sourceRowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    const int count = last - first + 1;
+    const auto position = std::lower_bound(m_rows.begin(), m_rows.end(), first);
+    for (auto it = position; it != m_rows.end(); ++it) {
+        *it += count;
+    }
+
+    std::vector<int> accepted;
+    for (int row = first; row <= last; ++row) {
+        indexRow(row);
+        if (accepts(row)) {
+            accepted.push_back(row);
+        }
+    }
+    if (accepted.empty()) {
+        return;
+    }
+    const int proxyRow = static_cast<int>(position - m_rows.begin());
+    beginInsertRows(QModelIndex(), proxyRow, proxyRow + static_cast<int>(accepted.size()) - 1);
+    m_rows.insert(m_rows.begin() + proxyRow, accepted.begin(), accepted.end());
+    endInsertRows();
+}
+
+void PlaylistFilterModel::sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        m_index.remove(m_source->slot(row));
+    }
+    const auto begin = std::lower_bound(m_rows.begin(), m_rows.end(), first);
+    const auto end = std::upper_bound(begin, m_rows.end(), last);
+    if (begin == end) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), static_cast<int>(begin - m_rows.begin()), static_cast<int>(end - m_rows.begin()) - 1);
+    m_rows.erase(begin, end);
+    endRemoveRows();
+}
+
+void PlaylistFilterModel::sourceRowsRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    const int count = last - first + 1;
+    for (auto it = std::upper_bound(m_rows.begin(), m_rows.end(), last); it != m_rows.end(); ++it) {
+        *it -= count;
+    }
+}
+
+void PlaylistFilterModel::sourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        // 标签读到后标题、歌手才有内容，需要重新索引并重新判断这一行是否可见
+        indexRow(row);
+        updateVisibility(row);
+    }
+}
+
+void PlaylistFilterModel::updateVisibility(int sourceRow)
+{
+    const bool accepted = accepts(sourceRow);
+    const auto it = std::lower_bound(m_rows.begin(), m_rows.end(), sourceRow);
+    const int proxyRow = static_cast<int>(it - m_rows.begin());
+    const bool visible = it != m_rows.end() && *it == sourceRow;
+
+    if (accepted && visible) {
+        const QModelIndex changed = index(proxyRow, 0);
+        emit dataChanged(changed, changed);
+    } else if (accepted) {
+        beginInsertRows(QModelIndex(), proxyRow, proxyRow);
+        m_rows.insert(it, sourceRow);
+        endInsertRows();
+    } else if (visible) {
+        beginRemoveRows(QModelIndex(), proxyRow, proxyRow);
+        m_rows.erase(it);
+        endRemoveRows();
+    }
+}
+
+void PlaylistFilterModel::sourceModelReset()
+{
+    m_index.clear();
+    rebuildRows();
+    endResetModel();
+    startIndexing();
+}
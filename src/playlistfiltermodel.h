@@ -0,0 +1,90 @@
+/*
+ * PlaylistFilterModel - 播放列表的“边打边筛”代理模型
+ *
+ * 夹在 PlaylistModel 和列表视图之间，只保存通过筛选的源行号（升序），查询交给 SearchIndex：
+ * 标题、歌手、专辑、文件名、所在文件夹名做子串匹配，中文还可以按拼音首字母搜（“zjl” → 周杰伦）。
+ * 索引随源模型增量维护：加入一首歌只索引这一首，标签读到后只重新索引变化的那一行，
+ * 不像 QSortFilterProxyModel 那样每改一次筛选词就对每一行调用一遍 filterAcceptsRow。
+ * 启动（和源模型重置）时的全量索引在 GUI 线程的空闲时间里分片进行，每片不超过 kIndexSliceMs；
+ * 空筛选词下所有行本来就可见，索引完成前输入的筛选词先显示已索引部分的结果，其余随索引进度补上。
+ *
+ * 使用方式:
+ *   auto* filter = new PlaylistFilterModel(playlistModel, this);
+ *   listView->setModel(filter);
+ *   filter->setFilterText("晴天");
+ */
+#ifndef PLAYLISTFILTERMODEL_H
+#define PLAYLISTFILTERMODEL_H
+
+#include <QAbstractProxyModel>
+#include <QElapsedTimer>
+#include <QString>
+#include <QTimer>
+#include <vector>
+
+#include "searchindex.h"
+
+class PlaylistModel;
+
+class PlaylistFilterModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistFilterModel(PlaylistModel* source, QObject* parent = nullptr);
+
+    /**
+     * @brief 设置筛选词（空白分隔的多个词需同时命中）；空字符串显示全部
+     */
+    void setFilterText(const QString& text);
+    QString filterText() const { return m_filter; }
+
+    /**
+     * @brief 第 row 行（代理行）对应的媒体库槽位；越界时返回 -1
+     */
+    int slot(int row) const;
+
+    /**
+     * @brief 槽位所在的代理行；被筛掉或不在列表中时返回 -1
+     */
+    int rowOfSlot(int slot) const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+
+private:
+    void indexRow(int sourceRow);
+    void indexSlot(int slot);
+    bool accepts(int sourceRow) const;
+    void rebuildRows();
+    // 重新判断一个源行是否可见，按需插入或移除对应的代理行
+    void updateVisibility(int sourceRow);
+
+    // 分片全量索引
+    void startIndexing();
+    void indexSlice();
+
+    void sourceRowsInserted(const QModelIndex& parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+    void sourceRowsRemoved(const QModelIndex& parent, int first, int last);
+    void sourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+    void sourceModelReset();
+
+    PlaylistModel* m_source;
+    SearchIndex m_index;            // 以媒体库槽位为 id
+    QString m_filter;
+    std::vector<int> m_rows;        // 代理行 → 源行，升序
+
+    static constexpr int kIndexSliceMs = 8;     // 每片最多占用 GUI 线程的时间
+
+    QTimer m_indexTimer;            // 间隔 0：每轮事件循环索引一片
+    QElapsedTimer m_indexClock;     // 全量索引总用时（日志）
+    std::vector<int> m_unindexed;   // 等待全量索引的槽位
+    size_t m_unindexedNext = 0;
+};
+
+#endif // PLAYLISTFILTERMODEL_H
@@ -0,0 +1,363 @@
+/*
+ * PlaylistIO 实现
+ */
+#include "playlistio.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUrl>
+#include <QDebug>
+#include <map>
+
+#include "libraryscanner.h"
+#include "tagreader.h"
+
+namespace {
+
+/**
+ * @brief 逐行读取文本文件：去掉行尾换行和首行的 UTF-8 BOM，无编码声明时逐行识别编码
+ */
+class LineReader
+{
+public:
+    LineReader(QFile& file, bool utf8)
+        : m_file(file)
+        , m_utf8(utf8)
+    {
+    }
+
+    bool next(QString* line)
+    {
+        if (m_file.atEnd()) {
+            return false;
+        }
+        QByteArray bytes = m_file.readLine();
+        if (m_first) {
+            m_first = false;
+            if (bytes.startsWith("\xEF\xBB\xBF")) {
+                bytes.remove(0, 3);
+                m_utf8 = true;   // 有 BOM 的文件整个按 UTF-8 读
+            }
+        }
+        while (!bytes.isEmpty() && (bytes.endsWith('\n') || bytes.endsWith('\r'))) {
+            bytes.chop(1);
+        }
+        *line = (m_utf8 ? QString::fromUtf8(bytes) : TagReader::decodeText(bytes)).trimmed();
+        return true;
+    }
+
+private:
+    QFile& m_file;
+    bool m_utf8;
+    bool m_first = true;
+};
+
+// CUE 的字符串参数：带引号时取引号内的内容，否则取第一个词
+QString unquote(const QString& text)
+{
+    if (text.startsWith('"')) {
+        const int close = text.indexOf('"', 1);
+        return close < 0 ? text.mid(1) : text.mid(1, close - 1);
+    }
+    return text.section(' ', 0, 0);
+}
+
+// CUE 时间 mm:ss:ff，一秒 75 帧
+qint64 parseCueTime(const QString& text)
+{
+    const QStringList parts = text.split(':');
+    if (parts.size() != 3) {
+        return -1;
+    }
+    const qint64 minutes = parts[0].toLongLong();
+    const qint64 seconds = parts[1].toLongLong();
+    const qint64 frames = parts[2].toLongLong();
+    return (minutes * 60 + seconds) * 1000 + frames * 1000 / 75;
+}
+
+} // namespace
+
+bool PlaylistIO::isPlaylistFile(const QString& fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "m3u" || suffix == "m3u8" || suffix == "pls" || suffix == "cue";
+}
+
+int PlaylistIO::read(const QString& playlistPath, const EntrySink& sink)
+{
+    QFile file(playlistPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "[PlaylistIO] 无法打开播放列表:" << playlistPath;
+        return -1;
+    }
+    const QFileInfo info(playlistPath);
+    const QString baseDir = info.absolutePath();
+    const QString suffix = info.suffix().toLower();
+    if (suffix == "pls") {
+        return readPls(file, baseDir, sink);
+    }
+    if (suffix == "cue") {
+        return readCue(file, baseDir, sink);
+    }
+    // 其余（包括旧版 play_list.txt：每行一个路径本来就是合法的 M3U）
+    return readM3u(file, baseDir, suffix == "m3u8", sink);
+}
+
+int PlaylistIO::readM3u(QFile& file, const QString& baseDir, bool utf8, const EntrySink& sink)
+{
+    LineReader reader(file, utf8);
+    QString line;
+    int count = 0;
+    qint32 pendingDuration = 0;
+    QString pendingName;
+    while (reader.next(&line)) {
+        if (line.isEmpty()) {
+            continue;
+        }
+        if (line.startsWith('#')) {
+            // #EXTINF:秒数[ 属性...],歌手 - 标题
+            if (line.startsWith("#EXTINF:", Qt::CaseInsensitive)) {
+                const int comma = line.indexOf(',');
+                const QString info = line.mid(8, comma < 0 ? -1 : comma - 8).trimmed();
+                bool ok = false;
+                const double seconds = info.section(' ', 0, 0).toDouble(&ok);
+                pendingDuration = ok && seconds > 0 ? qRound(seconds * 1000.0) : 0;
+                pendingName = comma < 0 ? QString() : line.mid(comma + 1).trimmed();
+            }
+            continue;
+        }
+
+        Entry entry;
+        entry.path = resolve(baseDir, line);
+        if (!entry.path.isEmpty()) {
+            entry.durationMs = pendingDuration;
+            splitDisplayName(pendingName, &entry);
+            sink(entry);
+            ++count;
+        }
+        pendingDuration = 0;
+        pendingName.clear();
+    }
+    return count;
+}
+
+int PlaylistIO::readPls(QFile& file, const QString& baseDir, const EntrySink& sink)
+{
+    // FileN / TitleN / LengthN 可能分散在任意行，按编号攒齐后在末尾按顺序输出
+    LineReader reader(file, false);
+    std::map<int, Entry> entries;
+    QString line;
+    while (reader.next(&line)) {
+        const int equals = line.indexOf('=');
+        if (equals <= 0) {
+            continue;
+        }
+        const QString key = line.left(equals).trimmed().toLower();
+        const QString value = line.mid(equals + 1).trimmed();
+        bool ok = false;
+        if (key.startsWith("file")) {
+            const int number = key.mid(4).toInt(&ok);
+            if (ok) {
+                entries[number].path = resolve(baseDir, value);
+            }
+        } else if (key.startsWith("title")) {
+            const int number = key.mid(5).toInt(&ok);
+            if (ok) {
+                splitDisplayName(value, &entries[number]);
+            }
+        } else if (key.startsWith("length")) {
+            const int number = key.mid(6).toInt(&ok);
+            const double seconds = value.toDouble();
+            if (ok && seconds > 0) {
+                entries[number].durationMs = qRound(seconds * 1000.0);
+            }
+        }
+    }
+
+    int count = 0;
+    for (const auto& numbered : entries) {
+        if (!numbered.second.path.isEmpty()) {
+            sink(numbered.second);
+            ++count;
+        }
+    }
+    return count;
+}
+
+int PlaylistIO::readCue(QFile& file, const QString& baseDir, const EntrySink& sink)
+{
+    LineReader reader(file, false);
+    QString albumTitle;
+    QString albumArtist;
+    QString imagePath;
+
+    // 一条音轨的终点是同一文件中下一轨的起点，所以总是晚一轨输出
+    Entry current;
+    bool inTrack = false;
+    Entry pending;
+    bool havePending = false;
+    int count = 0;
+
+    auto flush = [&](qint64 endMs) {
+        if (!havePending) {
+            return;
+        }
+        pending.endMs = endMs > pending.startMs ? endMs : 0;
+        pending.durationMs = pending.endMs > 0 ? static_cast<qint32>(pending.endMs - pending.startMs) : 0;
+        sink(pending);
+        ++count;
+        havePending = false;
+    };
+    auto completeTrack = [&]() {
+        if (!inTrack || current.startMs < 0 || current.path.isEmpty()) {
+            inTrack = false;
+            return;
+        }
+        if (havePending && pending.path == current.path) {
+            flush(current.startMs);
+        } else {
+            flush(0);
+        }
+        if (current.title.isEmpty()) {
+            current.title = QString("Track %1").arg(current.cueTrack, 2, 10, QChar('0'));
+        }
+        pending = current;
+        havePending = true;
+        inTrack = false;
+    };
+
+    QString line;
+    while (reader.next(&line)) {
+        const QString command = line.section(' ', 0, 0).toUpper();
+        const QString argument = line.mid(command.size()).trimmed();
+        if (command == "FILE") {
+            completeTrack();
+            flush(0);
+            // FILE "名字" 类型；名字不带引号时可能含空格，去掉最后的类型词
+            const QString reference = argument.startsWith('"') ? unquote(argument)
+                                                              : argument.left(argument.lastIndexOf(' ')).trimmed();
+            imagePath = resolveCueFile(baseDir, reference.isEmpty() ? argument : reference);
+        } else if (command == "TRACK") {
+            completeTrack();
+            current = Entry();
+            current.path = imagePath;
+            current.cueTrack = argument.section(' ', 0, 0).toInt();
+            current.artist = albumArtist;
+            current.album = albumTitle;
+            current.startMs = -1;
+            inTrack = true;
+        } else if (command == "TITLE") {
+            (inTrack ? current.title : albumTitle) = unquote(argument);
+        } else if (command == "PERFORMER") {
+            (inTrack ? current.artist : albumArtist) = unquote(argument);
+        } else if (command == "INDEX" && inTrack) {
+            // INDEX 00 是前导静音，音轨从 INDEX 01 开始
+            const QStringList parts = argument.split(' ', Qt::SkipEmptyParts);
+            if (parts.size() >= 2 && parts[0].toInt() == 1) {
+                current.startMs = parseCueTime(parts[1]);
+            }
+        }
+    }
+    completeTrack();
+    flush(0);
+    return count;
+}
+
+bool PlaylistIO::write(const QString& playlistPath, const std::vector<Entry>& entries)
+{
+    QSaveFile file(playlistPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[PlaylistIO] 无法写入播放列表:" << playlistPath;
+        return false;
+    }
+
+    // 播放列表目录之下的文件写相对路径，列表和音乐一起搬走也能打开
+    const QDir dir = QFileInfo(playlistPath).absoluteDir();
+    auto reference = [&dir](const QString& path) {
+        const QString relative = dir.relativeFilePath(path);
+        return relative.startsWith("../") || QDir::isAbsolutePath(relative) ? QDir::toNativeSeparators(path) : relative;
+    };
+    auto displayName = [](const Entry& entry) {
+        if (entry.title.isEmpty()) {
+            return QFileInfo(entry.path).completeBaseName();
+        }
+        return entry.artist.isEmpty() ? entry.title : entry.artist + " - " + entry.title;
+    };
+    auto seconds = [](const Entry& entry) {
+        return entry.durationMs > 0 ? qRound(entry.durationMs / 1000.0) : -1;
+    };
+
+    const bool pls = QFileInfo(playlistPath).suffix().toLower() == "pls";
+    if (pls) {
+        file.write("[playlist]\n");
+        int number = 0;
+        for (const Entry& entry : entries) {
+            ++number;
+            // 一次多参数 arg() 替换全部占位符：路径和标题里的 "%1" 之类不会被再次替换
+            file.write(QString("File%1=%2\nTitle%1=%3\nLength%1=%4\n")
+                           .arg(QString::number(number), reference(entry.path), displayName(entry),
+                                QString::number(seconds(entry)))
+                           .toUtf8());
+        }
+        file.write(QString("NumberOfEntries=%1\nVersion=2\n").arg(number).toUtf8());
+    } else {
+        file.write("#EXTM3U\n");
+        for (const Entry& entry : entries) {
+            file.write(QString("#EXTINF:%1,%2\n%3\n")
+                           .arg(QString::number(seconds(entry)), displayName(entry), reference(entry.path))
+                           .toUtf8());
+        }
+    }
+    return file.commit();
+}
+
+QString PlaylistIO::resolve(const QString& baseDir, const QString& reference)
+{
+    if (reference.isEmpty()) {
+        return QString();
+    }
+    if (reference.startsWith("file:", Qt::CaseInsensitive)) {
+        return QUrl(reference).toLocalFile();
+    }
+    if (reference.contains("://")) {
+        return QString();   // 网络地址：不是本地文件
+    }
+    const QDir dir(baseDir);
+    QString path = dir.absoluteFilePath(reference);
+    if (reference.contains('\\') && !QFileInfo::exists(path)) {
+        // Windows 写出的列表用反斜杠分隔
+        path = dir.absoluteFilePath(QString(reference).replace('\\', '/'));
+    }
+    return QDir::cleanPath(path);
+}
+
+QString PlaylistIO::resolveCueFile(const QString& baseDir, const QString& reference)
+{
+    const QString path = resolve(baseDir, reference);
+    if (path.isEmpty() || QFileInfo::exists(path)) {
+        return path;
+    }
+    // 常见情况：CUE 写的是 .wav，镜像后来被转成了 .flac / .ape
+    const QFileInfo info(path);
+    const QDir dir = info.absoluteDir();
+    const QString baseName = info.completeBaseName();
+    for (const QString& name : dir.entryList(QDir::Files)) {
+        if (QFileInfo(name).completeBaseName() == baseName && LibraryScanner::isAudioFile(name)) {
+            return dir.filePath(name);
+        }
+    }
+    return path;
+}
+
+void PlaylistIO::splitDisplayName(const QString& text, Entry* entry)
+{
+    const int separator = text.indexOf(" - ");
+    if (separator > 0) {
+        entry->artist = text.left(separator).trimmed();
+        entry->title = text.mid(separator + 3).trimmed();
+    } else {
+        entry->title = text.trimmed();
+    }
+}
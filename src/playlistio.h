@@ -0,0 +1,71 @@
+/*
+ * PlaylistIO - M3U / M3U8 / PLS / CUE 播放列表的读取与 M3U8 / PLS 导出
+ *
+ * 读取是流式的：逐行读文件、逐条回调，不把整个文件读进内存，几万行的列表也只占一行的缓冲
+ * （PLS 的条目按编号分散在多行，按编号攒齐后在文件末尾按顺序回调）。
+ *   - 相对路径相对于播放列表所在目录解析；file:// URL 转为本地路径；http 等网络地址跳过
+ *   - .m3u8 按 UTF-8 读；.m3u / .pls / .cue 没有编码声明，逐行按 ASCII / UTF-8 / GBK 识别
+ *   - #EXTINF 的时长和“歌手 - 标题”随条目带出
+ *   - CUE：一个 FILE（整轨 FLAC / APE / WAV / MP3 镜像）下的每个 TRACK 成为一条带起止时间的条目，
+ *     终点取同一文件中下一轨的 INDEX 01；FILE 指向的文件不存在时（镜像被转码过）
+ *     在同目录找同名的其他音频文件
+ *
+ * 导出按扩展名选择格式：.pls 写 PLS，其余写带 #EXTINF 的 UTF-8 M3U；
+ * 位于播放列表目录之下的文件写相对路径，其余写绝对路径。
+ *
+ * 使用方式:
+ *   PlaylistIO::read(path, [&](const PlaylistIO::Entry& entry) { ... });
+ *   PlaylistIO::write(path, entries);
+ */
+#ifndef PLAYLISTIO_H
+#define PLAYLISTIO_H
+
+#include <QString>
+#include <functional>
+#include <vector>
+
+class QFile;
+
+class PlaylistIO
+{
+public:
+    struct Entry {
+        QString path;               // 绝对路径（CUE 条目为镜像文件）
+        QString title;
+        QString artist;
+        QString album;
+        qint32 durationMs = 0;      // 0 表示未知
+        int cueTrack = 0;           // CUE 音轨号，0 表示普通条目
+        qint64 startMs = 0;         // CUE 条目在镜像中的起止时间，endMs 为 0 表示到文件末尾
+        qint64 endMs = 0;
+    };
+
+    typedef std::function<void(const Entry& entry)> EntrySink;
+
+    /**
+     * @brief 是否为可导入的播放列表文件（.m3u / .m3u8 / .pls / .cue）
+     */
+    static bool isPlaylistFile(const QString& fileName);
+
+    /**
+     * @brief 流式读取播放列表，每解析出一条就回调一次
+     * @return 条目数；文件无法打开时返回 -1
+     */
+    static int read(const QString& playlistPath, const EntrySink& sink);
+
+    /**
+     * @brief 导出播放列表（QSaveFile：写完才替换）
+     */
+    static bool write(const QString& playlistPath, const std::vector<Entry>& entries);
+
+private:
+    static int readM3u(QFile& file, const QString& baseDir, bool utf8, const EntrySink& sink);
+    static int readPls(QFile& file, const QString& baseDir, const EntrySink& sink);
+    static int readCue(QFile& file, const QString& baseDir, const EntrySink& sink);
+
+    static QString resolve(const QString& baseDir, const QString& reference);
+    static QString resolveCueFile(const QString& baseDir, const QString& reference);
+    static void splitDisplayName(const QString& text, Entry* entry);
+};
+
+#endif // PLAYLISTIO_H
@@ -0,0 +1,130 @@
+/*
+ * PlaylistModel 实现
+ */
+#include "playlistmodel.h"
+
+#include <QColor>
+#include <QFont>
+#include <algorithm>
+
+#include "medialibrary.h"
+#include "pathvalidator.h"
+
+PlaylistModel::PlaylistModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+    MediaLibrary& library = MediaLibrary::instance();
+    m_slots = library.liveSlots();
+
+    connect(&library, &MediaLibrary::trackAdded, this, &PlaylistModel::appendTrack);
+    connect(&library, &MediaLibrary::aboutToRemoveTrack, this, &PlaylistModel::removeTrack);
+    connect(&library, &MediaLibrary::trackUpdated, this, &PlaylistModel::refreshTrack);
+    connect(&library, &MediaLibrary::fileChanged, this, &PlaylistModel::refreshTrack);
+    connect(&PathValidator::instance(), &PathValidator::missingChanged, this, &PlaylistModel::refreshTrack);
+}
+
+int PlaylistModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_slots.size());
+}
+
+QVariant PlaylistModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= static_cast<int>(m_slots.size())) {
+        return QVariant();
+    }
+    const MediaLibrary::Track& track = MediaLibrary::instance().trackAt(m_slots[static_cast<size_t>(index.row())]);
+    switch (role) {
+    case Qt::DisplayRole:
+        return track.displayName();
+    case Qt::ToolTipRole:
+        return PathValidator::instance().isMissing(track.path) ? QString("文件不存在: %1").arg(track.audioFile())
+                                                               : track.path;
+    case PathRole:
+        return track.path;
+    case MissingRole:
+        return PathValidator::instance().isMissing(track.path);
+    case Qt::FontRole:
+        // 列表样式表固定了文字颜色，不存在的文件再加删除线，颜色被覆盖时也能看出来
+        if (PathValidator::instance().isMissing(track.path)) {
+            QFont font;
+            font.setStrikeOut(true);
+            return font;
+        }
+        return QVariant();
+    case Qt::ForegroundRole:
+        return PathValidator::instance().isMissing(track.path) ? QVariant(QColor(160, 160, 160)) : QVariant();
+    case Qt::TextAlignmentRole:
+        return int(Qt::AlignCenter);
+    default:
+        return QVariant();
+    }
+}
+
+QString PlaylistModel::path(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_slots.size())) {
+        return QString();
+    }
+    return MediaLibrary::instance().trackAt(m_slots[static_cast<size_t>(row)]).path;
+}
+
+int PlaylistModel::row(const QString& filePath) const
+{
+    const int slot = MediaLibrary::instance().slot(filePath);
+    return slot < 0 ? -1 : rowOfSlot(slot);
+}
+
+int PlaylistModel::slot(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_slots.size())) {
+        return -1;
+    }
+    return m_slots[static_cast<size_t>(row)];
+}
+
+void PlaylistModel::reload()
+{
+    beginResetModel();
+    m_slots = MediaLibrary::instance().liveSlots();
+    endResetModel();
+}
+
+int PlaylistModel::rowOfSlot(int slot) const
+{
+    // 行按加入顺序排列，槽位单调递增，可以二分查找
+    const auto it = std::lower_bound(m_slots.begin(), m_slots.end(), slot);
+    return it != m_slots.end() && *it == slot ? static_cast<int>(it - m_slots.begin()) : -1;
+}
+
+void PlaylistModel::appendTrack(const QString& filePath)
+{
+    const int slot = MediaLibrary::instance().slot(filePath);
+    if (slot < 0) {
+        return;
+    }
+    const int row = static_cast<int>(m_slots.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_slots.push_back(slot);
+    endInsertRows();
+}
+
+void PlaylistModel::removeTrack(const QString& filePath)
+{
+    const int row = this->row(filePath);
+    if (row < 0) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    m_slots.erase(m_slots.begin() + row);
+    endRemoveRows();
+}
+
+void PlaylistModel::refreshTrack(const QString& filePath)
+{
+    const int row = this->row(filePath);
+    if (row >= 0) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed);
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * PlaylistModel - 播放列表的列表模型（替代逐项创建 QListWidgetItem）
+ *
+ * 每行只保存歌曲在 MediaLibrary 内存表中的槽位（一个 int），显示文本、路径等在绘制时按需从库中取，
+ * 配合 QListView::setUniformItemSizes，视图只为可见行调用 data()，几万首歌也不会逐项建对象。
+ * 直接监听 MediaLibrary 的信号：加入一首歌只插入一行，删除只移除一行，标签更新只刷新一行。
+ * PathValidator 在后台发现文件不存在时也只刷新那一行（灰色 + 删除线）。
+ *
+ * 使用方式:
+ *   auto* model = new PlaylistModel(this);
+ *   listView->setModel(model);
+ *   QString path = model->path(row);
+ */
+#ifndef PLAYLISTMODEL_H
+#define PLAYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <vector>
+
+class PlaylistModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        PathRole = Qt::UserRole,    // 完整路径
+        MissingRole                 // 后台检查发现文件不存在（PathValidator）
+    };
+
+    explicit PlaylistModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief 第 row 行的完整路径；越界时返回空字符串
+     */
+    QString path(int row) const;
+
+    /**
+     * @brief 路径所在行；不在列表中时返回 -1
+     */
+    int row(const QString& filePath) const;
+
+    /**
+     * @brief 第 row 行对应的媒体库槽位；越界时返回 -1
+     */
+    int slot(int row) const;
+
+    /**
+     * @brief 槽位所在行；不在列表中时返回 -1
+     */
+    int rowOfSlot(int slot) const;
+
+    /**
+     * @brief 按媒体库当前内容重建全部行
+     */
+    void reload();
+
+private:
+    void appendTrack(const QString& filePath);
+    void removeTrack(const QString& filePath);
+    void refreshTrack(const QString& filePath);
+
+    std::vector<int> m_slots;       // 行 → MediaLibrary 槽位
+};
+
+#endif // PLAYLISTMODEL_H
@@ -0,0 +1,335 @@
+/*
+ * PlayQueue 实现
+ */
+#include "playqueue.h"
+#include "journalframe.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+#include <cstdlib>
+
+namespace {
+
+constexpr quint32 kJournalMagic = 0x54545051;   // "TTPQ"
+constexpr quint16 kJournalVersion = 1;
+
+} // namespace
+
+PlayQueue& PlayQueue::instance()
+{
+    static PlayQueue inst;
+    return inst;
+}
+
+PlayQueue::PlayQueue(QObject* parent)
+    : QObject(parent)
+    , m_history(kHistoryCapacity)
+{
+    QString base = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (base.isEmpty()) {
+        base = QDir::tempPath();
+    }
+    QDir().mkpath(base);
+    m_journalPath = QDir(base).filePath("playqueue.db");
+
+    load();
+    m_savedPosition = m_resumePosition;
+    qDebug() << "[PlayQueue] 接下来播放" << m_upNext.size() << "首, 历史" << m_historyCount
+             << "首, 续播" << m_resumePath << m_resumePosition << "ms";
+}
+
+PlayQueue::~PlayQueue()
+{
+    shutdown();
+}
+
+void PlayQueue::shutdown()
+{
+    if (!m_resumePath.isEmpty() && m_resumePosition != m_savedPosition) {
+        savePosition(m_resumePath, m_resumePosition, true);
+    }
+    const int live = count() + m_historyCount + 1;
+    if (m_journalRecords >= kCompactMinRecords && m_journalRecords > 2 * live) {
+        compact();
+    } else if (m_journal.isOpen()) {
+        m_journal.flush();
+    }
+}
+
+void PlayQueue::enqueueNext(const QString& filePath)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+    applyInsert(0, filePath);
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(0) << filePath;
+    appendRecord(InsertRecord, payload);
+    emit queueChanged();
+}
+
+void PlayQueue::enqueueLast(const QString& filePath)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+    const int index = count();
+    applyInsert(index, filePath);
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(index) << filePath;
+    appendRecord(InsertRecord, payload);
+    emit queueChanged();
+}
+
+bool PlayQueue::removeAt(int index)
+{
+    if (!applyTake(index)) {
+        return false;
+    }
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << qint32(index);
+    appendRecord(TakeRecord, payload);
+    emit queueChanged();
+    return true;
+}
+
+void PlayQueue::clear()
+{
+    if (m_upNext.empty()) {
+        return;
+    }
+    m_upNext.clear();
+    appendRecord(ClearRecord, QByteArray());
+    emit queueChanged();
+}
+
+QString PlayQueue::takeNext()
+{
+    if (m_upNext.empty()) {
+        return QString();
+    }
+    const QString filePath = m_upNext.front();
+    removeAt(0);
+    return filePath;
+}
+
+QStringList PlayQueue::upNext() const
+{
+    QStringList paths;
+    paths.reserve(count());
+    for (const QString& filePath : m_upNext) {
+        paths.append(filePath);
+    }
+    return paths;
+}
+
+void PlayQueue::recordPlayed(const QString& filePath)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+    applyPlayed(filePath);
+    m_savedPosition = 0;
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << filePath;
+    appendRecord(PlayedRecord, payload);
+}
+
+QStringList PlayQueue::history() const
+{
+    QStringList paths;
+    paths.reserve(m_historyCount);
+    for (int i = 1; i <= m_historyCount; ++i) {
+        paths.append(m_history[static_cast<size_t>((m_historyHead - i + kHistoryCapacity) % kHistoryCapacity)]);
+    }
+    return paths;
+}
+
+void PlayQueue::savePosition(const QString& filePath, qint64 positionMs, bool force)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+    const bool sameTrack = filePath == m_resumePath;
+    m_resumePath = filePath;
+    m_resumePosition = positionMs;
+    if (!force && sameTrack && std::llabs(positionMs - m_savedPosition) < kPositionIntervalMs) {
+        return;
+    }
+    if (sameTrack && positionMs == m_savedPosition) {
+        return;
+    }
+    m_savedPosition = positionMs;
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << filePath << positionMs;
+    appendRecord(PositionRecord, payload);
+}
+
+void PlayQueue::applyInsert(int index, const QString& filePath)
+{
+    index = qBound(0, index, count());
+    m_upNext.insert(m_upNext.begin() + index, filePath);
+}
+
+bool PlayQueue::applyTake(int index)
+{
+    if (index < 0 || index >= count()) {
+        return false;
+    }
+    m_upNext.erase(m_upNext.begin() + index);
+    return true;
+}
+
+void PlayQueue::applyPlayed(const QString& filePath)
+{
+    m_history[static_cast<size_t>(m_historyHead)] = filePath;
+    m_historyHead = (m_historyHead + 1) % kHistoryCapacity;
+    m_historyCount = qMin(m_historyCount + 1, kHistoryCapacity);
+    m_resumePath = filePath;
+    m_resumePosition = 0;
+}
+
+/**
+ * @brief 日志格式：记录帧见 journalframe.h（magic "TTPQ"），payload 为 QDataStream，字段见 RecordType
+ */
+bool PlayQueue::load()
+{
+    QFile file(m_journalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    file.close();
+
+    if (bytes.size() < journal::kHeaderSize || !bytes.startsWith(journal::header(kJournalMagic, kJournalVersion))) {
+        qWarning() << "[PlayQueue] 无法识别的播放队列文件，重新建立:" << m_journalPath;
+        QFile::remove(m_journalPath);
+        return false;
+    }
+
+    const int offset = journal::decode(bytes, journal::kHeaderSize, [this](quint8 type, const QByteArray& payload) {
+        QDataStream in(payload);
+        qint32 index = 0;
+        QString filePath;
+        qint64 positionMs = 0;
+        switch (type) {
+        case InsertRecord:
+            in >> index >> filePath;
+            if (in.status() == QDataStream::Ok) {
+                applyInsert(index, filePath);
+            }
+            break;
+        case TakeRecord:
+            in >> index;
+            applyTake(index);
+            break;
+        case ClearRecord:
+            m_upNext.clear();
+            break;
+        case PlayedRecord:
+            in >> filePath;
+            if (in.status() == QDataStream::Ok) {
+                applyPlayed(filePath);
+            }
+            break;
+        case PositionRecord:
+            in >> filePath >> positionMs;
+            if (in.status() == QDataStream::Ok) {
+                m_resumePath = filePath;
+                m_resumePosition = positionMs;
+            }
+            break;
+        default:
+            break;
+        }
+        ++m_journalRecords;
+    });
+
+    if (offset < bytes.size()) {
+        qWarning() << "[PlayQueue] 丢弃日志末尾" << (bytes.size() - offset) << "字节不完整的记录";
+        QFile::resize(m_journalPath, offset);
+    }
+    return true;
+}
+
+bool PlayQueue::openJournal()
+{
+    if (m_journal.isOpen()) {
+        return true;
+    }
+    m_journal.setFileName(m_journalPath);
+    const bool fresh = !m_journal.exists() || m_journal.size() == 0;
+    if (!m_journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "[PlayQueue] 无法写入播放队列文件:" << m_journalPath;
+        return false;
+    }
+    if (fresh) {
+        m_journal.write(journal::header(kJournalMagic, kJournalVersion));
+    }
+    return true;
+}
+
+void PlayQueue::appendRecord(RecordType type, const QByteArray& payload)
+{
+    if (!openJournal()) {
+        return;
+    }
+    // 每条记录都是一次用户操作或一次定时保存，写完即刷新，崩溃时最多丢掉最后一条
+    m_journal.write(journal::encode(type, payload));
+    m_journal.flush();
+    ++m_journalRecords;
+}
+
+/**
+ * @brief 把日志压缩为当前状态的快照（QSaveFile：写完才替换）
+ */
+void PlayQueue::compact()
+{
+    m_journal.close();
+
+    QSaveFile file(m_journalPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[PlayQueue] 无法压缩播放队列文件:" << m_journalPath;
+        return;
+    }
+    file.write(journal::header(kJournalMagic, kJournalVersion));
+    int records = 0;
+
+    // 历史从旧到新重放，最后写续播点（PlayedRecord 会把续播点归零）
+    const QStringList played = history();
+    for (int i = played.size() - 1; i >= 0; --i) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << played.at(i);
+        file.write(journal::encode(PlayedRecord, payload));
+        ++records;
+    }
+    for (int index = 0; index < count(); ++index) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << qint32(index) << m_upNext[static_cast<size_t>(index)];
+        file.write(journal::encode(InsertRecord, payload));
+        ++records;
+    }
+    if (!m_resumePath.isEmpty()) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << m_resumePath << m_resumePosition;
+        file.write(journal::encode(PositionRecord, payload));
+        ++records;
+    }
+
+    if (file.commit()) {
+        qDebug() << "[PlayQueue] 日志已压缩:" << m_journalRecords << "→" << records << "条记录";
+        m_journalRecords = records;
+        m_savedPosition = m_resumePosition;
+    }
+}
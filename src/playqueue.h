@@ -0,0 +1,137 @@
+/*
+ * PlayQueue - 播放队列（“接下来播放”）与播放历史
+ *
+ * 与播放列表的顺序相互独立：
+ *   - 接下来播放：用户插入的歌（插到最前 / 追加到末尾），“下一首”优先从这里取，取完再回到列表顺序
+ *   - 播放历史：最近 kHistoryCapacity 首开始播放的歌，定长环形缓冲，满了覆盖最旧的
+ *   - 续播点：最后播放的歌和播放位置，下次启动按播放键时从这里继续
+ *
+ * 持久化与 MediaLibrary 相同，是一个只追加的日志（帧格式见 journalframe.h）：
+ * 每次入队、出队、开始播放一首歌、保存一次播放位置都只追加一条小记录，不重写文件；
+ * 播放位置最多每 kPositionIntervalMs 写一次（暂停、停止、退出时强制写）。
+ * 启动时重放日志恢复状态，过期记录多于有效记录时退出前压缩为快照。
+ * 只在 GUI 线程中使用。
+ *
+ * 使用方式:
+ *   PlayQueue::instance().enqueueNext(path);
+ *   QString next = PlayQueue::instance().takeNext();
+ *   PlayQueue::instance().recordPlayed(path);
+ *   PlayQueue::instance().savePosition(path, positionMs);
+ */
+#ifndef PLAYQUEUE_H
+#define PLAYQUEUE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <deque>
+#include <vector>
+
+class PlayQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    static PlayQueue& instance();
+
+    /**
+     * @brief 插到接下来播放的最前面
+     */
+    void enqueueNext(const QString& filePath);
+
+    /**
+     * @brief 追加到接下来播放的末尾
+     */
+    void enqueueLast(const QString& filePath);
+
+    /**
+     * @brief 移除接下来播放中的第 index 首
+     */
+    bool removeAt(int index);
+
+    void clear();
+
+    /**
+     * @brief 取出接下来播放的第一首；队列为空时返回空字符串
+     */
+    QString takeNext();
+
+    int count() const { return static_cast<int>(m_upNext.size()); }
+    bool isEmpty() const { return m_upNext.empty(); }
+
+    /**
+     * @brief 接下来播放的全部歌曲，按播放顺序
+     */
+    QStringList upNext() const;
+
+    /**
+     * @brief 记录一首歌开始播放：加入历史，并把续播点设为它的开头
+     */
+    void recordPlayed(const QString& filePath);
+
+    /**
+     * @brief 播放历史，最近播放的在前
+     */
+    QStringList history() const;
+
+    /**
+     * @brief 保存续播位置；距上次写入不足 kPositionIntervalMs 时只更新内存，force 为 true 时总是写入
+     */
+    void savePosition(const QString& filePath, qint64 positionMs, bool force = false);
+
+    QString resumePath() const { return m_resumePath; }
+    qint64 resumePosition() const { return m_resumePosition; }
+
+    /**
+     * @brief 写出尚未保存的续播位置并刷新日志；过期记录过多时压缩为快照（程序退出前调用）
+     */
+    void shutdown();
+
+signals:
+    void queueChanged();
+
+private:
+    enum RecordType : quint8 {
+        InsertRecord = 1,       // index, path：插入接下来播放
+        TakeRecord = 2,         // index：从接下来播放中移除
+        ClearRecord = 3,        // 清空接下来播放
+        PlayedRecord = 4,       // path：开始播放（进入历史，续播点归零）
+        PositionRecord = 5      // path, positionMs：续播位置
+    };
+
+    PlayQueue(QObject* parent = nullptr);
+    ~PlayQueue();
+    PlayQueue(const PlayQueue&) = delete;
+    PlayQueue& operator=(const PlayQueue&) = delete;
+
+    bool load();
+
+    // 只修改内存状态，不写日志（load 与公开接口共用）
+    void applyInsert(int index, const QString& filePath);
+    bool applyTake(int index);
+    void applyPlayed(const QString& filePath);
+
+    void appendRecord(RecordType type, const QByteArray& payload);
+    bool openJournal();
+    void compact();
+
+    static constexpr int kHistoryCapacity = 100;
+    static constexpr qint64 kPositionIntervalMs = 5000;
+    static constexpr int kCompactMinRecords = 256;
+
+    QString m_journalPath;
+    QFile m_journal;                        // 以追加方式保持打开
+    int m_journalRecords = 0;
+
+    std::deque<QString> m_upNext;
+    std::vector<QString> m_history;         // 环形缓冲，容量 kHistoryCapacity
+    int m_historyHead = 0;                  // 下一次写入的位置
+    int m_historyCount = 0;
+
+    QString m_resumePath;
+    qint64 m_resumePosition = 0;
+    qint64 m_savedPosition = 0;             // 日志中最后一次写入的位置
+};
+
+#endif // PLAYQUEUE_H
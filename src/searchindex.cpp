@@ -0,0 +1,285 @@
+/*
+ * SearchIndex 实现
+ */
+#include "searchindex.h"
+
+#include <algorithm>
+
+#include "pinyintable.h"
+
+namespace {
+
+const QChar kFieldSeparator('\n');
+
+inline quint32 packBigram(QChar a, QChar b)
+{
+    return (quint32(a.unicode()) << 16) | b.unicode();
+}
+
+// 两个升序列表求交集：短表中的每个元素在长表里二分查找，长表越长越划算
+std::vector<int> intersect(const std::vector<int>& small, const std::vector<int>& large)
+{
+    std::vector<int> result;
+    result.reserve(small.size());
+    auto from = large.begin();
+    for (int id : small) {
+        from = std::lower_bound(from, large.end(), id);
+        if (from == large.end()) {
+            break;
+        }
+        if (*from == id) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+QString SearchIndex::pinyinInitials(const QString& text)
+{
+    QString initials;
+    bool found = false;
+    bool separated = true;
+    for (const QChar ch : text) {
+        const char16_t code = ch.unicode();
+        const char letter = code >= kPinyinFirst && code <= kPinyinLast ? kPinyinInitials[code - kPinyinFirst] : '.';
+        if (letter != '.') {
+            initials.append(QChar(letter));
+            found = true;
+            separated = false;
+        } else if (!separated) {
+            initials.append(' ');
+            separated = true;
+        }
+    }
+    return found ? initials.trimmed() : QString();
+}
+
+void SearchIndex::insert(int id, const QStringList& fields)
+{
+    if (id < 0) {
+        return;
+    }
+    remove(id);
+
+    QStringList parts;
+    QStringList initials;
+    for (const QString& field : fields) {
+        if (field.isEmpty()) {
+            continue;
+        }
+        parts.append(field.toCaseFolded());
+        const QString pinyin = pinyinInitials(field);
+        if (!pinyin.isEmpty()) {
+            initials.append(pinyin);
+        }
+    }
+    const QString text = (parts + initials).join(kFieldSeparator);
+
+    if (static_cast<size_t>(id) >= m_texts.size()) {
+        m_texts.resize(static_cast<size_t>(id) + 1);
+        m_asciiMasks.resize(static_cast<size_t>(id) + 1);
+    }
+    m_texts[static_cast<size_t>(id)] = text;
+
+    std::array<quint64, 2> mask = {0, 0};
+    for (const QChar ch : text) {
+        if (ch.unicode() < 128 && ch != kFieldSeparator) {
+            mask[ch.unicode() >> 6] |= quint64(1) << (ch.unicode() & 63);
+        }
+    }
+    // 占位：确保空文本的条目也能被 contains() 识别
+    mask[0] |= 1;
+    m_asciiMasks[static_cast<size_t>(id)] = mask;
+
+    for (quint32 key : bigramsOf(text)) {
+        addPosting(m_bigrams[key], id);
+    }
+    for (char16_t key : unigramsOf(text)) {
+        addPosting(m_unigrams[key], id);
+    }
+}
+
+void SearchIndex::remove(int id)
+{
+    if (!contains(id)) {
+        return;
+    }
+    const QString& text = m_texts[static_cast<size_t>(id)];
+    for (quint32 key : bigramsOf(text)) {
+        const auto it = m_bigrams.find(key);
+        if (it != m_bigrams.end()) {
+            removePosting(it->second, id);
+            if (it->second.empty()) {
+                m_bigrams.erase(it);
+            }
+        }
+    }
+    for (char16_t key : unigramsOf(text)) {
+        const auto it = m_unigrams.find(key);
+        if (it != m_unigrams.end()) {
+            removePosting(it->second, id);
+            if (it->second.empty()) {
+                m_unigrams.erase(it);
+            }
+        }
+    }
+    m_texts[static_cast<size_t>(id)].clear();
+    m_asciiMasks[static_cast<size_t>(id)] = {0, 0};
+}
+
+void SearchIndex::clear()
+{
+    m_texts.clear();
+    m_asciiMasks.clear();
+    m_bigrams.clear();
+    m_unigrams.clear();
+}
+
+bool SearchIndex::contains(int id) const
+{
+    return id >= 0 && static_cast<size_t>(id) < m_asciiMasks.size()
+           && (m_asciiMasks[static_cast<size_t>(id)][0] & 1);
+}
+
+std::vector<int> SearchIndex::query(const QString& text) const
+{
+    const QStringList words = terms(text);
+    if (words.isEmpty()) {
+        return std::vector<int>();
+    }
+
+    std::vector<std::vector<int>> results;
+    results.reserve(static_cast<size_t>(words.size()));
+    for (const QString& word : words) {
+        results.push_back(queryTerm(word));
+        if (results.back().empty()) {
+            return std::vector<int>();
+        }
+    }
+    std::sort(results.begin(), results.end(),
+              [](const std::vector<int>& a, const std::vector<int>& b) { return a.size() < b.size(); });
+    std::vector<int> ids = std::move(results.front());
+    for (size_t i = 1; i < results.size() && !ids.empty(); ++i) {
+        ids = intersect(ids, results[i]);
+    }
+    return ids;
+}
+
+bool SearchIndex::matches(int id, const QString& text) const
+{
+    if (!contains(id)) {
+        return false;
+    }
+    const QString& indexed = m_texts[static_cast<size_t>(id)];
+    const QStringList words = terms(text);
+    return std::all_of(words.cbegin(), words.cend(), [&](const QString& word) { return indexed.contains(word); });
+}
+
+std::vector<int> SearchIndex::queryTerm(const QString& term) const
+{
+    std::vector<int> ids;
+    if (term.size() == 1) {
+        const char16_t code = term.at(0).unicode();
+        if (code < 128) {
+            // 单个 ASCII 字符几乎命中所有条目，倒排表不划算：直接扫描位图
+            const quint64 bit = quint64(1) << (code & 63);
+            for (size_t id = 0; id < m_asciiMasks.size(); ++id) {
+                if (m_asciiMasks[id][code >> 6] & bit) {
+                    ids.push_back(static_cast<int>(id));
+                }
+            }
+            return ids;
+        }
+        const auto it = m_unigrams.find(code);
+        return it == m_unigrams.end() ? ids : it->second;
+    }
+
+    // 各二元组的倒排表，从最短的开始求交集
+    std::vector<const Postings*> lists;
+    for (int i = 0; i + 1 < term.size(); ++i) {
+        const auto it = m_bigrams.find(packBigram(term.at(i), term.at(i + 1)));
+        if (it == m_bigrams.end()) {
+            return ids;
+        }
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const Postings* a, const Postings* b) { return a->size() < b->size(); });
+    lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+    ids = *lists.front();
+    for (size_t i = 1; i < lists.size() && !ids.empty(); ++i) {
+        ids = intersect(ids, *lists[i]);
+    }
+
+    // 二元组都出现不代表它们相连：长于 2 的词对剩余候选做子串校验
+    if (term.size() > 2) {
+        ids.erase(std::remove_if(ids.begin(), ids.end(),
+                                 [&](int id) { return !m_texts[static_cast<size_t>(id)].contains(term); }),
+                  ids.end());
+    }
+    return ids;
+}
+
+QStringList SearchIndex::terms(const QString& text)
+{
+    QStringList words;
+    for (const QString& word : text.toCaseFolded().split(' ')) {
+        const QString trimmed = word.trimmed();
+        if (!trimmed.isEmpty()) {
+            words.append(trimmed);
+        }
+    }
+    return words;
+}
+
+void SearchIndex::addPosting(Postings& postings, int id)
+{
+    // id 通常是新追加的最大值，直接放到末尾
+    if (postings.empty() || postings.back() < id) {
+        postings.push_back(id);
+        return;
+    }
+    const auto it = std::lower_bound(postings.begin(), postings.end(), id);
+    if (it == postings.end() || *it != id) {
+        postings.insert(it, id);
+    }
+}
+
+void SearchIndex::removePosting(Postings& postings, int id)
+{
+    const auto it = std::lower_bound(postings.begin(), postings.end(), id);
+    if (it != postings.end() && *it == id) {
+        postings.erase(it);
+    }
+}
+
+std::vector<quint32> SearchIndex::bigramsOf(const QString& text)
+{
+    std::vector<quint32> keys;
+    keys.reserve(static_cast<size_t>(text.size()));
+    for (int i = 0; i + 1 < text.size(); ++i) {
+        const QChar a = text.at(i);
+        const QChar b = text.at(i + 1);
+        if (a != kFieldSeparator && b != kFieldSeparator) {
+            keys.push_back(packBigram(a, b));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+std::vector<char16_t> SearchIndex::unigramsOf(const QString& text)
+{
+    std::vector<char16_t> keys;
+    for (const QChar ch : text) {
+        if (ch.unicode() >= 128) {
+            keys.push_back(ch.unicode());
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
@@ -0,0 +1,81 @@
+/*
+ * SearchIndex - 播放列表的子串搜索索引
+ *
+ * 每个条目（以整数 id 标识，播放列表中为媒体库槽位）的若干字段被规范化（大小写折叠）后拼成一段文本，
+ * 中文字段额外附上拼音首字母（“周杰伦” → “zjl”），字段之间用换行分隔，查询不会跨字段匹配。
+ *
+ * 索引结构（均按 id 升序的倒排表，便于求交集和增量维护）：
+ *   - 二元组（相邻两个 UTF-16 码元）→ id 列表：长度 ≥ 2 的查询取各二元组列表的交集，
+ *     长度为 2 时结果即为精确答案，更长时再对少量候选做一次子串校验
+ *   - 非 ASCII 单字 → id 列表：单个汉字的查询
+ *   - 每个条目 128 位的 ASCII 字符位图：单个 ASCII 字符的查询顺序扫描位图即可
+ * 以空白分隔的多个词取交集（“周杰伦 晴天”）。
+ *
+ * 加入、删除、修改一个条目只改动它自己的那些倒排表，不重建索引。
+ * 10 万条目时查询在 1ms 以内，内存约为每条目 300~400 字节。
+ *
+ * 使用方式:
+ *   SearchIndex index;
+ *   index.insert(id, QStringList{title, artist, album, fileName});
+ *   std::vector<int> ids = index.query("zjl");
+ */
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+class SearchIndex
+{
+public:
+    /**
+     * @brief 加入或替换一个条目
+     */
+    void insert(int id, const QStringList& fields);
+
+    /**
+     * @brief 删除一个条目（不存在时不做任何事）
+     */
+    void remove(int id);
+
+    void clear();
+
+    /**
+     * @brief 查询包含所有词的条目
+     * @return 按 id 升序；查询为空时返回空列表（由调用方决定是否显示全部）
+     */
+    std::vector<int> query(const QString& text) const;
+
+    /**
+     * @brief 单个条目是否满足查询（不经过倒排表，用于条目变化后的重新判断）
+     */
+    bool matches(int id, const QString& text) const;
+
+    /**
+     * @brief 汉字转拼音首字母，其余字符作为分隔；没有汉字时返回空字符串
+     */
+    static QString pinyinInitials(const QString& text);
+
+private:
+    typedef std::vector<int> Postings;
+
+    static QStringList terms(const QString& text);
+    static void addPosting(Postings& postings, int id);
+    static void removePosting(Postings& postings, int id);
+    static std::vector<quint32> bigramsOf(const QString& text);
+    static std::vector<char16_t> unigramsOf(const QString& text);
+
+    std::vector<int> queryTerm(const QString& term) const;
+    bool contains(int id) const;
+
+    std::vector<QString> m_texts;                       // id → 规范化后的全文，空表示不在索引中
+    std::vector<std::array<quint64, 2>> m_asciiMasks;   // id → 出现过的 ASCII 字符
+    std::unordered_map<quint32, Postings> m_bigrams;
+    std::unordered_map<char16_t, Postings> m_unigrams;  // 只收非 ASCII 字符
+};
+
+#endif // SEARCHINDEX_H
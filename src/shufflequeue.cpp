@@ -0,0 +1,181 @@
+/*
+ * ShuffleQueue 实现
+ */
+#include "shufflequeue.h"
+
+#include <algorithm>
+
+ShuffleQueue::ShuffleQueue()
+    : m_drawn(0)
+    , m_cursor(-1)
+    , m_random(QRandomGenerator::securelySeeded())
+{
+}
+
+void ShuffleQueue::insert(int id, uint group)
+{
+    if (id < 0) {
+        return;
+    }
+    if (static_cast<size_t>(id) >= m_positionOf.size()) {
+        m_positionOf.resize(static_cast<size_t>(id) + 1, -1);
+        m_groupOf.resize(static_cast<size_t>(id) + 1, 0);
+    }
+    m_groupOf[static_cast<size_t>(id)] = group;
+    if (m_positionOf[static_cast<size_t>(id)] >= 0) {
+        return;
+    }
+    // 追加到未抽取部分的末尾，抽取本身是随机的，位置无所谓
+    m_positionOf[static_cast<size_t>(id)] = static_cast<int>(m_order.size());
+    m_order.push_back(id);
+}
+
+void ShuffleQueue::remove(int id)
+{
+    if (!contains(id)) {
+        return;
+    }
+    const int position = m_positionOf[static_cast<size_t>(id)];
+    if (position >= m_drawn) {
+        // 未抽到：与末尾交换后弹出
+        place(position, static_cast<int>(m_order.size()) - 1);
+        m_order.pop_back();
+    } else {
+        // 在历史中：保持其余历史的先后顺序
+        m_order.erase(m_order.begin() + position);
+        for (size_t i = static_cast<size_t>(position); i < m_order.size(); ++i) {
+            m_positionOf[static_cast<size_t>(m_order[i])] = static_cast<int>(i);
+        }
+        --m_drawn;
+        if (m_cursor >= position) {
+            --m_cursor;
+        }
+    }
+    m_positionOf[static_cast<size_t>(id)] = -1;
+}
+
+void ShuffleQueue::clear()
+{
+    m_order.clear();
+    m_positionOf.clear();
+    m_groupOf.clear();
+    m_recentGroups.clear();
+    m_drawn = 0;
+    m_cursor = -1;
+}
+
+bool ShuffleQueue::contains(int id) const
+{
+    return id >= 0 && static_cast<size_t>(id) < m_positionOf.size() && m_positionOf[static_cast<size_t>(id)] >= 0;
+}
+
+int ShuffleQueue::next()
+{
+    if (m_order.empty()) {
+        return -1;
+    }
+    if (m_cursor + 1 < m_drawn) {
+        // 之前后退过：沿历史向前，不重新抽
+        return m_order[static_cast<size_t>(++m_cursor)];
+    }
+
+    int avoid = -1;
+    if (m_drawn == size()) {
+        // 本轮抽完，开始新一轮；新一轮的第一首不能是刚播完的那首
+        avoid = current();
+        m_drawn = 0;
+        m_cursor = -1;
+    }
+    draw(avoid);
+    return current();
+}
+
+int ShuffleQueue::previous()
+{
+    if (m_cursor <= 0) {
+        return -1;
+    }
+    return m_order[static_cast<size_t>(--m_cursor)];
+}
+
+int ShuffleQueue::current() const
+{
+    return m_cursor >= 0 && m_cursor < m_drawn ? m_order[static_cast<size_t>(m_cursor)] : -1;
+}
+
+void ShuffleQueue::jumpTo(int id)
+{
+    if (!contains(id)) {
+        return;
+    }
+    const int position = m_positionOf[static_cast<size_t>(id)];
+    if (position < m_drawn) {
+        m_cursor = position;
+        return;
+    }
+    place(position, m_drawn);
+    m_cursor = m_drawn++;
+    remember(id);
+}
+
+void ShuffleQueue::draw(int avoid)
+{
+    const int poolSize = size() - m_drawn;
+    int first = -1;
+    int chosen = -1;
+    for (int attempt = 0; attempt < std::min(kCandidates, poolSize); ++attempt) {
+        const int index = m_drawn + m_random.bounded(poolSize);
+        const int id = m_order[static_cast<size_t>(index)];
+        if (id == avoid && poolSize > 1) {
+            continue;
+        }
+        if (first < 0) {
+            first = index;
+        }
+        if (!recentlyPlayed(m_groupOf[static_cast<size_t>(id)])) {
+            chosen = index;
+            break;
+        }
+    }
+    if (chosen < 0) {
+        chosen = first;
+    }
+    if (chosen < 0) {
+        // 每次都抽到了要避开的那首：在其余位置中均匀取一个（末尾位置一定不是它）
+        chosen = m_drawn + m_random.bounded(poolSize - 1);
+        if (m_order[static_cast<size_t>(chosen)] == avoid) {
+            chosen = size() - 1;
+        }
+    }
+
+    place(chosen, m_drawn);
+    m_cursor = m_drawn++;
+    remember(m_order[static_cast<size_t>(m_cursor)]);
+}
+
+void ShuffleQueue::place(int index, int position)
+{
+    if (index == position) {
+        return;
+    }
+    std::swap(m_order[static_cast<size_t>(index)], m_order[static_cast<size_t>(position)]);
+    m_positionOf[static_cast<size_t>(m_order[static_cast<size_t>(index)])] = index;
+    m_positionOf[static_cast<size_t>(m_order[static_cast<size_t>(position)])] = position;
+}
+
+void ShuffleQueue::remember(int id)
+{
+    const uint group = m_groupOf[static_cast<size_t>(id)];
+    if (group == 0) {
+        return;
+    }
+    m_recentGroups.push_back(group);
+    if (m_recentGroups.size() > static_cast<size_t>(kRecentGroups)) {
+        m_recentGroups.erase(m_recentGroups.begin());
+    }
+}
+
+bool ShuffleQueue::recentlyPlayed(uint group) const
+{
+    return group != 0 && std::find(m_recentGroups.begin(), m_recentGroups.end(), group) != m_recentGroups.end();
+}
@@ -0,0 +1,88 @@
+/*
+ * ShuffleQueue - 随机播放顺序（增量 Fisher–Yates）
+ *
+ * 不预先打乱整张列表：m_order 的前半段 [0, m_drawn) 是本轮已经抽出的顺序（即播放历史），
+ * 后半段是尚未抽到的歌。“下一首”从后半段随机取一首换到分界处，“上一首”只是游标后退，都是 O(1)；
+ * 一轮内每首歌恰好出现一次，轮与轮之间也不会连着两次播同一首。
+ * 加入的歌直接放进未抽取的部分；删除未抽到的歌与末尾交换后弹出，删除历史中的歌保持其余历史的顺序。
+ *
+ * 歌手分散（“智能随机”）：抽取时最多看 kCandidates 个随机候选，取第一个与最近
+ * kRecentGroups 首歌的歌手都不同的；都相同（比如列表几乎全是同一个歌手）时退回第一个候选。
+ * 歌手以调用方给出的分组键表示，0 表示未知，不参与分散。
+ *
+ * 使用方式:
+ *   ShuffleQueue shuffle;
+ *   shuffle.insert(slot, qHash(artist));
+ *   int first = shuffle.next();
+ *   int back = shuffle.previous();
+ */
+#ifndef SHUFFLEQUEUE_H
+#define SHUFFLEQUEUE_H
+
+#include <QRandomGenerator>
+#include <QtGlobal>
+#include <vector>
+
+class ShuffleQueue
+{
+public:
+    ShuffleQueue();
+
+    /**
+     * @brief 加入一首歌（已存在时只更新分组键）
+     * @param id 非负整数标识（播放列表中为媒体库槽位）
+     * @param group 歌手分组键，0 表示未知
+     */
+    void insert(int id, uint group = 0);
+
+    /**
+     * @brief 移除一首歌；正在播放的歌被移除时，下一首从它原来的位置继续
+     */
+    void remove(int id);
+
+    void clear();
+
+    int size() const { return static_cast<int>(m_order.size()); }
+    bool contains(int id) const;
+
+    /**
+     * @brief 下一首：先沿历史向前，走到头时抽一首新的；本轮抽完自动开始新一轮
+     * @return 歌曲 id；队列为空时返回 -1
+     */
+    int next();
+
+    /**
+     * @brief 上一首：沿历史后退
+     * @return 歌曲 id；已在本轮历史开头时返回 -1
+     */
+    int previous();
+
+    /**
+     * @brief 当前歌曲；尚未开始时返回 -1
+     */
+    int current() const;
+
+    /**
+     * @brief 用户直接点播了某首歌：尚未抽到的放到历史末尾，已在历史中的只移动游标
+     */
+    void jumpTo(int id);
+
+private:
+    static constexpr int kCandidates = 8;       // 每次抽取最多看几个随机候选
+    static constexpr int kRecentGroups = 3;     // 与最近几首歌的歌手错开
+
+    void draw(int avoid);
+    void place(int index, int position);
+    void remember(int id);
+    bool recentlyPlayed(uint group) const;
+
+    std::vector<int> m_order;       // 前 m_drawn 个为本轮历史，其余未抽取
+    std::vector<int> m_positionOf;  // id → 在 m_order 中的下标，-1 表示不在队列中
+    std::vector<uint> m_groupOf;    // id → 歌手分组键
+    int m_drawn;
+    int m_cursor;                   // 当前歌曲在 m_order 中的下标，-1 表示尚未开始
+    std::vector<uint> m_recentGroups;   // 最近抽到的歌手，跨轮保留
+    QRandomGenerator m_random;
+};
+
+#endif // SHUFFLEQUEUE_H
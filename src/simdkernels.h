@@ -0,0 +1,311 @@
+/*
+ * SIMD 内核集合 (header-only)
+ *
+ * 频谱/可视化热路径上用到的小型向量化函数。
+ * 在支持 SSE2 的平台（x86-64 默认开启，MSVC/MinGW 均可）使用 intrinsics，
+ * 其他平台自动回退到等价的标量实现，调用方无需关心。
+ *
+ * 当前提供:
+ *   - deinterleaveStereo: 交织 16bit/float 立体声 → 独立 L/R 浮点平面
+ *   - leftRightToMidSide: L/R 平面 → M/S 平面
+ *   - followEnvelope:     一阶包络跟随（攻击 / 释放两套系数）
+ *   - updatePeaks:        峰值保持 + 重力下落
+ *   - rectifiedFlux:      半波整流差分之和（谱通量起始点检测）
+ *   - blendOver / blendSolid: 预乘 Alpha 像素的 src-over 混合（软件合成频谱柱）
+ */
+#ifndef TTPLAYER_SIMDKERNELS_H
+#define TTPLAYER_SIMDKERNELS_H
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TTPLAYER_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace simd {
+
+/**
+ * @brief 交织立体声 16bit PCM → 两个浮点平面（归一化到 [-1, 1]）
+ * @param in     L0 R0 L1 R1 ... 共 frames*2 个样本
+ * @param left   输出左声道，frames 个
+ * @param right  输出右声道，frames 个
+ */
+inline void deinterleaveStereo(const int16_t* in, float* left, float* right, int frames)
+{
+    const float scale = 1.0f / 32768.0f;
+    int f = 0;
+#ifdef TTPLAYER_HAVE_SSE2
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; f + 4 <= frames; f += 4) {
+        // 8 个 int16: L0 R0 L1 R1 L2 R2 L3 R3
+        const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + f * 2));
+        // 符号扩展为 int32（高 16 位放样本后算术右移）
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);   // L0 R0 L1 R1
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);   // L2 R2 L3 R3
+        const __m128 a = _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale);
+        const __m128 b = _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale);
+        _mm_storeu_ps(left + f,  _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; f < frames; ++f) {
+        left[f] = in[f * 2] * scale;
+        right[f] = in[f * 2 + 1] * scale;
+    }
+}
+
+/**
+ * @brief 交织立体声 float PCM → 两个浮点平面（MINIMP3_FLOAT_OUTPUT 构建使用）
+ */
+inline void deinterleaveStereo(const float* in, float* left, float* right, int frames)
+{
+    int f = 0;
+#ifdef TTPLAYER_HAVE_SSE2
+    for (; f + 4 <= frames; f += 4) {
+        const __m128 a = _mm_loadu_ps(in + f * 2);       // L0 R0 L1 R1
+        const __m128 b = _mm_loadu_ps(in + f * 2 + 4);   // L2 R2 L3 R3
+        _mm_storeu_ps(left + f,  _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; f < frames; ++f) {
+        left[f] = in[f * 2];
+        right[f] = in[f * 2 + 1];
+    }
+}
+
+/**
+ * @brief 原地把 L/R 平面转换为 M/S 平面：M = (L+R)/2, S = (L-R)/2
+ */
+inline void leftRightToMidSide(float* left, float* right, int frames)
+{
+    int f = 0;
+#ifdef TTPLAYER_HAVE_SSE2
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; f + 4 <= frames; f += 4) {
+        const __m128 l = _mm_loadu_ps(left + f);
+        const __m128 r = _mm_loadu_ps(right + f);
+        _mm_storeu_ps(left + f,  _mm_mul_ps(_mm_add_ps(l, r), half));
+        _mm_storeu_ps(right + f, _mm_mul_ps(_mm_sub_ps(l, r), half));
+    }
+#endif
+    for (; f < frames; ++f) {
+        const float l = left[f];
+        const float r = right[f];
+        left[f] = (l + r) * 0.5f;
+        right[f] = (l - r) * 0.5f;
+    }
+}
+
+#ifdef TTPLAYER_HAVE_SSE2
+// mask 为全 1 的通道取 a，否则取 b
+inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+/**
+ * @brief 一阶包络跟随：level += (target - level) * coeff
+ * @param target 目标值；nullptr 表示全部为 0（例如暂停后归零）
+ * @param attackCoeff 目标高于当前值时使用的系数
+ * @param releaseCoeff 目标低于当前值时使用的系数
+ */
+inline void followEnvelope(float* level, const float* target, int count, float attackCoeff, float releaseCoeff)
+{
+    int i = 0;
+#ifdef TTPLAYER_HAVE_SSE2
+    const __m128 attack = _mm_set1_ps(attackCoeff);
+    const __m128 release = _mm_set1_ps(releaseCoeff);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 l = _mm_loadu_ps(level + i);
+        const __m128 t = target ? _mm_loadu_ps(target + i) : _mm_setzero_ps();
+        const __m128 coeff = select(_mm_cmpgt_ps(t, l), attack, release);
+        _mm_storeu_ps(level + i, _mm_add_ps(l, _mm_mul_ps(_mm_sub_ps(t, l), coeff)));
+    }
+#endif
+    for (; i < count; ++i) {
+        const float t = target ? target[i] : 0.0f;
+        level[i] += (t - level[i]) * (t > level[i] ? attackCoeff : releaseCoeff);
+    }
+}
+
+/**
+ * @brief 峰值指示器：被顶起后保持 holdTime 秒，然后以 gravity 加速度下落
+ * @param peak     峰值位置（原地更新）
+ * @param velocity 下落速度（原地更新）
+ * @param hold     剩余保持时间，秒（原地更新）
+ * @param level    当前柱高，峰值不会低于它
+ */
+inline void updatePeaks(float* peak, float* velocity, float* hold, const float* level, int count,
+                        float dt, float gravity, float holdTime)
+{
+    int i = 0;
+#ifdef TTPLAYER_HAVE_SSE2
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 vdv = _mm_set1_ps(gravity * dt);
+    const __m128 vhold = _mm_set1_ps(holdTime);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        const __m128 p = _mm_loadu_ps(peak + i);
+        const __m128 v = _mm_loadu_ps(velocity + i);
+        const __m128 h = _mm_loadu_ps(hold + i);
+        const __m128 l = _mm_loadu_ps(level + i);
+
+        const __m128 rise = _mm_cmpge_ps(l, p);
+        const __m128 holding = _mm_andnot_ps(rise, _mm_cmpgt_ps(h, zero));
+        const __m128 falling = _mm_andnot_ps(_mm_or_ps(rise, holding), _mm_cmpeq_ps(zero, zero));
+
+        const __m128 newHold = select(rise, vhold, select(holding, _mm_sub_ps(h, vdt), h));
+        const __m128 newVel = select(rise, zero, select(falling, _mm_add_ps(v, vdv), v));
+        const __m128 fallen = _mm_max_ps(_mm_sub_ps(p, _mm_mul_ps(newVel, vdt)), l);
+        const __m128 newPeak = select(rise, l, select(falling, fallen, p));
+
+        _mm_storeu_ps(peak + i, newPeak);
+        _mm_storeu_ps(velocity + i, newVel);
+        _mm_storeu_ps(hold + i, newHold);
+    }
+#endif
+    for (; i < count; ++i) {
+        if (level[i] >= peak[i]) {
+            peak[i] = level[i];
+            velocity[i] = 0.0f;
+            hold[i] = holdTime;
+        } else if (hold[i] > 0.0f) {
+            hold[i] -= dt;
+        } else {
+            velocity[i] += gravity * dt;
+            const float fallen = peak[i] - velocity[i] * dt;
+            peak[i] = fallen > level[i] ? fallen : level[i];
+        }
+    }
+}
+
+/**
+ * @brief 谱通量：sum(max(current[i] - previous[i], 0))
+ *
+ * 只累计能量上升的部分，下降（音符衰减）不计入。
+ */
+inline float rectifiedFlux(const float* current, const float* previous, int count)
+{
+    int i = 0;
+    float sum = 0.0f;
+#ifdef TTPLAYER_HAVE_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    __m128 acc = zero;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 diff = _mm_sub_ps(_mm_loadu_ps(current + i), _mm_loadu_ps(previous + i));
+        acc = _mm_add_ps(acc, _mm_max_ps(diff, zero));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; ++i) {
+        const float diff = current[i] - previous[i];
+        sum += diff > 0.0f ? diff : 0.0f;
+    }
+    return sum;
+}
+
+/**
+ * @brief 单个预乘 Alpha 像素的 src-over：dst × (255 - srcAlpha) / 255 + src
+ *
+ * 像素格式与 QImage::Format_ARGB32_Premultiplied 相同（0xAARRGGBB）。
+ * R/B 与 A/G 两对分量各用一次 32 位乘法，/255 按 (x + (x >> 8) + 128) >> 8 舍入。
+ */
+inline uint32_t blendPixel(uint32_t dst, uint32_t src)
+{
+    const uint32_t inv = 255 - (src >> 24);
+    uint32_t rb = (dst & 0x00ff00ffu) * inv;
+    rb = ((rb + ((rb >> 8) & 0x00ff00ffu) + 0x00800080u) >> 8) & 0x00ff00ffu;
+    uint32_t ag = ((dst >> 8) & 0x00ff00ffu) * inv;
+    ag = (ag + ((ag >> 8) & 0x00ff00ffu) + 0x00800080u) & 0xff00ff00u;
+    return src + (rb | ag);
+}
+
+#ifdef TTPLAYER_HAVE_SSE2
+// 4 个预乘像素的 src-over（每个分量扩展为 16 位计算）
+inline __m128i blendPixels(__m128i dst, __m128i src)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i round = _mm_set1_epi16(128);
+
+    auto blendHalf = [&](__m128i d, __m128i s) {
+        // 把每个像素的 Alpha 广播到它的 4 个分量
+        __m128i alpha = _mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(full, alpha)), round);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    };
+
+    const __m128i lo = blendHalf(_mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi8(src, zero));
+    const __m128i hi = blendHalf(_mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi8(src, zero));
+    return _mm_adds_epu8(_mm_packus_epi16(lo, hi), src);
+}
+#endif
+
+/**
+ * @brief 一行预乘像素的 src-over 混合：dst = src over dst
+ *
+ * 4 个源像素全不透明时直接拷贝，全透明时跳过（渐变条贴图几乎都属于这两种情况）。
+ */
+inline void blendOver(uint32_t* dst, const uint32_t* src, int count)
+{
+    int i = 0;
+#ifdef TTPLAYER_HAVE_SSE2
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xff000000u));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i alpha = _mm_and_si128(s, opaque);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, opaque)) == 0xffff) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), s);
+        } else if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) != 0xffff) {
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), blendPixels(d, s));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint32_t s = src[i];
+        if (s >= 0xff000000u) {
+            dst[i] = s;
+        } else if (s != 0) {
+            dst[i] = blendPixel(dst[i], s);
+        }
+    }
+}
+
+/**
+ * @brief 用同一个预乘颜色对一行像素做 src-over（峰值指示器、节拍细条）
+ */
+inline void blendSolid(uint32_t* dst, uint32_t color, int count)
+{
+    if (color == 0) {
+        return;
+    }
+    int i = 0;
+    if (color >= 0xff000000u) {
+        for (; i < count; ++i) {
+            dst[i] = color;
+        }
+        return;
+    }
+#ifdef TTPLAYER_HAVE_SSE2
+    const __m128i s = _mm_set1_epi32(static_cast<int>(color));
+    for (; i + 4 <= count; i += 4) {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), blendPixels(d, s));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = blendPixel(dst[i], color);
+    }
+}
+
+} // namespace simd
+
+#endif // TTPLAYER_SIMDKERNELS_H
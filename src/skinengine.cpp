@@ -270,6 +270,17 @@ QColor SkinEngine::getSpectrumBottomColor() const { return m_config.visual.spect
 QColor SkinEngine::getSpectrumMidColor() const { return m_config.visual.spectrumMid; }
 QColor SkinEngine::getSpectrumPeakColor() const { return m_config.visual.spectrumPeak; }
 
+BandLayout SkinEngine::getSpectrumLayout() const
+{
+    const QString& scale = m_config.visual.spectrumScale;
+    const int bars = m_config.visual.spectrumBars > 0 ? m_config.visual.spectrumBars : 41;
+    if (scale == "cqt")
+        return BandLayout::constantQ(bars);
+    if (scale == "octave")
+        return BandLayout::fractionalOctave(3);
+    return BandLayout::logarithmic(bars);
+}
+
 QColor SkinEngine::getLyricTextColor() const { return m_config.lyric.textColor; }
 QColor SkinEngine::getLyricHighlightColor() const { return m_config.lyric.highlightColor; }
 
@@ -24,6 +24,7 @@
 // 使用轻量级配置结构体（与 skinsparser 共享同一套数据结构定义）
 // 将 skinparser.h 的核心类型直接引入
 #include "skinparser.h"
+#include "spectrumprocessor.h"   // BandLayout
 
 class SkinEngine : public QObject
 {
@@ -84,6 +85,9 @@ public:
     QColor getSpectrumMidColor() const;
     QColor getSpectrumPeakColor() const;
 
+    // 皮肤指定的频谱频带布局（Visual.xml 的 scale / bars 属性）
+    BandLayout getSpectrumLayout() const;
+
     QColor getLyricTextColor() const;
     QColor getLyricHighlightColor() const;
     QFont getLyricFont() const;
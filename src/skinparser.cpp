@@ -171,6 +171,8 @@ bool SkinParser::parseVisualXml(const QString& xmlPath, SkinConfig& config)
                 if (a.hasAttribute("peak_color"))    config.visual.spectrumPeak    = parseColor(a.value("peak_color").toString());
                 if (a.hasAttribute("blur"))          config.visual.blurEnabled    = (a.value("blur").toString() == "1");
                 if (a.hasAttribute("blur_speed"))    config.visual.blurSpeed      = a.value("blur_speed").toString().toInt();
+                if (a.hasAttribute("scale"))         config.visual.spectrumScale  = a.value("scale").toString().toLower();
+                if (a.hasAttribute("bars"))          config.visual.spectrumBars   = a.value("bars").toString().toInt();
             }
         }
     }
@@ -70,6 +70,8 @@ struct SkinConfig {
         QColor spectrumPeak;
         bool blurEnabled = false;
         int blurSpeed = 3;
+        QString spectrumScale = "log";   // 频带布局：log / octave / cqt
+        int spectrumBars = 41;           // log / cqt 布局的柱数量
     } visual;
 
     struct {
@@ -0,0 +1,199 @@
+/*
+ * SpectrumAnalyzer 实现
+ */
+#include "spectrumanalyzer.h"
+
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+SpectrumAnalyzer::SpectrumAnalyzer(QObject* parent)
+    : QThread(parent)
+{
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stopAnalysis();
+    wait();
+}
+
+void SpectrumAnalyzer::setResultCallback(ResultCallback callback)
+{
+    QMutexLocker locker(&m_mutex);
+    m_callback = callback;
+}
+
+void SpectrumAnalyzer::setLayout(const BandLayout& layout)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pendingLayout = layout;
+    m_layoutChanged = true;
+    m_wantBins = layout.scale == BandLayout::ConstantQ;
+}
+
+void SpectrumAnalyzer::setWaveformTap(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_wantWaveform = enabled;
+}
+
+void SpectrumAnalyzer::submit(const SpectrumFrame& frame, int sampleRate)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // 队列满：丢弃最旧的一帧，保证解码线程永不阻塞；下一帧之前缺了一帧，时间轴不再连续
+    if (m_count == kQueueDepth) {
+        m_head = (m_head + 1) % kQueueDepth;
+        --m_count;
+        if (m_count > 0) {
+            m_queue[m_head].discontinuity = true;
+        }
+    }
+
+    Frame& slot = m_queue[(m_head + m_count) % kQueueDepth];
+    const size_t total = static_cast<size_t>(frame.planeCount) * frame.binCount;
+    if (m_wantBins && frame.bins[0]) {
+        // 常数 Q 只需要复数谱，不再拷贝幅度
+        slot.magnitudes.clear();
+        slot.bins.resize(total);   // 容量稳定后不再分配
+        for (int p = 0; p < frame.planeCount; ++p) {
+            std::copy(frame.bins[p], frame.bins[p] + frame.binCount,
+                      slot.bins.begin() + static_cast<size_t>(p) * frame.binCount);
+        }
+    } else {
+        slot.bins.clear();
+        slot.magnitudes.resize(total);  // 容量稳定后不再分配
+        for (int p = 0; p < frame.planeCount; ++p) {
+            std::copy(frame.planes[p], frame.planes[p] + frame.binCount,
+                      slot.magnitudes.begin() + static_cast<size_t>(p) * frame.binCount);
+        }
+    }
+    if (m_wantWaveform && frame.samples[0]) {
+        const int sampleCount = frame.binCount * 2;
+        slot.samples.resize(static_cast<size_t>(frame.planeCount) * sampleCount);
+        for (int p = 0; p < frame.planeCount; ++p) {
+            std::copy(frame.samples[p], frame.samples[p] + sampleCount,
+                      slot.samples.begin() + static_cast<size_t>(p) * sampleCount);
+        }
+        slot.sampleCount = sampleCount;
+    } else {
+        slot.samples.clear();
+        slot.sampleCount = 0;
+    }
+    slot.binCount = frame.binCount;
+    slot.planeCount = frame.planeCount;
+    slot.sampleRate = sampleRate;
+    slot.hopSize = frame.hopSize;
+    slot.discontinuity = frame.discontinuity;
+    ++m_count;
+
+    m_frameReady.wakeOne();
+}
+
+void SpectrumAnalyzer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_head = 0;
+    m_count = 0;
+    m_resetRequested = true;
+}
+
+void SpectrumAnalyzer::stopAnalysis()
+{
+    requestInterruption();
+    QMutexLocker locker(&m_mutex);
+    m_frameReady.wakeAll();
+}
+
+void SpectrumAnalyzer::run()
+{
+    qDebug() << "[SpectrumAnalyzer] 分析线程启动";
+
+    while (!isInterruptionRequested()) {
+        ResultCallback callback;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_count == 0 && !isInterruptionRequested()) {
+                m_frameReady.wait(&m_mutex);
+            }
+            if (isInterruptionRequested()) break;
+
+            // 交换出一帧（swap 不分配，槽位保留本线程上一帧的容量）
+            std::swap(m_work, m_queue[m_head]);
+            m_head = (m_head + 1) % kQueueDepth;
+            --m_count;
+
+            if (m_layoutChanged) {
+                m_processor.setLayout(m_pendingLayout);
+                m_layoutChanged = false;
+            }
+            if (m_resetRequested) {
+                m_processor.reset();
+                m_onsets.reset();
+                m_resetRequested = false;
+            }
+            callback = m_callback;
+        }
+
+        // 格式变化（如 44.1kHz → 48kHz）时自动重建频带查找表
+        if (m_processor.configure(m_work.sampleRate, m_work.binCount * 2)) {
+            qDebug() << "[SpectrumAnalyzer] 频带表已重建, sampleRate=" << m_work.sampleRate
+                     << "fftSize=" << m_work.binCount * 2
+                     << "bars=" << m_processor.barCount();
+        }
+
+        // 锁外做全部可视化数学运算
+        const size_t second = m_work.planeCount > 1 ? m_work.binCount : 0;
+        const float* onsetInput = m_work.magnitudes.data();
+        if (m_processor.needsComplexBins()) {
+            // 布局切换前入队的帧只有幅度谱，直接丢弃
+            if (m_work.bins.empty()) continue;
+            const FftComplex* planes[SpectrumProcessor::kMaxPlanes] = {
+                m_work.bins.data(), m_work.bins.data() + second
+            };
+            m_processor.processComplex(planes, m_work.planeCount, m_work.binCount);
+
+            m_onsetMagnitudes.resize(m_work.binCount);   // 容量稳定后不再分配
+            for (int k = 0; k < m_work.binCount; ++k) {
+                const FftComplex& bin = m_work.bins[k];
+                m_onsetMagnitudes[k] = std::sqrt(bin.r * bin.r + bin.i * bin.i);
+            }
+            onsetInput = m_onsetMagnitudes.data();
+        } else {
+            if (m_work.magnitudes.empty()) continue;
+            const float* planes[SpectrumProcessor::kMaxPlanes] = {
+                m_work.magnitudes.data(), m_work.magnitudes.data() + second
+            };
+            m_processor.process(planes, m_work.planeCount, m_work.binCount);
+        }
+
+        // 起始点检测与实时节拍估计（第一个平面：单声道下混 / L / M）
+        // 包络按 sampleRate / hopSize 的帧率解释，跳转或丢帧之后从头积累，不把两段拼在一起
+        if (m_work.discontinuity) {
+            m_onsets.reset();
+        }
+        BeatInfo beat;
+        m_onsets.configure(m_work.sampleRate, m_work.binCount * 2, m_work.hopSize);
+        beat.onset = m_onsets.process(onsetInput);
+        beat.strength = beat.onset ? m_onsets.onsetStrength() : 0.0f;
+        beat.bpm = m_onsets.tempo().bpm;
+        beat.confidence = m_onsets.tempo().confidence;
+
+        if (callback) {
+            WaveformTap tap;
+            if (m_work.sampleCount > 0) {
+                tap.planeCount = m_work.planeCount;
+                tap.sampleCount = m_work.sampleCount;
+                tap.sampleRate = m_work.sampleRate;
+                for (int p = 0; p < m_work.planeCount; ++p) {
+                    tap.planes[p] = m_work.samples.data() + static_cast<size_t>(p) * m_work.sampleCount;
+                }
+            }
+            callback(m_processor, tap, beat);
+        }
+    }
+
+    qDebug() << "[SpectrumAnalyzer] 分析线程退出";
+}
@@ -0,0 +1,120 @@
+/*
+ * SpectrumAnalyzer - 独立的频谱分析线程
+ *
+ * 解码线程只负责把 STFT 幅度谱拷贝进一个固定容量的帧队列（短暂加锁），
+ * 所有频谱相关的数学运算（频带映射、A计权、卷积）都在本线程中
+ * 由 SpectrumProcessor 完成，因此解码永远不会被可视化拖慢。
+ *
+ * 队列满时丢弃最旧的帧；空闲时线程阻塞在 QWaitCondition 上，不占用 CPU。
+ * 开启波形抽头后，同一帧的时域样本也随结果一起交给回调（示波器等波形显示使用）。
+ * 每帧同时经过 OnsetDetector 做谱通量起始点检测和实时节拍估计（视觉节拍脉冲使用）。
+ */
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <array>
+#include <vector>
+#include <functional>
+
+#include "spectrumprocessor.h"
+#include "onsetdetector.h"
+#include "stft.h"
+
+class SpectrumAnalyzer : public QThread
+{
+public:
+    /**
+     * @brief 与频谱同一帧的时域样本（未开启波形抽头时 sampleCount 为 0）
+     */
+    struct WaveformTap {
+        const float* planes[SpectrumProcessor::kMaxPlanes] = {nullptr, nullptr};  // 最旧样本在前
+        int planeCount = 0;
+        int sampleCount = 0;
+        int sampleRate = 0;
+    };
+
+    /**
+     * @brief 同一帧的起始点检测结果（基于第一个平面的原始幅度谱）
+     */
+    struct BeatInfo {
+        bool onset = false;         // 本帧确认了一个起始点
+        float strength = 0.0f;      // 该起始点的相对强度，0~1
+        float bpm = 0.0f;           // 实时节拍估计，0 表示尚未确定
+        float confidence = 0.0f;
+    };
+
+    // 结果回调：运行在分析线程中，不得调用任何 GUI 操作
+    typedef std::function<void(const SpectrumProcessor&, const WaveformTap&, const BeatInfo&)> ResultCallback;
+
+    explicit SpectrumAnalyzer(QObject* parent = nullptr);
+    ~SpectrumAnalyzer();
+
+    void setResultCallback(ResultCallback callback);
+
+    /**
+     * @brief 更换频带布局（在分析线程处理下一帧前生效）
+     */
+    void setLayout(const BandLayout& layout);
+
+    /**
+     * @brief 开启 / 关闭波形抽头（关闭时 submit 不拷贝时域样本）
+     */
+    void setWaveformTap(bool enabled);
+
+    /**
+     * @brief 提交一帧原始幅度谱（由解码线程调用，只做一次 memcpy）
+     * @param frame 1~2 个平面的 N/2 点原始 FFT 幅度（FFT 长度由此推得）；
+     *              常数 Q 布局下改为拷贝复数频谱
+     * @param sampleRate 该帧的采样率；与上一帧不同时自动重建频带表
+     */
+    void submit(const SpectrumFrame& frame, int sampleRate);
+
+    // 清空待处理帧和处理器工作缓冲（切歌时调用）
+    void clear();
+
+    // 请求线程退出并唤醒等待
+    void stopAnalysis();
+
+protected:
+    void run() override;
+
+private:
+    static constexpr int kQueueDepth = 8;
+
+    struct Frame {
+        std::vector<float> magnitudes;   // planeCount 个平面首尾相接
+        std::vector<FftComplex> bins;    // 同上（仅常数 Q 布局时填充）
+        std::vector<float> samples;      // 同上，每平面 sampleCount 个时域样本（仅开启波形抽头时填充）
+        int sampleCount = 0;
+        int binCount = 0;
+        int planeCount = 1;
+        int sampleRate = 0;
+        int hopSize = 0;
+        bool discontinuity = false;      // 与上一帧之间时间轴不连续（解码器跳转或队列丢帧）
+    };
+
+    QMutex m_mutex;
+    QWaitCondition m_frameReady;
+
+    // 固定容量环形帧队列（受 m_mutex 保护）
+    std::array<Frame, kQueueDepth> m_queue;
+    int m_head = 0;                 // 下一个待读帧
+    int m_count = 0;                // 待处理帧数
+    BandLayout m_pendingLayout;
+    bool m_layoutChanged = false;
+    bool m_wantBins = false;        // 待生效布局是否需要复数频谱
+    bool m_wantWaveform = false;    // 是否拷贝时域样本
+    bool m_resetRequested = false;
+
+    // 以下仅分析线程访问
+    Frame m_work;
+    SpectrumProcessor m_processor;
+    OnsetDetector m_onsets;
+    std::vector<float> m_onsetMagnitudes;   // 常数 Q 帧只有复数谱，起始点检测前在此求模
+    ResultCallback m_callback;
+};
+
+#endif // SPECTRUMANALYZER_H
@@ -8,6 +8,7 @@
  *          spectrum visualization during music playback)
  */
 #include "spectrumbars.h"
+#include "temposcanner.h"
 #include <QPainter>
 #include <QPainterPath>
 #ifdef QT_MULTIMEDIA_ENABLED
@@ -18,8 +19,59 @@
 #include <QtMath>
 #include <QDebug>
 #include <QDateTime>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
+#include <QApplication>
 #include <cmath>
 
+namespace {
+
+/**
+ * @brief 示波器触发：查找上升沿过零点，使相邻帧的波形对齐而不左右漂移
+ * @param samples 时域样本（最旧在前）
+ * @param count 样本数
+ * @param window 触发点之后需要保留的显示长度
+ * @return 触发点下标；找不到时返回最新的一段
+ *
+ * 带迟滞：信号先低于 -hysteresis 才允许触发，避免静音底噪附近反复误触发。
+ */
+int findScopeTrigger(const float *samples, int count, int window)
+{
+    const int limit = count - window;
+    if (limit <= 1) {
+        return 0;
+    }
+
+    float peak = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        peak = qMax(peak, std::fabs(samples[i]));
+    }
+    const float hysteresis = 0.1f * peak;
+
+    bool armed = false;
+    for (int i = 1; i <= limit; ++i) {
+        if (samples[i] < -hysteresis) {
+            armed = true;
+        } else if (armed && samples[i - 1] < 0.0f && samples[i] >= 0.0f) {
+            return i;
+        }
+    }
+    return limit;
+}
+
+// Qt5 / Qt6 全局坐标
+QPoint globalPoint(const QMouseEvent *event)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return event->globalPosition().toPoint();
+#else
+    return event->globalPos();
+#endif
+}
+
+} // namespace
+
 
 /**
  * @brief 构造函数
@@ -29,38 +81,32 @@ SpectrumBars::SpectrumBars(QWidget *parent)
 #ifdef QT_MULTIMEDIA_ENABLED
       m_mediaPlayer(nullptr),
 #endif
-      m_updateTimer(new QTimer(this)),
-      m_timerId(0),
-      m_peakDecay(0.05),
-      m_peakAnimation(new QPropertyAnimation(this, "peakDecay")),
+      m_frameClock(new QTimer(this)),
       m_sampleRate(44100),
       m_channelCount(2),
-      m_spectrumDirty(false),
-      m_mp3Decoder(new MP3Decoder(this))
-{
-    // 设置默认颜色
-    m_topColor = QColor("#8CEFFD");
-    m_bottomColor = QColor("#71CDFD");
-    m_midColor = QColor("#4C5FD1");
-    m_peakColor = QColor("#FF71CD");
-    
-    // 初始化频谱数据数组
-    m_spectrum.resize(kBarsAmount, 0.0f);
-    m_peakPositions.resize(kBarsAmount, 0.0f);
-    m_smoothedSpectrum.resize(kBarsAmount, 0.0f);
+      m_mp3Decoder(new MP3Decoder(this)),
+      m_analyzer(new SpectrumAnalyzer(this))
+{
+    // 默认配色与柱宽由 SpectrumRenderer 提供
+
+    // 初始化频谱数据（显示快照为固定容量数组，无需分配）
+    m_displayBarCount = SpectrumProcessor::barCountFor(m_bandLayout);
+    m_dynamics.setSlotCount(m_displayBarCount);
 
     // 初始化 auto-scale 历史缓冲区（原始幅度值域，100 是典型音乐的中等值）
     m_maxHistory.resize(kScaleHistorySize, 100.0f);
     
-    // 设置峰值衰减动画（更快响应）
-    m_peakAnimation->setDuration(150);
-    m_peakAnimation->setStartValue(0.05);    // 中等衰减
-    m_peakAnimation->setEndValue(0.4);       // 较快衰减
-    m_peakAnimation->setLoopCount(-1);       // 无限循环
-    m_peakAnimation->start();
-    
-    // 启动动画定时器
-    m_timerId = startTimer(16);
+    // 单一帧时钟：每个显示刷新周期推进一次动态模型并调度重绘；停止播放且柱子回落后自动停止
+    m_frameClock->setTimerType(Qt::PreciseTimer);
+    connect(m_frameClock, &QTimer::timeout, this, &SpectrumBars::updateFrame);
+
+    // 媒体库扫描完成当前歌曲后改用整首歌的节拍
+    connect(&TempoScanner::instance(), &TempoScanner::tempoReady, this, [this](const QString &path, float bpm) {
+        if (path == m_currentFilePath) {
+            m_trackTempo = bpm;
+            updateTempoToolTip();
+        }
+    });
     
     // 确保部件可见
     setVisible(true);
@@ -70,8 +116,55 @@ SpectrumBars::SpectrumBars(QWidget *parent)
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
     setMinimumHeight(40);
     
-    //
-    calculateLogFrequencyMapping();
+    // 分析结果回调运行在分析线程中：写入生产者独占的快照缓冲后发布，
+    // 不加锁、不调用 GUI 操作，GUI 线程也永远不会因此阻塞
+    m_analyzer->setResultCallback([this](const SpectrumProcessor& processor,
+                                         const SpectrumAnalyzer::WaveformTap& tap,
+                                         const SpectrumAnalyzer::BeatInfo& beat) {
+        SpectrumSnapshot& snap = m_snapshots.writeBuffer();
+        const int barCount = processor.barCount();
+        snap.barCount = barCount;
+        snap.planeCount = processor.planeCount();
+
+        for (int plane = 0; plane < snap.planeCount; ++plane) {
+            const float* bars = processor.bars(plane);
+            std::copy(bars, bars + barCount, snap.bars.begin() + plane * barCount);
+        }
+
+        // 示波器：以第一平面的触发点为准截取波形，两个平面保持同一时间对齐
+        snap.scopeCount = 0;
+        if (tap.sampleCount > 0) {
+            const int scopeCount = qMin(kScopeSamples, tap.sampleCount);
+            const int start = findScopeTrigger(tap.planes[0], tap.sampleCount, scopeCount);
+            for (int plane = 0; plane < tap.planeCount; ++plane) {
+                std::copy(tap.planes[plane] + start, tap.planes[plane] + start + scopeCount,
+                          snap.scope.begin() + plane * scopeCount);
+            }
+            snap.scopeCount = scopeCount;
+        }
+
+        // 节拍：GUI 线程比较序号即可知道两次读取之间是否出现过起始点
+        if (beat.onset) {
+            ++m_onsetSerial;
+            m_onsetStrength = beat.strength;
+        }
+        snap.onsetSerial = m_onsetSerial;
+        snap.onsetStrength = m_onsetStrength;
+        snap.tempo = beat.bpm;
+
+        // 诊断日志
+        static int diagCounter = 0;
+        if (++diagCounter >= 300 && barCount > 0) {
+            diagCounter = 0;
+            qDebug() << "[SPEC-DBG]"
+                     << " bar[0]=" << snap.bars[0]
+                     << " bar[mid]=" << snap.bars[barCount / 2]
+                     << " bar[last]=" << snap.bars[barCount - 1];
+        }
+
+        m_snapshots.publish();
+    });
+    m_analyzer->start(QThread::LowPriority);
 
     // 输出调试信息
     qDebug("SpectrumBars initialized with size: %d x %d", width(), height());
@@ -79,14 +172,18 @@ SpectrumBars::SpectrumBars(QWidget *parent)
 
 SpectrumBars::~SpectrumBars()
 {
-    if (m_timerId) {
-        killTimer(m_timerId);
-    }
-    
+    m_frameClock->stop();
+
     if (m_mp3Decoder) {
         m_mp3Decoder->stopDecoding();
         m_mp3Decoder->wait();
     }
+
+    // 解码线程已停止，不会再有新帧提交
+    if (m_analyzer) {
+        m_analyzer->stopAnalysis();
+        m_analyzer->wait();
+    }
 }
 
 /**
@@ -126,9 +223,7 @@ void SpectrumBars::setMediaPlayer(QMediaPlayer *player)
 
         // 监听播放状态变化，用于同步频谱显示状态
         connect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged, this, &SpectrumBars::handlePlaybackStateChanged);
-
-        connect(m_updateTimer, &QTimer::timeout, this, &SpectrumBars::updateFrame);
-        // 注意：不在此处启动定时器，等 PlayingState 时再启动
+        // 注意：不在此处启动帧时钟，等 PlayingState 时再启动
     }
 }
 #endif // QT_MULTIMEDIA_ENABLED
@@ -144,43 +239,15 @@ void SpectrumBars::handlePlaybackStateChanged(QMediaPlayer::PlaybackState state)
 {
     // 根据播放状态控制频谱更新
     if (state == QMediaPlayer::PlayingState) {
-        // 播放状态：启用频谱更新
-        if (!m_updateTimer->isActive()) {
-            m_updateTimer->start(10);
-        }
-
-        // 重新启动动画定时器（如果已停止）
-        if (m_timerId == 0) {
-            m_timerId = startTimer(16);
-        }
+        // 播放状态：唤醒解码线程并启动帧时钟
+        updateDecoderActivity();
+        startFrameClock();
     } else {
-        // 暂停状态：更新一次频谱以匹配当前位置
+        // 暂停或停止状态：挂起解码线程，帧时钟继续运行到柱子按释放时间常数回落为止
+        updateDecoderActivity();
         if (m_mediaPlayer) {
             updateForPosition(m_mediaPlayer->position());
         }
-
-        // 暂停或停止状态：暂停频谱更新
-        if (m_updateTimer->isActive()) {
-            m_updateTimer->stop();
-
-            // 清空频谱数据，使其静止
-            {
-                QMutexLocker locker(&m_spectrumMutex);
-                for (int i = 0; i < kBarsAmount; ++i) {
-                    m_spectrum[i] *= 0.3f;
-                    m_smoothedSpectrum[i] *= 0.3f;
-                    m_peakPositions[i] = m_smoothedSpectrum[i];
-                }
-            }
-            // 在锁外调用 update()
-            update();
-        }
-
-        // 停止动画定时器
-        if (m_timerId) {
-            killTimer(m_timerId);
-            m_timerId = 0;
-        }
     }
 }
 #endif // QT_MULTIMEDIA_ENABLED
@@ -209,117 +276,24 @@ void SpectrumBars::tryGetRealAudioData()
         return;
     }
 
-    if (m_mp3Decoder->openFile(m_currentFilePath)) {
-        // 回调运行在解码器子线程中，只更新数据，不调用 GUI 操作（如 update）
-        // 完整流水线：频带映射 → bass衰减 → dB门限映射 → 帧间平滑
-        // 完整流水线（严格遵循 AudioSpectrum 的算法）
-        // Step 1: FFT归一化 + 对数频带映射
-        // Step 2: A计权感知加权（替代 bass 衰减，更科学）
-        // Step 3: 增益放大（AudioSpectrum 用 *5）
-        // Step 4: 空间平滑（卷积核 [1,2,3,5,3,2,1]）
-        // Step 5: 时间平滑（EMA）
-        // ================================================================
-        m_mp3Decoder->setSpectrumCallback([this](const std::vector<float>& rawSpectrum) {
-            QMutexLocker locker(&m_spectrumMutex);
-
-            if (m_spectrum.size() != kBarsAmount) {
-                m_spectrum.resize(kBarsAmount, 0.0f);
-                m_peakPositions.resize(kBarsAmount, 0.0f);
-                m_smoothedSpectrum.resize(kBarsAmount, 0.0f);
-            }
-
-            const int fftSize = FFT_SIZE;  // 归一化因子
-            constexpr float kGain = 20.0f;  // 增益放大（原 AudioSpectrum 用 *5，此处需更大以补偿 A计权衰减和 EMA 压缩）
-
-            // --- Step 1 & 2: Log-freq band mapping + FFT归一化 + A计权 ---
-            for (int bar = 0; bar < kBarsAmount; ++bar) {
-                int startBin = (bar == 0) ? 2 : m_logMapping[bar - 1];
-                int endBin = m_logMapping[bar];
-
-                float maxMag = 0.0f;
-                for (int bin = startBin; bin < endBin && bin < rawSpectrum.size(); ++bin) {
-                    maxMag = qMax(maxMag, rawSpectrum[bin]);
-                }
-
-                // FFT 归一化（AudioSpectrum: fftNormFactor = 1/fftSize）
-                float normalized = maxMag / static_cast<float>(fftSize);
-
-                // --- Step 2: A计权感知加权 ---
-                // 计算该 bar 的中心频率
-                float centerFreq = 0.0f;
-                for (int bin = startBin; bin < endBin && bin < rawSpectrum.size(); ++bin) {
-                    centerFreq += bin * (static_cast<float>(m_sampleRate) / fftSize);
-                }
-                int binCount = qMax(1, endBin - startBin);
-                centerFreq /= binCount;
-
-                // A计权近似公式（简化版，对 20Hz~20kHz 有效）
-                // 参考 IEC 61672-1 标准的 A-weighting 曲线
-                float f2 = centerFreq * centerFreq;
-                float ra = 12194.0f * 12194.0f;
-                float aWeight = 1.2589f * ra * f2 * f2 /
-                    ((f2 + 20.6f) * sqrt((f2 + 107.7f) * (f2 + 737.9f)) *
-                     (f2 + ra));
-                aWeight = std::max(aWeight, 0.001f);  // 防止除零或负值
-
-                normalized *= aWeight;
-
-                // --- Step 3: 增益放大 ---
-                m_spectrum[bar] = normalized * kGain;
-            }
-
-            // --- Step 4: 空间平滑（AudioSpectrum 的 highlightWaveform 卷积）---
-            // 卷积核: [1, 2, 3, 5, 3, 2, 1] (权重和=17)
-            // 效果：锐化波峰、填充凹陷，使频谱更连贯饱满
-            static constexpr int kernelSize = 7;
-            static constexpr float kernel[kernelSize] = {1.0f, 2.0f, 3.0f, 5.0f, 3.0f, 2.0f, 1.0f};
-            static constexpr float kernelSum = 17.0f;
-
-            std::vector<float> smoothed(kBarsAmount);
-            for (int bar = 0; bar < kBarsAmount; ++bar) {
-                float convVal = 0.0f;
-                for (int ki = 0; ki < kernelSize; ++ki) {
-                    int neighborIdx = bar + ki - kernelSize / 2;
-                    if (neighborIdx >= 0 && neighborIdx < kBarsAmount) {
-                        convVal += m_spectrum[neighborIdx] * kernel[ki];
-                    } else {
-                        convVal += m_spectrum[bar] * kernel[ki];  // 边界外复制自身
-                    }
-                }
-                smoothed[bar] = convVal / kernelSum;
-            }
-            m_spectrum = std::move(smoothed);
-
-            // --- Step 5: 时间平滑（EMA，AudioSpectrum 的 spectrumSmooth=0.5）---
-            for (int bar = 0; bar < kBarsAmount; ++bar) {
-                // AudioSpectrum 公式: newValue = oldValue * smooth + current * (1-smooth)
-                const float smooth = 0.55f;  // 比 AudioSpectrum 的 0.5 稍粘滞一点
-                m_smoothedSpectrum[bar] =
-                    m_smoothedSpectrum[bar] * smooth + m_spectrum[bar] * (1.0f - smooth);
-
-                // 峰值指示器
-                if (m_smoothedSpectrum[bar] > m_peakPositions[bar]) {
-                    m_peakPositions[bar] = m_smoothedSpectrum[bar];
-                } else {
-                    m_peakPositions[bar] -= m_peakDecay;
-                    m_peakPositions[bar] = qMax(m_peakPositions[bar], m_smoothedSpectrum[bar]);
-                }
-            }
+    // 丢弃上一首歌残留的待处理帧
+    m_analyzer->clear();
 
-            // 诊断日志
-            static int diagCounter = 0;
-            if (++diagCounter >= 300) {
-                diagCounter = 0;
-                qDebug() << "[SPEC-DBG]"
-                         << " bar[0]=" << m_smoothedSpectrum[0]
-                         << " bar[10]=" << m_smoothedSpectrum[10]
-                         << " bar[20]=" << m_smoothedSpectrum[20]
-                         << " bar[40]=" << m_smoothedSpectrum[40];
-            }
+    // 节拍：媒体库扫描过的歌曲直接使用整首歌的结果，否则等待实时估计
+    m_liveTempo = 0.0f;
+    m_trackTempo = TempoScanner::instance().tempo(m_currentFilePath);
+    updateTempoToolTip();
 
-            m_spectrumDirty = true;
-        });
+    // 回调运行在解码器子线程中：只把幅度谱交给分析线程，不做任何可视化运算
+    // 完整流水线（频带映射 → A计权 → 增益 → 空间平滑）见 SpectrumProcessor，
+    // 时间平滑和峰值由 GUI 线程的 SpectrumDynamics 按实际帧间隔完成
+    m_mp3Decoder->setSpectrumCallback([this](const SpectrumFrame& frame, int sampleRate) {
+        m_analyzer->submit(frame, sampleRate);
+    });
 
+    // 媒体刚加载完成时通常尚未开始播放：解码线程启动后先挂起，开始播放时再唤醒
+    updateDecoderActivity();
+    if (m_mp3Decoder->openFile(m_currentFilePath)) {
         // 媒体加载完成后，设置获取的音频参数
         m_sampleRate = m_mp3Decoder->sampleRate();
         m_channelCount = m_mp3Decoder->channels();
@@ -333,13 +307,77 @@ void SpectrumBars::tryGetRealAudioData()
 void SpectrumBars::setColors(const QColor &topColor, const QColor &bottomColor,
                                const QColor &midColor, const QColor &peakColor)
 {
-    m_topColor = topColor;
-    m_bottomColor = bottomColor;
-    m_midColor = midColor;
-    m_peakColor = peakColor;
+    m_renderer.setColors(topColor, bottomColor, midColor, peakColor);
+    m_spectrogramDirty = true;
+    invalidateBackground();   // 换肤时总会调用，背景图随之变化
+}
+
+/**
+ * @brief 设置频带布局
+ */
+void SpectrumBars::setBandLayout(const BandLayout &layout)
+{
+    if (layout == m_bandLayout) {
+        return;
+    }
+
+    m_bandLayout = layout;
+    m_displayBarCount = SpectrumProcessor::barCountFor(layout);
+    m_dynamics.setSlotCount(m_displayPlaneCount * m_displayBarCount);
+    m_dynamics.reset();
+    m_analyzer->setLayout(layout);
+    m_mp3Decoder->setFftSize(SpectrumProcessor::fftSizeFor(layout));  // 常数 Q 需要更长的窗口
+    syncDisplay(true);
+}
+
+/**
+ * @brief 设置频谱分析的声道模式
+ */
+void SpectrumBars::setChannelMode(StftAnalyzer::ChannelMode mode)
+{
+    m_channelMode = mode;
+    m_mp3Decoder->setChannelMode(mode);
     update();
 }
 
+/**
+ * @brief 设置双平面频谱的绘制方式
+ */
+void SpectrumBars::setStereoLayout(StereoLayout layout)
+{
+    m_renderer.setStereoLayout(layout);
+    syncDisplay(true);
+}
+
+/**
+ * @brief 设置显示模式
+ */
+void SpectrumBars::setVisualMode(VisualMode mode)
+{
+    if (mode == m_visualMode) {
+        return;
+    }
+
+    m_visualMode = mode;
+    m_analyzer->setWaveformTap(mode == Oscilloscope);   // 只有示波器需要时域样本
+    m_scopeCount = 0;
+    m_spectrogramDirty = true;                          // 重新进入瀑布图时从空白开始
+    qDebug() << "[SpectrumBars] 显示模式:" << mode;
+    syncDisplay(true);
+}
+
+/**
+ * @brief 依次切换显示模式：频谱柱 → 示波器 → 频谱瀑布图 → 频谱柱
+ */
+void SpectrumBars::cycleVisualMode()
+{
+    switch (m_visualMode) {
+    case Bars:         setVisualMode(Oscilloscope); break;
+    case Oscilloscope: setVisualMode(Spectrogram); break;
+    case Spectrogram:  setVisualMode(Bars); break;
+    }
+}
+
 // 实现setBarSize方法，允许自定义频谱柱的宽度和间距
 void SpectrumBars::setBarSize(int width, int spacing)
 {
@@ -348,10 +386,9 @@ void SpectrumBars::setBarSize(int width, int spacing)
         return;
     }
     
-    m_barWidth = width;
-    m_barSpacing = spacing;
+    m_renderer.setBarSize(width, spacing);   // 渐变条宽度跟随柱宽
     
-    update();
+    syncDisplay(true);
 }
 
 /**
@@ -375,98 +412,104 @@ void SpectrumBars::updateForPosition(qint64 position)
     // 更新解码器位置
     m_mp3Decoder->setPosition(position);
 
-    // 如果播放器处于播放状态，确保更新定时器正在运行
+    // 由帧时钟推进动态模型：播放时跟随新位置的频谱，否则回落到静止
+    startFrameClock();
+}
+
+
+/**
+ * @brief 播放器是否处于播放状态
+ */
+bool SpectrumBars::isPlaying() const
+{
 #ifdef QT_MULTIMEDIA_ENABLED
-    if (m_mediaPlayer && m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
+    return m_mediaPlayer && m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState;
 #else
-    if (true) {  // 无 Multimedia 时始终允许更新
+    return false;
 #endif
-        if (!m_updateTimer->isActive()) {
-            m_updateTimer->start(10);
-        }
+}
 
-        // 确保动画定时器正在运行
-        if (m_timerId == 0) {
-            m_timerId = startTimer(16);
-        }
+/**
+ * @brief 解码线程只在正在播放且可见时工作
+ */
+void SpectrumBars::updateDecoderActivity()
+{
+    if (m_mp3Decoder) {
+        m_mp3Decoder->setActive(isPlaying() && m_onScreen);
     }
-
-    // 强制处理一次音频数据，立即更新频谱
-    processAudio();
-    update();
 }
 
-
 /**
- * @brief 处理音频数据，更新频谱显示
+ * @brief 推进解码位置
  */
 void SpectrumBars::processAudio()
 {
-    // 检查是否正在播放
-#ifdef QT_MULTIMEDIA_ENABLED
-    bool isPlaying = m_mediaPlayer && m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState;
-#else
-    bool isPlaying = false;
-#endif
-
     // 如果正在播放且MP3解码器已实例化，更新解码器的位置
-    if (isPlaying && m_mp3Decoder) {
+    if (isPlaying() && m_mp3Decoder) {
 #ifdef QT_MULTIMEDIA_ENABLED
-        static qint64 lastPosition = 0;
-        qint64 position = m_mediaPlayer->position();
-
-        // 确保位置总是有微小变化，强制解码器处理新帧
-        if (position == lastPosition) {
-            position += 1;
-        }
-        lastPosition = position;
-
-        m_mp3Decoder->setPosition(position);
+        // 解码器在两次位置更新之间按经过的时间外推，位置不变时不会重启外推
+        m_mp3Decoder->setPosition(m_mediaPlayer->position());
 
         // MP3解码器会通过回调更新频谱数据，这里不需要额外处理
 #endif
-    } else if (!isPlaying) {
-        // 如果没有播放，逐渐降低所有频谱柱的高度
-        {
-            QMutexLocker locker(&m_spectrumMutex);
-            for (int i = 0; i < kBarsAmount; ++i) {
-                // 缓慢降低频谱值（同时衰减平滑值）
-                m_spectrum[i] *= 0.92f;
-                m_smoothedSpectrum[i] *= 0.92f;
-
-                // 更新峰值位置
-                if (m_smoothedSpectrum[i] > m_peakPositions[i]) {
-                    m_peakPositions[i] = m_smoothedSpectrum[i];
-                } else {
-                    m_peakPositions[i] -= m_peakDecay;
-                    m_peakPositions[i] = qMax(m_peakPositions[i], m_smoothedSpectrum[i]);
-                }
-            }
-
-            m_spectrumDirty = true;
-        }
-        // 在锁外调用 update()，避免潜在的 paintEvent 重入风险
-        update();
     }
 }
 
 /**
- * @brief 更新频谱显示
+ * @brief 帧时钟回调：推进解码位置和动态模型，并调度重绘
+ *
+ * 柱高和峰值只在这里按实际经过的时间推进一次，快照到达的频率和帧率都不影响视觉速度。
  */
-void SpectrumBars::updateSpectrum()
-{
-    update();
-    m_spectrumDirty = false;
-}
-
 void SpectrumBars::updateFrame()
 {
     processAudio();      // 处理音频
-    updateSpectrum();    // 触发重绘
+
+    const bool playing = isPlaying();
+    bool freshSnapshot = false;
+    const bool layoutChanged = acquireSnapshot(&freshSnapshot);
+
+    // 帧间隔上限 100ms：窗口被拖动、系统卡顿后不会一步跳到终点
+    const float dt = qMin(m_frameTimer.restart(), qint64(100)) / 1000.0f;
+    m_dynamics.advance(playing ? m_targets.data() : nullptr, dt);
+
+    // 节拍脉冲按时间常数淡出，只在不透明度变化时失效顶部细条
+    m_beatPulse *= std::exp(-dt / kBeatPulseSeconds);
+    const int pulseAlpha = m_beatPulse > 0.02f ? qRound(m_beatPulse * 200.0f) : 0;
+    if (pulseAlpha != m_paintedPulseAlpha) {
+        m_paintedPulseAlpha = pulseAlpha;
+        update(beatStripRect());
+    }
+
+    switch (m_visualMode) {
+    case Bars:
+        syncDisplay(layoutChanged);  // 只重绘高度变化的柱子
+        break;
+    case Oscilloscope:
+        if (!playing) {
+            m_scopeCount = 0;        // 停止后回到一条水平线
+        }
+        update();
+        break;
+    case Spectrogram:
+        if (layoutChanged) {
+            m_spectrogramDirty = true;
+        }
+        // 每个新分析帧写入一列：滚动速度只跟随跳步长，不随刷新率、帧率上限或暂停变化
+        if (freshSnapshot) {
+            appendSpectrogramColumn();   // 只写入一列，历史列原样保留
+            update();                    // 整体左移一列：两次贴图即可完成
+        }
+        break;
+    }
+
+    // 不再播放且所有柱子都已回落：停止帧时钟，空闲时不占用 CPU
+    if (!playing && m_dynamics.settled() && m_paintedPulseAlpha == 0) {
+        m_frameClock->stop();
+    }
 #ifdef QT_MULTIMEDIA_ENABLED
     // 仅在正在播放且每秒输出一次（避免刷屏）
     static qint64 lastLogTime = 0;
-    if (m_mediaPlayer && m_mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
+    if (playing) {
         qint64 now = QDateTime::currentMSecsSinceEpoch();
         if (now - lastLogTime >= 1000) {
             lastLogTime = now;
@@ -478,115 +521,568 @@ void SpectrumBars::updateFrame()
 }
 
 /**
- * @brief 处理定时器事件，实现峰值指示器的平滑衰减动画效果
+ * @brief 设置帧率上限
+ */
+void SpectrumBars::setFrameRateCap(int fps)
+{
+    m_fpsCap = qMax(0, fps);
+    if (m_frameClock->isActive()) {
+        startFrameClock();   // 按新上限重新计算间隔
+    }
+}
+
+/**
+ * @brief 按所在屏幕刷新率（受 FPS 上限约束）启动帧时钟
+ */
+void SpectrumBars::startFrameClock()
+{
+    // 不可见时不启动，重新显示时由 showEvent 补上
+    if (!m_onScreen) {
+        return;
+    }
+
+    qreal fps = 60.0;
+    const QWindow *handle = window()->windowHandle();
+    const QScreen *screen = handle ? handle->screen() : QGuiApplication::primaryScreen();
+    if (screen && screen->refreshRate() > 1.0) {
+        fps = screen->refreshRate();
+    }
+    if (m_fpsCap > 0) {
+        fps = qMin(fps, static_cast<qreal>(m_fpsCap));
+    }
+
+    const int interval = qMax(1, qRound(1000.0 / fps));
+    if (!m_frameClock->isActive()) {
+        m_frameTimer.start();   // 重新开始计时，避免第一帧的 dt 包含停止期间
+        m_frameClock->start(interval);
+    } else if (m_frameClock->interval() != interval) {
+        m_frameClock->start(interval);
+    }
+}
+
+/**
+ * @brief 取出最新频谱快照作为动态模型的目标高度
+ *
+ * 快照通过三缓冲无锁交换取得（wait-free，不分配）；没有新快照时沿用上一份目标。
+ */
+bool SpectrumBars::acquireSnapshot(bool *fresh)
+{
+    const bool acquired = m_snapshots.acquire();
+    if (fresh) {
+        *fresh = acquired;
+    }
+    if (!acquired) {
+        return false;
+    }
+
+    const SpectrumSnapshot &snap = m_snapshots.readBuffer();
+    if (snap.scopeCount > 0) {
+        m_scopeCount = snap.scopeCount;
+        std::copy(snap.scope.begin(), snap.scope.begin() + snap.planeCount * snap.scopeCount, m_scope.begin());
+    }
+
+    bool changed = false;
+    if (snap.barCount != m_displayBarCount || snap.planeCount != m_displayPlaneCount) {
+        // 布局或声道模式切换后的第一帧
+        m_displayBarCount = snap.barCount;
+        m_displayPlaneCount = snap.planeCount;
+        m_dynamics.setSlotCount(m_displayPlaneCount * m_displayBarCount);
+        changed = true;
+    }
+    const int slots = m_displayPlaneCount * m_displayBarCount;
+    std::copy(snap.bars.begin(), snap.bars.begin() + slots, m_targets.begin());
+
+    if (snap.onsetSerial != m_seenOnsetSerial) {
+        m_seenOnsetSerial = snap.onsetSerial;
+        m_beatPulse = qMax(m_beatPulse, 0.4f + 0.6f * snap.onsetStrength);
+    }
+    if (snap.tempo != m_liveTempo) {
+        m_liveTempo = snap.tempo;
+        updateTempoToolTip();
+    }
+    return changed;
+}
+
+/**
+ * @brief 只失效高度变化的柱子
+ * @param force 整体重绘（布局、柱宽等变化时）
+ *
+ * 每根柱的柱高和峰值高度换算成像素后与上次失效时比较，
+ * 只有像素高度真正变化的柱子所在的整列会并入重绘区域。
  */
-void SpectrumBars::timerEvent(QTimerEvent *event)
+void SpectrumBars::syncDisplay(bool force)
 {
-    if (event->timerId() == m_timerId) {
-        // 动画峰值衰减（加锁保护跨线程安全）
-        QMutexLocker locker(&m_spectrumMutex);
-        for (int i = 0; i < m_peakPositions.size(); ++i) {
-            if (m_peakPositions[i] > m_spectrum[i]) {
-                m_peakPositions[i] -= m_peakDecay;
-                m_peakPositions[i] = qMax(m_peakPositions[i], m_spectrum[i]);
-                m_spectrumDirty = true;
+    if (force) {
+        m_paintedBars.fill(-1);
+        m_paintedPeaks.fill(-1);
+    }
+
+    const float *levels = m_dynamics.levels();
+    const float *peaks = m_dynamics.peaks();
+    QRect dirty;
+    for (int plane = 0; plane < m_displayPlaneCount; ++plane) {
+        for (int bar = 0; bar < m_displayBarCount; ++bar) {
+            const int i = plane * m_displayBarCount + bar;
+            const SpectrumRenderer::BarSlot slot = m_renderer.barSlot(plane, bar, m_displayBarCount, m_displayPlaneCount);
+            const int length = SpectrumRenderer::barLength(levels[i], slot.span);
+            const int peak = SpectrumRenderer::peakLength(peaks[i], slot.span);
+            if (length != m_paintedBars[i] || peak != m_paintedPeaks[i]) {
+                m_paintedBars[i] = length;
+                m_paintedPeaks[i] = peak;
+                dirty |= slot.column();
             }
         }
     }
-    
-    QWidget::timerEvent(event);
+
+    if (force) {
+        update();
+    } else if (!dirty.isNull()) {
+        update(dirty);
+    }
+}
+
+/**
+ * @brief 尺寸变化后所有柱的像素高度都需重新计算
+ */
+void SpectrumBars::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_renderer.setSize(size());
+    m_spectrogramDirty = true;
+    m_backgroundDirty = true;
+    syncDisplay(true);
+}
+
+/**
+ * @brief 位置变化后控件下方的背景随之变化
+ */
+void SpectrumBars::moveEvent(QMoveEvent *event)
+{
+    QWidget::moveEvent(event);
+    invalidateBackground();
+}
+
+/**
+ * @brief 父窗口换肤时调色板变化会传播到子控件
+ */
+void SpectrumBars::changeEvent(QEvent *event)
+{
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::ParentChange) {
+        invalidateBackground();
+    }
+}
+
+/**
+ * @brief 父窗口或被遮住的兄弟控件变化时重新截取背景
+ */
+bool SpectrumBars::eventFilter(QObject *watched, QEvent *event)
+{
+    if (!m_capturingBackground) {
+        switch (event->type()) {
+        case QEvent::PaletteChange:
+        case QEvent::Paint:
+        case QEvent::Move:
+        case QEvent::Resize:
+        case QEvent::Show:
+        case QEvent::Hide:
+            // 父窗口自身的重绘与背景无关，只关心它的调色板
+            if (watched != parentWidget() || event->type() == QEvent::PaletteChange) {
+                invalidateBackground();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
+/**
+ * @brief 重新显示（包括从最小化还原）：唤醒解码线程，立即推进一帧并恢复帧时钟
+ *
+ * 帧时钟重新启动时会重置帧间隔计时，隐藏期间的时间不会计入动态模型。
+ */
+void SpectrumBars::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    m_onScreen = true;
+    updateDecoderActivity();
+    if (isPlaying() || !m_dynamics.settled() || m_paintedPulseAlpha != 0) {
+        startFrameClock();
+        updateFrame();
+    }
+    update();
+}
+
+/**
+ * @brief 隐藏（包括最小化）：停止帧时钟并挂起解码线程，空闲时不占用 CPU
+ */
+void SpectrumBars::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_onScreen = false;
+    m_frameClock->stop();
+    updateDecoderActivity();
+}
+
+/**
+ * @brief 记录按下位置；此时还不能确定是单击还是拖动窗口
+ */
+void SpectrumBars::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    m_pressPos = globalPoint(event);
+    m_dragOffset = m_pressPos - window()->pos();
+    m_dragging = false;
+    event->accept();
+}
+
+/**
+ * @brief 超过系统拖动阈值后按主窗口的方式移动窗口
+ */
+void SpectrumBars::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton)) {
+        QWidget::mouseMoveEvent(event);
+        return;
+    }
+    const QPoint pos = globalPoint(event);
+    if (!m_dragging && (pos - m_pressPos).manhattanLength() >= QApplication::startDragDistance()) {
+        m_dragging = true;
+    }
+    if (m_dragging) {
+        window()->move(pos - m_dragOffset);
+    }
+}
+
+/**
+ * @brief 未发生拖动的单击切换显示模式
+ */
+void SpectrumBars::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+    if (!m_dragging) {
+        cycleVisualMode();
+    }
+    m_dragging = false;
 }
 
 /**
  * @brief 绘制事件
+ *
+ * 只读取 GUI 线程自己的显示快照，不加锁；只绘制与失效区域相交的柱子。
  */
 void SpectrumBars::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
+    // 软件合成：在后备缓冲中合成后整块拷贝，不依赖父窗口先画背景
+    if (ensureBackground()) {
+        composeFrame(event->rect());
+        QPainter painter(this);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(event->rect().topLeft(), m_backBuffer, event->rect());
+        return;
+    }
 
-    // 快照频谱数据（加锁保护跨线程安全）
-    std::vector<float> spectrumSnap;
-    std::vector<float> peakSnap;
-    {
-        QMutexLocker locker(&m_spectrumMutex);
-        if (m_spectrum.size() != kBarsAmount) {
-            m_spectrum.resize(kBarsAmount);
-            m_peakPositions.resize(kBarsAmount);
-            m_smoothedSpectrum.resize(kBarsAmount);
+    // 无法截取背景：作为透明控件直接用 QPainter 绘制
+    if (m_visualMode != Bars) {
+        QPainter painter(this);
+        painter.fillRect(event->rect(), QColor(0, 0, 0, 0));
+        if (m_visualMode == Oscilloscope) {
+            paintScope(painter);
+        } else {
+            paintSpectrogram(painter);
         }
-        spectrumSnap = m_smoothedSpectrum;  // 使用平滑后的数据绘制
-        peakSnap = m_peakPositions;
+        paintBeatPulse(painter);
+        return;
     }
 
+    // 渐变条只在尺寸/配色变化时重建，逐帧只做子矩形贴图
+    m_renderer.prepare(m_displayPlaneCount);
+
+    // 全部几何都是整数对齐矩形，无需抗锯齿
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing, true);
 
     // 用完全透明颜色清除背景
-    painter.fillRect(rect(), QColor(0, 0, 0, 0));
-
-    const int totalHeight = height();
-    const int totalWidth = width();
-
-    // 绘制频谱柱状图（AudioSpectrum 方式：amplitude 直接线性映射到像素）
-    // m_smoothedSpectrum 的值域：典型音乐 ≈ 0.05 ~ 1.5，峰值可达 2.0+
-    // 总体设计：正常音量时大部分 bar 在 10%~60% 高度，强节拍时部分 bar 可达 80%~100%
-    for (int i = 0; i < kBarsAmount; ++i) {
-        int x = i * (m_barWidth + m_barSpacing);
-
-        float amplitude = spectrumSnap[i];
-        if (amplitude < 0.005f) {
-            // 极低能量：画最小可见点（避免空隙）
-            int h = qMax(1, static_cast<int>(totalHeight / 30));
-            painter.fillRect(x, totalHeight - h, m_barWidth, h, m_bottomColor);
+    painter.fillRect(event->rect(), QColor(0, 0, 0, 0));
+
+    m_renderer.paint(painter, event->rect(), m_dynamics.levels(), m_dynamics.peaks(),
+                     m_displayBarCount, m_displayPlaneCount);
+    paintBeatPulse(painter);
+}
+
+/**
+ * @brief 按需截取控件下方的皮肤背景
+ *
+ * 父窗口的背景画刷按其原点对齐绘制（皮肤背景图从窗口左上角开始平铺），
+ * 再把层叠顺序在本控件之下且与之重叠的兄弟控件渲染上去。
+ * 只在尺寸、位置、换肤或这些兄弟控件重绘时执行，逐帧重绘不会走到这里。
+ */
+bool SpectrumBars::ensureBackground()
+{
+    QWidget *parent = parentWidget();
+    if (!parent || !parent->autoFillBackground() || size().isEmpty()) {
+        if (testAttribute(Qt::WA_OpaquePaintEvent)) {
+            setAttribute(Qt::WA_OpaquePaintEvent, false);
+            m_background = QImage();
+            update();   // 本次已按不透明绘制，下一帧由父窗口先画背景
+        }
+        return false;
+    }
+    if (!m_backgroundDirty && m_background.size() == size()) {
+        return true;
+    }
+
+    if (m_background.size() != size()) {
+        m_background = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+        m_backBuffer = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+    }
+    m_background.fill(Qt::transparent);
+
+    QPainter painter(&m_background);
+    painter.setBrushOrigin(-pos());
+    painter.fillRect(m_background.rect(), parent->palette().brush(parent->backgroundRole()));
+
+    // 与本控件重叠的下层兄弟控件（children() 的顺序即层叠顺序，越靠后越在上层）
+    for (const QPointer<QWidget> &sibling : m_coveredSiblings) {
+        if (sibling) {
+            sibling->removeEventFilter(this);
+        }
+    }
+    m_coveredSiblings.clear();
+    m_capturingBackground = true;
+    for (QObject *child : parent->children()) {
+        if (child == this) {
+            break;
+        }
+        QWidget *sibling = qobject_cast<QWidget *>(child);
+        if (!sibling || sibling->isWindow() || !sibling->isVisible()) {
+            continue;
+        }
+        const QRect overlap = sibling->geometry() & geometry();
+        if (overlap.isEmpty()) {
             continue;
         }
+        sibling->render(&painter, overlap.topLeft() - pos(), QRegion(overlap.translated(-sibling->pos())),
+                        QWidget::DrawChildren);
+        sibling->installEventFilter(this);
+        m_coveredSiblings.append(sibling);
+    }
+    m_capturingBackground = false;
+    painter.end();
+
+    parent->installEventFilter(this);   // 重复安装只保留一份
+    setAttribute(Qt::WA_OpaquePaintEvent, true);
+    m_backgroundDirty = false;
+    return true;
+}
+
+void SpectrumBars::invalidateBackground()
+{
+    m_backgroundDirty = true;
+    update();
+}
 
-        // 线性映射到像素（AudioSpectrum 方式：直接乘以可用高度，加放大系数）
-        constexpr float kVisualScale = 2.5f;  // 视觉放大，补偿 A计权和 EMA 压缩后的值域收缩
-        int barHeight = static_cast<int>(amplitude * kVisualScale * (totalHeight - 4));
-        barHeight = qMax(barHeight, 1);       // 最少 1px
-        barHeight = qMin(barHeight, totalHeight - 2);  // 不超出控件
-
-        // 渐变色（从顶部亮色到底部深色）
-        QLinearGradient gradient(0, totalHeight - barHeight, 0, totalHeight);
-        gradient.setColorAt(0.0, m_topColor);
-        gradient.setColorAt(0.6, m_midColor);
-        gradient.setColorAt(1.0, m_bottomColor);
-
-        painter.fillRect(x, totalHeight - barHeight, m_barWidth, barHeight, gradient);
-
-        // 峰值指示器（同样用线性映射 + 放大系数）
-        float peakVal = peakSnap[i];
-        if (peakVal < 0.01f) continue;
-        int peakH = static_cast<int>(peakVal * kVisualScale * (totalHeight - 4));
-        peakH = qMax(peakH, 2);
-        peakH = qMin(peakH, totalHeight - 2);
-        int peakY = totalHeight - peakH;
-
-        if (peakY < totalHeight - barHeight - 3) {
-            painter.fillRect(x, peakY, m_barWidth, 2, m_peakColor);
+/**
+ * @brief 在后备缓冲中合成 rect 区域
+ *
+ * 频谱柱模式全程走 SpectrumRenderer::composite 的 SIMD 混合；
+ * 示波器（抗锯齿折线）和瀑布图仍用 QPainter，但同样画在恢复了背景的后备缓冲上。
+ */
+void SpectrumBars::composeFrame(const QRect &rect)
+{
+    if (m_visualMode == Bars) {
+        m_renderer.prepare(m_displayPlaneCount);
+        m_renderer.composite(m_backBuffer, m_background, rect, m_dynamics.levels(), m_dynamics.peaks(),
+                             m_displayBarCount, m_displayPlaneCount);
+    } else {
+        SpectrumRenderer::copyRect(m_backBuffer, m_background, rect);
+        QPainter painter(&m_backBuffer);
+        painter.setClipRect(rect);
+        if (m_visualMode == Oscilloscope) {
+            paintScope(painter);
+        } else {
+            paintSpectrogram(painter);
         }
     }
+
+    if (m_paintedPulseAlpha != 0) {
+        QColor color = m_renderer.peakColor();
+        color.setAlpha(m_paintedPulseAlpha);
+        SpectrumRenderer::blendFill(m_backBuffer, beatStripRect() & rect, color);
+    }
 }
 
-void SpectrumBars::calculateLogFrequencyMapping()
+/**
+ * @brief 绘制节拍脉冲细条（峰值颜色，不透明度随脉冲衰减）
+ */
+void SpectrumBars::paintBeatPulse(QPainter &painter)
 {
-    const int halfN = FFT_SIZE / 2; // 512
-    const float logMinFreq = std::log10(MIN_FREQ);     // log10(20)
-    const float logMaxFreq = std::log10(MAX_FREQ);     // log10(20000)
-    const float logRange = logMaxFreq - logMinFreq;
+    if (m_paintedPulseAlpha == 0) {
+        return;
+    }
+    QColor color = m_renderer.peakColor();
+    color.setAlpha(m_paintedPulseAlpha);
+    painter.fillRect(beatStripRect(), color);
+}
 
-    m_logMapping.resize(kBarsAmount);
+/**
+ * @brief 提示文字显示节拍速度：整首歌的扫描结果优先，实时估计前加 "≈"
+ */
+void SpectrumBars::updateTempoToolTip()
+{
+    const int bpm = qRound(tempo());
+    QString text;
+    if (bpm > 0) {
+        text = m_trackTempo > 0.0f ? QString("%1 BPM").arg(bpm) : QString("≈%1 BPM").arg(bpm);
+    }
+    if (text != toolTip()) {
+        setToolTip(text);
+    }
+}
 
-    for (int bar = 0; bar < kBarsAmount; ++bar) {
-        // 计算该柱子对应的对数频率
-        float logFreq = logMinFreq + (bar / static_cast<float>(kBarsAmount)) * logRange;
-        float freq = std::pow(10.0f, logFreq);
+/**
+ * @brief 绘制示波器波形
+ *
+ * 波形在分析线程中已按上升沿过零点对齐，这里只做坐标换算；
+ * 停止播放后显示一条水平线。
+ */
+void SpectrumBars::paintScope(QPainter &painter)
+{
+    const int w = width();
+    const int h = height();
+    const int planeCount = m_displayPlaneCount;
+    const bool split = planeCount > 1 && m_renderer.stereoLayout() == SplitBars;
+
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    for (int plane = 0; plane < planeCount; ++plane) {
+        const qreal bandTop = split && plane == 1 ? h / 2 : 0;
+        const qreal bandHeight = split ? h / 2 : h;
+        const qreal centerY = bandTop + bandHeight / 2.0;
+        const qreal amplitude = bandHeight / 2.0 - 1.0;
+        // 第二平面（R/S）用峰值色区分
+        painter.setPen(QPen(plane == 0 ? m_renderer.topColor() : m_renderer.peakColor(), 1.0));
+
+        if (m_scopeCount < 2) {
+            painter.drawLine(QPointF(0, centerY), QPointF(w, centerY));
+            continue;
+        }
+
+        const float *samples = m_scope.data() + plane * m_scopeCount;
+        const qreal xStep = (w - 1) / static_cast<qreal>(m_scopeCount - 1);
+        m_scopePoints.resize(m_scopeCount);
+        for (int i = 0; i < m_scopeCount; ++i) {
+            const qreal sample = qBound(-1.0f, samples[i], 1.0f);
+            m_scopePoints[i] = QPointF(i * xStep, centerY - sample * amplitude);
+        }
+        painter.drawPolyline(m_scopePoints.data(), static_cast<int>(m_scopePoints.size()));
+    }
+}
+
+/**
+ * @brief 按需重建频谱瀑布图
+ *
+ * 环形图像与控件等大，每帧只改写一列像素；尺寸、配色或柱数变化时清空历史。
+ * 调色板在低强度处完全透明以透出皮肤背景，随强度依次过渡到底色、中间色、顶色和峰值色。
+ */
+void SpectrumBars::ensureSpectrogram()
+{
+    const int w = qMax(1, width());
+    const int h = qMax(1, height());
+    if (!m_spectrogramDirty && m_spectrogram.width() == w && m_spectrogram.height() == h) {
+        return;
+    }
 
-        // 转换为 FFT bin 索引
-        int bin = static_cast<int>(freq * FFT_SIZE / m_sampleRate);
-        bin = qBound(1, bin, halfN); // 避免 bin=0 (DC 分量)
+    m_spectrogram = QImage(w, h, QImage::Format_ARGB32_Premultiplied);
+    m_spectrogram.fill(Qt::transparent);
+    m_spectrogramColumn = 0;
 
-        m_logMapping[bar] = bin;
+    QImage ramp(static_cast<int>(m_heatPalette.size()), 1, QImage::Format_ARGB32_Premultiplied);
+    ramp.fill(Qt::transparent);
+    {
+        QPainter p(&ramp);
+        QColor faint = m_renderer.bottomColor();
+        faint.setAlpha(0);
+        QLinearGradient gradient(0, 0, ramp.width(), 0);
+        gradient.setColorAt(0.0, faint);
+        gradient.setColorAt(0.25, m_renderer.bottomColor());
+        gradient.setColorAt(0.5, m_renderer.midColor());
+        gradient.setColorAt(0.8, m_renderer.topColor());
+        gradient.setColorAt(1.0, m_renderer.peakColor());
+        p.fillRect(ramp.rect(), gradient);
+    }
+    const QRgb *line = reinterpret_cast<const QRgb *>(ramp.constScanLine(0));
+    std::copy(line, line + ramp.width(), m_heatPalette.begin());
+
+    // 行 → 柱：低频在下；双平面时上半部分为第一平面，下半部分为第二平面，中间留一行分隔
+    m_spectrogramRows.assign(h, -1);
+    const int barCount = m_displayBarCount;
+    if (barCount > 0) {
+        if (m_displayPlaneCount == 1) {
+            for (int y = 0; y < h; ++y) {
+                m_spectrogramRows[y] = (h - 1 - y) * barCount / h;
+            }
+        } else {
+            const int upper = h / 2;
+            const int lower = h - upper - 1;
+            for (int y = 0; y < upper; ++y) {
+                m_spectrogramRows[y] = (upper - 1 - y) * barCount / upper;
+            }
+            for (int y = 0; y < lower; ++y) {
+                m_spectrogramRows[upper + 1 + y] = barCount + (lower - 1 - y) * barCount / lower;
+            }
+        }
+    }
+
+    m_spectrogramDirty = false;
+}
+
+/**
+ * @brief 把当前柱高写入瀑布图的下一列
+ */
+void SpectrumBars::appendSpectrogramColumn()
+{
+    ensureSpectrogram();
+
+    const float *levels = m_dynamics.levels();
+    const int maxIndex = static_cast<int>(m_heatPalette.size()) - 1;
+    uchar *bits = m_spectrogram.bits();
+    const qsizetype stride = m_spectrogram.bytesPerLine();
+    for (int y = 0; y < m_spectrogram.height(); ++y) {
+        const int slot = m_spectrogramRows[y];
+        QRgb color = 0;
+        if (slot >= 0) {
+            const int index = static_cast<int>(levels[slot] * SpectrumRenderer::kVisualScale * maxIndex);
+            color = m_heatPalette[qBound(0, index, maxIndex)];
+        }
+        reinterpret_cast<QRgb *>(bits + y * stride)[m_spectrogramColumn] = color;
+    }
+
+    m_spectrogramColumn = (m_spectrogramColumn + 1) % m_spectrogram.width();
+}
+
+/**
+ * @brief 绘制频谱瀑布图
+ *
+ * 写入位置是最旧的一列：[写入位置, 宽度) 贴到左侧，[0, 写入位置) 贴到右侧，
+ * 历史内容从不重绘，滚动只是两次子矩形贴图。
+ */
+void SpectrumBars::paintSpectrogram(QPainter &painter)
+{
+    ensureSpectrogram();
+
+    const int w = m_spectrogram.width();
+    const int h = m_spectrogram.height();
+    const int oldest = m_spectrogramColumn;
+    painter.drawImage(QPoint(0, 0), m_spectrogram, QRect(oldest, 0, w - oldest, h));
+    if (oldest > 0) {
+        painter.drawImage(QPoint(w - oldest, 0), m_spectrogram, QRect(0, 0, oldest, h));
     }
 }
@@ -17,16 +17,29 @@
 #include <QTimer>           // 定时器
 #include <QColor>           // 颜色定义
 #include <QPainterPath>     // 绘制路径
-#include <QPropertyAnimation> // 属性动画
 #include <QPaintEvent>      // 绘制事件
-#include <QTimerEvent>      // 定时器事件
+#include <QResizeEvent>     // 尺寸变化事件
+#include <QShowEvent>       // 可见性变化（最小化 / 还原）
+#include <QHideEvent>
+#include <QMoveEvent>       // 位置变化（背景需要重新截取）
+#include <QPointer>         // 被遮住的兄弟控件
+#include <QList>
 #include <QFile>            // 文件操作
 #include <QUrl>             // URL处理
-#include <QMutex>           // 互斥锁
+#include <QPainter>         // 绘制
+#include <QImage>           // 频谱瀑布图环形缓冲
+#include <QMouseEvent>      // 点击切换显示模式
+#include <QPointF>          // 示波器折线
+#include <QElapsedTimer>    // 帧间隔计时
 #include <vector>           // 标准向量容器
+#include <array>            // 固定容量显示缓冲
 #include <cmath>            // 数学函数
 
 #include "mp3decoder.h"     // MP3解码器
+#include "spectrumanalyzer.h" // 频谱分析线程
+#include "triplebuffer.h"   // 无锁快照交换
+#include "spectrumdynamics.h" // 柱高 / 峰值时间动态
+#include "spectrumrenderer.h" // 频谱柱绘制（与离线渲染共用）
 
 /**
  * @class SpectrumBars
@@ -35,16 +48,29 @@
  * SpectrumBars类提供了一个可视化的频谱分析器，可以显示音乐播放过程中的频率分布。
  * 它使用MP3Decoder类解码音频文件并获取频谱数据，然后通过柱状图的形式直观地
  * 展示不同频率的能量分布。
+ * 与千千静听一样，单击可在频谱柱、示波器和频谱瀑布图之间切换。
  */
 class SpectrumBars : public QWidget
 {
     Q_OBJECT
-    // 使用qreal类型保证跨平台兼容性
-    // peakDecay控制频谱柱峰值下降的速度，值越大下降越快
-    Q_PROPERTY(qreal peakDecay READ peakDecay WRITE setPeakDecay)
-
 
 public:
+    /**
+     * @brief 双平面（立体声 / M-S）分析时的绘制方式（定义见 SpectrumRenderer）
+     */
+    typedef SpectrumRenderer::StereoLayout StereoLayout;
+    static constexpr StereoLayout MirroredBars = SpectrumRenderer::MirroredBars;
+    static constexpr StereoLayout SplitBars = SpectrumRenderer::SplitBars;
+
+    /**
+     * @brief 显示模式
+     */
+    enum VisualMode {
+        Bars,           // 频谱柱 + 峰值指示器
+        Oscilloscope,   // 示波器（过零触发，波形稳定不漂移）
+        Spectrogram     // 滚动频谱瀑布图（每帧只绘制最新一列）
+    };
+
     /**
      * @brief 构造函数
      */
@@ -56,10 +82,17 @@ public:
     ~SpectrumBars();
 
     /**
-     * @brief 定时器驱动的主更新函数（~100 FPS）
+     * @brief 帧时钟驱动的主更新函数（跟随显示刷新率，见 setFrameRateCap）
     */
     void updateFrame();
 
+    /**
+     * @brief 设置帧率上限
+     * @param fps 每秒最多刷新次数；0 表示跟随所在屏幕的刷新率
+     */
+    void setFrameRateCap(int fps);
+    int frameRateCap() const { return m_fpsCap; }
+
     /**
      * @brief 设置媒体播放器，用于获取音频数据和播放状态
      * @param player 媒体播放器指针
@@ -87,6 +120,41 @@ public:
      * @param spacing 频谱柱之间的间距（像素）
      */
     void setBarSize(int width, int spacing);
+
+    /**
+     * @brief 设置频带布局（柱数量、频率范围、对数 / 1/N 倍频程 / 常数 Q）
+     * @param layout 频带布局，例如 BandLayout::fractionalOctave(3)
+     *
+     * 频带查找表由分析线程预计算，并在文件采样率变化时自动重建。
+     * 常数 Q 布局会同时把解码器的 STFT 窗口切换到更长的长度。
+     */
+    void setBandLayout(const BandLayout &layout);
+    const BandLayout &bandLayout() const { return m_bandLayout; }
+
+    /**
+     * @brief 设置频谱分析的声道模式
+     * @param mode Mono（下混，单组频谱柱）/ Stereo（L/R）/ MidSide（M/S）
+     *
+     * 双平面模式下解码线程用 SIMD 解交织，并通过一次批量 FFT 得到两个频谱，
+     * 绘制方式由 setStereoLayout() 决定。
+     */
+    void setChannelMode(StftAnalyzer::ChannelMode mode);
+    StftAnalyzer::ChannelMode channelMode() const { return m_channelMode; }
+
+    void setStereoLayout(StereoLayout layout);
+    StereoLayout stereoLayout() const { return m_renderer.stereoLayout(); }
+
+    /**
+     * @brief 设置显示模式
+     *
+     * 示波器模式下分析线程随频谱一起送出同一帧的时域样本（共用同一个 STFT 抽头），
+     * 其他模式不拷贝时域样本。
+     */
+    void setVisualMode(VisualMode mode);
+    VisualMode visualMode() const { return m_visualMode; }
+
+    // 依次切换到下一个显示模式（单击控件时调用）
+    void cycleVisualMode();
     
     /**
      * @brief 更新频谱显示以匹配指定的播放位置
@@ -97,19 +165,22 @@ public:
     void updateForPosition(qint64 position);
 
     /**
-     * @brief 获取峰值衰减速度
-     * @return 当前的峰值衰减速度值
+     * @brief 设置柱高与峰值指示器的运动参数
+     * @param params 上升/下降时间常数（毫秒）、峰值停留时间（毫秒）、峰值下落加速度
+     *
+     * 所有参数都以物理时间表示，每个渲染帧按实际帧间隔推进一次，
+     * 因此视觉效果与帧率、分析帧率无关。
      */
-    qreal peakDecay() const { return m_peakDecay; }
-    
+    void setDynamicsParams(const SpectrumDynamics::Params &params) { m_dynamics.setParams(params); }
+    const SpectrumDynamics::Params &dynamicsParams() const { return m_dynamics.params(); }
+
     /**
-     * @brief 设置峰值衰减速度
-     * @param value 衰减速度值，推荐范围0.01-0.2
-     * 
-     * 峰值衰减速度控制频谱峰值指示器下降的速度，
-     * 值越大，峰值下降越快，视觉效果越活跃。
+     * @brief 当前歌曲的节拍速度（BPM）
+     *
+     * 媒体库扫描（TempoScanner）已有结果时返回整首歌的估计，
+     * 否则返回播放中基于最近几秒的实时估计；0 表示尚未确定。
      */
-    void setPeakDecay(qreal value) { m_peakDecay = value; }
+    float tempo() const { return m_trackTempo > 0.0f ? m_trackTempo : m_liveTempo; }
 
 protected:
     /**
@@ -117,24 +188,46 @@ protected:
      * @param event 绘制事件
      * 
      * 负责绘制频谱柱状图和峰值指示器，
-     * 使用渐变色和抗锯齿技术提高视觉效果。
+     * 只绘制与失效区域相交的柱子。
      */
     void paintEvent(QPaintEvent *event) override;
-    
+
     /**
-     * @brief 处理定时器事件，用于动画效果
-     * @param event 定时器事件
-     * 
-     * 主要用于实现峰值指示器的平滑衰减动画效果。
+     * @brief 尺寸变化时整体重算柱高并重绘
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
+    /**
+     * @brief 可见性变化：隐藏（包括最小化时 Qt 发出的自发隐藏事件；被其他窗口遮挡不会产生隐藏事件）时
+     *        停止帧时钟并挂起解码线程，重新显示时在下一帧内恢复
+     */
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+    /**
+     * @brief 位置或父窗口配色（换肤）变化后重新截取合成用的背景
+     */
+    void moveEvent(QMoveEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+    /**
+     * @brief 监视父窗口和被本控件遮住的兄弟控件（例如与可视化区域重叠的歌词标签），
+     *        它们重绘或改变几何时重新截取背景
+     */
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+    /**
+     * @brief 单击切换显示模式；按住拖动超过阈值时照常拖动主窗口
      */
-    void timerEvent(QTimerEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
 
 private slots:
     /**
-     * @brief 处理音频数据，更新频谱显示
+     * @brief 推进解码位置
      * 
-     * 根据当前播放状态，从MP3解码器获取实际音频数据，
-     * 并更新频谱显示。如果没有实际音频数据，则不更新频谱。
+     * 播放期间把播放器位置同步给MP3解码器，解码器通过回调产出新的频谱帧。
      */
     void processAudio();
     
@@ -147,11 +240,6 @@ private slots:
 #ifdef QT_MULTIMEDIA_ENABLED
     void handlePlaybackStateChanged(QMediaPlayer::PlaybackState state);
 #endif
-    
-    /**
-     * @brief 更新频谱显示
-     */
-    void updateSpectrum();
 
 private:
     /**
@@ -161,18 +249,147 @@ private:
      * 设置回调函数以接收频谱数据更新。
      */
     void tryGetRealAudioData();
+
+    /**
+     * @brief 按屏幕刷新率（受上限约束）启动或调整帧时钟
+     */
+    void startFrameClock();
+
+    /**
+     * @brief 播放器是否处于播放状态
+     */
+    bool isPlaying() const;
+
+    /**
+     * @brief 只在正在播放且可见时让解码线程工作，否则挂起（分析线程随之无帧可处理而阻塞）
+     */
+    void updateDecoderActivity();
+
+    /**
+     * @brief 取出最新的频谱快照作为动态模型的目标高度
+     * @param fresh 非空时写入本次是否取到了新快照
+     * @return 柱数或平面数发生了变化（需要整体重绘）
+     */
+    bool acquireSnapshot(bool *fresh = nullptr);
+
+    /**
+     * @brief 只失效像素高度变化的柱子
+     * @param force 整体重绘
+     */
+    void syncDisplay(bool force);
+
+    /**
+     * @brief 按需截取控件下方的皮肤背景（父窗口背景画刷 + 被遮住的兄弟控件）
+     * @return 是否可以使用软件合成；父窗口不自动填充背景时返回 false，退回透明控件绘制
+     *
+     * 可以合成时控件设置 WA_OpaquePaintEvent：重绘只涉及本控件，
+     * 不再触发父窗口背景和兄弟控件的半透明重绘。
+     */
+    bool ensureBackground();
+    void invalidateBackground();
+
+    /**
+     * @brief 在 ARGB32_Premultiplied 后备缓冲中合成 rect 区域：背景 + 当前显示模式 + 节拍细条
+     */
+    void composeFrame(const QRect &rect);
+
+    /**
+     * @brief 节拍脉冲：检测到起始点时顶部细条亮起，随后按时间常数淡出
+     */
+    void paintBeatPulse(QPainter &painter);
+    QRect beatStripRect() const { return QRect(0, 0, width(), kBeatStripHeight); }
+
+    /**
+     * @brief 节拍速度变化时刷新提示文字
+     */
+    void updateTempoToolTip();
+
+    /**
+     * @brief 绘制示波器波形（分屏布局下两个平面上下排列，否则叠加）
+     */
+    void paintScope(QPainter &painter);
+
+    /**
+     * @brief 按需重建频谱瀑布图的环形图像、调色板和行→柱映射
+     */
+    void ensureSpectrogram();
+
+    /**
+     * @brief 把当前柱高写入瀑布图的下一列（只写一列，历史列保持不动）
+     */
+    void appendSpectrogramColumn();
+
+    /**
+     * @brief 以写入位置为界分两段贴图，最新一列位于最右侧
+     */
+    void paintSpectrogram(QPainter &painter);
     
     // 核心组件
 #ifdef QT_MULTIMEDIA_ENABLED
     QMediaPlayer *m_mediaPlayer;      // 媒体播放器指针，用于获取音频数据
 #endif
-    QTimer *m_updateTimer;            // 更新定时器，控制频谱刷新频率
-    int m_timerId;                    // 定时器ID，用于动画效果
+    QTimer *m_frameClock;             // 唯一的帧时钟（可见且播放或柱子回落期间按显示刷新率运行）
+    int m_fpsCap = 0;                 // 帧率上限，0 = 跟随屏幕刷新率
+    bool m_onScreen = false;          // 最近一次收到的是显示事件（最小化后 isVisible() 仍为 true）
     
-    // 频谱数据
-    std::vector<float> m_spectrum;     // 存储当前频谱数据
-    std::vector<float> m_peakPositions; // 存储频谱峰值位置
-    std::vector<float> m_smoothedSpectrum; // 帧间平滑后的频谱数据（减少跳动）
+    // 分析线程 → GUI 线程的频谱快照（双平面时两个平面首尾相接，下标 = plane * barCount + bar）
+    static constexpr int kMaxSlots = SpectrumProcessor::kMaxPlanes * SpectrumProcessor::kMaxBars;
+    static constexpr int kScopeSamples = 512;    // 示波器每平面显示的样本数
+    static constexpr int kMaxScope = SpectrumProcessor::kMaxPlanes * kScopeSamples;
+    struct SpectrumSnapshot {
+        std::array<float, kMaxSlots> bars{};   // 空间平滑后的柱高（时间平滑由 m_dynamics 完成）
+        std::array<float, kMaxScope> scope{};  // 过零触发对齐后的波形（仅示波器模式）
+        int barCount = 0;
+        int planeCount = 1;
+        int scopeCount = 0;                    // 每平面波形样本数，0 表示无波形
+        quint32 onsetSerial = 0;               // 累计起始点个数（快照可能被覆盖，用序号保证不丢节拍）
+        float onsetStrength = 0.0f;            // 最近一个起始点的强度
+        float tempo = 0.0f;                    // 实时节拍估计（BPM）
+    };
+    TripleBuffer<SpectrumSnapshot> m_snapshots;  // 分析线程写、GUI 线程读，双方都不等待
+    quint32 m_onsetSerial = 0;        // 仅分析线程访问
+    float m_onsetStrength = 0.0f;     // 仅分析线程访问
+
+    // 显示数据（仅 GUI 线程访问，paintEvent 只读这里）
+    std::array<float, kMaxSlots> m_targets{};   // 最新快照的柱高，作为动态模型的目标
+    SpectrumDynamics m_dynamics;      // 柱高与峰值（攻击/释放、峰值停留、重力下落）
+    QElapsedTimer m_frameTimer;       // 上一个渲染帧的时刻，用于计算 dt
+    int m_displayBarCount = 0;        // 当前柱数量，奇数可以保证中心对称
+    int m_displayPlaneCount = 1;      // 当前频谱平面数
+    std::array<int, kMaxSlots> m_paintedBars{};   // 上次失效时每根柱的像素高度
+    std::array<int, kMaxSlots> m_paintedPeaks{};  // 上次失效时每个峰值的像素高度
+
+    // 示波器 / 频谱瀑布图（仅 GUI 线程访问）
+    VisualMode m_visualMode = Bars;
+    std::array<float, kMaxScope> m_scope{};       // 最新一帧对齐后的波形
+    int m_scopeCount = 0;                         // 每平面波形样本数
+    std::vector<QPointF> m_scopePoints;           // 折线顶点（复用，不逐帧分配）
+    QImage m_spectrogram;                         // 环形图像：第 m_spectrogramColumn 列是最旧的一列
+    int m_spectrogramColumn = 0;                  // 下一列写入位置
+    std::vector<int> m_spectrogramRows;           // 每行像素对应的柱下标（-1 表示平面间的分隔行）
+    std::array<QRgb, 256> m_heatPalette{};        // 强度 → 颜色（由皮肤配色生成）
+    bool m_spectrogramDirty = true;               // 配色、尺寸或柱数变化后需要重建
+
+    // 软件合成（仅 GUI 线程访问）
+    QImage m_background;              // 控件下方的皮肤背景（预乘格式，控件尺寸）
+    QImage m_backBuffer;              // 合成结果，paintEvent 只做一次整块拷贝
+    bool m_backgroundDirty = true;    // 尺寸、位置、换肤或被遮住的兄弟控件变化后需要重新截取
+    bool m_capturingBackground = false; // 正在截取兄弟控件，忽略它们因此产生的绘制事件
+    QList<QPointer<QWidget>> m_coveredSiblings;  // 与本控件重叠、位于其下方的兄弟控件
+
+    // 节拍（仅 GUI 线程访问）
+    static constexpr int kBeatStripHeight = 2;        // 节拍脉冲细条高度（像素）
+    static constexpr float kBeatPulseSeconds = 0.15f; // 脉冲淡出时间常数
+    quint32 m_seenOnsetSerial = 0;    // 已处理到的起始点序号
+    float m_beatPulse = 0.0f;         // 当前脉冲亮度，0~1
+    int m_paintedPulseAlpha = 0;      // 上次失效时的细条不透明度
+    float m_liveTempo = 0.0f;         // 播放中的实时节拍估计
+    float m_trackTempo = 0.0f;        // 媒体库扫描得到的整首歌节拍
+
+    // 单击 / 拖动区分
+    QPoint m_pressPos;                // 按下时的全局坐标
+    QPoint m_dragOffset;              // 按下点相对主窗口左上角的偏移
+    bool m_dragging = false;          // 已超过拖动阈值
 
     // Auto-Scale 机制（参考 Spectralizer 的统计缩放算法）
     static constexpr int kScaleHistorySize = 120;  // 约 1-2 秒的历史窗口
@@ -182,39 +399,21 @@ private:
     float m_scaleEma = 100.0f;         // 缩放因子的 EMA（原始幅度值域，典型范围 10~500）
     bool m_autoScaleReady = false;       // 是否已收集足够数据开始缩放
     
-    // 动画属性
-    qreal m_peakDecay;                // 峰值衰减速度
-    QPropertyAnimation *m_peakAnimation; // 峰值动画
-    
-    // 可视化设置
-    QColor m_topColor;                // 频谱柱顶部颜色
-    QColor m_bottomColor;             // 频谱柱底部颜色
-    QColor m_midColor;                // 频谱柱中间颜色
-    QColor m_peakColor;               // 峰值指示器颜色
+    // 可视化设置：配色、柱宽 / 间距、双平面布局与渐变条缓存
+    SpectrumRenderer m_renderer;
 
     // 频谱柱配置
-    static constexpr int kBarsAmount = 41; // 频谱柱数量，奇数可以保证中心对称
-    int m_barWidth = 3;   // 频谱柱宽度（像素）
-    int m_barSpacing = 1; // 频谱柱间距（像素）
-
-    std::vector<int> m_logMapping; // 存储每个柱子对应的最高 bin 索引
-    void calculateLogFrequencyMapping();
+    BandLayout m_bandLayout;          // 频带布局（默认 41 柱对数分布）
+    StftAnalyzer::ChannelMode m_channelMode = StftAnalyzer::Mono;
 
     // 音频处理参数
-    // 常量
-    static const int FFT_SIZE = 1024;
-    static const int MIN_FREQ = 20;
-    static const int MAX_FREQ = 20000;
-
-    // 变量
     int m_sampleRate;                 // 音频采样率（Hz）
     int m_channelCount;               // 音频通道数（1=单声道，2=立体声）
-    bool m_spectrumDirty;             // 频谱数据是否已更新需要重绘
     
     // 实际音频数据
     QString m_currentFilePath;        // 当前播放文件的路径
     MP3Decoder* m_mp3Decoder;         // MP3解码器，用于解码MP3文件
-    QMutex m_spectrumMutex;           // 用于保护频谱数据的互斥锁
+    SpectrumAnalyzer* m_analyzer;     // 频谱分析线程（频带映射/A计权/空间平滑均在此完成）
 };
 
 #endif // SPECTRUMBARS_H
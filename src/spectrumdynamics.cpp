@@ -0,0 +1,62 @@
+/*
+ * SpectrumDynamics 实现
+ */
+#include "spectrumdynamics.h"
+#include "simdkernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 一阶系统在 dt 内走完的比例：1 - e^(-dt/τ)；τ 为 0 时立即到位
+float stepCoefficient(float dtSeconds, float timeConstantMs)
+{
+    if (timeConstantMs <= 0.0f) return 1.0f;
+    return 1.0f - std::exp(-dtSeconds * 1000.0f / timeConstantMs);
+}
+
+} // namespace
+
+SpectrumDynamics::SpectrumDynamics(const Params& params)
+    : m_params(params)
+{
+}
+
+void SpectrumDynamics::setSlotCount(int count)
+{
+    count = std::clamp(count, 0, kMaxSlots);
+    if (count != m_slotCount) {
+        m_slotCount = count;
+        reset();
+    }
+}
+
+void SpectrumDynamics::reset()
+{
+    m_level.fill(0.0f);
+    m_peak.fill(0.0f);
+    m_velocity.fill(0.0f);
+    m_hold.fill(0.0f);
+}
+
+void SpectrumDynamics::advance(const float* targets, float dtSeconds)
+{
+    if (m_slotCount == 0 || dtSeconds <= 0.0f) return;
+
+    // 系数每帧只算一次，逐柱部分全部向量化
+    const float attack = stepCoefficient(dtSeconds, m_params.attackMs);
+    const float release = stepCoefficient(dtSeconds, m_params.releaseMs);
+    simd::followEnvelope(m_level.data(), targets, m_slotCount, attack, release);
+
+    simd::updatePeaks(m_peak.data(), m_velocity.data(), m_hold.data(), m_level.data(), m_slotCount,
+                      dtSeconds, m_params.gravity, m_params.peakHoldMs / 1000.0f);
+}
+
+bool SpectrumDynamics::settled(float epsilon) const
+{
+    for (int i = 0; i < m_slotCount; ++i) {
+        if (m_level[i] > epsilon || m_peak[i] > epsilon) return false;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * SpectrumDynamics - 频谱柱的时间动态模型
+ *
+ * 统一负责柱高平滑和峰值指示器的运动，参数全部以物理时间表示：
+ *   - attack / release: 柱高上升 / 下降的一阶时间常数（毫秒）
+ *   - peakHold:         峰值被顶起后停留的时间（毫秒）
+ *   - gravity:          停留结束后峰值下落的加速度（柱高单位 / 秒²）
+ *
+ * 每个渲染帧以实际经过的 dt 调用一次 advance()，因此无论帧率、
+ * 分析帧率如何变化，视觉效果都一致。逐柱更新使用 simdkernels.h 的向量化内核。
+ * 本类不依赖 Qt，也不加锁，由调用方保证单线程使用。
+ */
+#ifndef SPECTRUMDYNAMICS_H
+#define SPECTRUMDYNAMICS_H
+
+#include <array>
+
+#include "spectrumprocessor.h"
+
+class SpectrumDynamics
+{
+public:
+    static constexpr int kMaxSlots = SpectrumProcessor::kMaxPlanes * SpectrumProcessor::kMaxBars;
+
+    struct Params {
+        float attackMs = 20.0f;      // 上升时间常数
+        float releaseMs = 120.0f;    // 下降时间常数
+        float peakHoldMs = 250.0f;   // 峰值停留时间
+        float gravity = 2.0f;        // 峰值下落加速度（柱高单位 / 秒²）
+    };
+
+    SpectrumDynamics() = default;
+    explicit SpectrumDynamics(const Params& params);
+
+    void setParams(const Params& params) { m_params = params; }
+    const Params& params() const { return m_params; }
+
+    /**
+     * @brief 设置参与计算的柱数（平面数 × 每平面柱数），变化时清空状态
+     */
+    void setSlotCount(int count);
+    int slotCount() const { return m_slotCount; }
+
+    // 清空所有柱高和峰值
+    void reset();
+
+    /**
+     * @brief 推进一帧
+     * @param targets 每柱的目标高度（slotCount 个）；nullptr 表示全部归零
+     * @param dtSeconds 距上一帧的实际时间
+     */
+    void advance(const float* targets, float dtSeconds);
+
+    /**
+     * @brief 所有柱高和峰值都已回落到 epsilon 以下（可停止帧时钟）
+     */
+    bool settled(float epsilon = 1e-3f) const;
+
+    const float* levels() const { return m_level.data(); }
+    const float* peaks() const { return m_peak.data(); }
+
+private:
+    Params m_params;
+    int m_slotCount = 0;
+
+    std::array<float, kMaxSlots> m_level{};      // 当前柱高
+    std::array<float, kMaxSlots> m_peak{};       // 峰值位置
+    std::array<float, kMaxSlots> m_velocity{};   // 峰值下落速度
+    std::array<float, kMaxSlots> m_hold{};       // 峰值剩余停留时间（秒）
+};
+
+#endif // SPECTRUMDYNAMICS_H
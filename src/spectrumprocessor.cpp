@@ -0,0 +1,297 @@
+/*
+ * SpectrumProcessor 实现
+ */
+#include "spectrumprocessor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float kGain = 20.0f;       // 增益放大（补偿 A计权衰减）
+
+// 空间平滑卷积核（权重和=17）：锐化波峰、填充凹陷，使频谱更连贯饱满
+constexpr int kKernelSize = 7;
+constexpr float kKernel[kKernelSize] = {1.0f, 2.0f, 3.0f, 5.0f, 3.0f, 2.0f, 1.0f};
+constexpr float kKernelSum = 17.0f;
+
+// 常数 Q 参数
+constexpr int kDefaultFftSize = 1024;
+constexpr int kConstantQFftSize = 4096;    // 44.1kHz 下窗口约 93ms，可分辨约 10Hz 间隔（解码器跳转时预读一个窗口）
+constexpr float kSparsity = 0.01f;         // 频域核中低于峰值 1% 的项视为零
+
+float hann(int n, int length)
+{
+    if (length <= 1) return 1.0f;
+    return 0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * n / (length - 1)));
+}
+
+// A计权近似公式（IEC 61672-1，对 20Hz~20kHz 有效）
+float aWeighting(float freq)
+{
+    const float f2 = freq * freq;
+    const float ra = 12194.0f * 12194.0f;
+    const float w = 1.2589f * ra * f2 * f2 /
+        ((f2 + 20.6f) * std::sqrt((f2 + 107.7f) * (f2 + 737.9f)) * (f2 + ra));
+    return std::max(w, 0.001f);  // 防止除零或负值
+}
+
+} // namespace
+
+SpectrumProcessor::SpectrumProcessor(const BandLayout& layout)
+    : m_layout(layout),
+      m_barCount(barCountFor(layout))
+{
+}
+
+void SpectrumProcessor::setLayout(const BandLayout& layout)
+{
+    m_layout = layout;
+    m_barCount = barCountFor(layout);
+    reset();
+    if (m_sampleRate > 0 && m_fftSize > 0) {
+        rebuildTables();
+    }
+}
+
+int SpectrumProcessor::barCountFor(const BandLayout& layout)
+{
+    if (layout.scale == BandLayout::FractionalOctave) {
+        // 中心频率 fc(k) = 1000 * 2^(k/N)，统计落在 [minFreq, maxFreq] 内的 k
+        const int n = std::max(1, layout.octaveFraction);
+        const int kMin = static_cast<int>(std::ceil(n * std::log2(layout.minFreq / 1000.0f)));
+        const int kMax = static_cast<int>(std::floor(n * std::log2(layout.maxFreq / 1000.0f)));
+        return std::clamp(kMax - kMin + 1, 1, kMaxBars);
+    }
+    return std::clamp(layout.barCount, 1, kMaxBars);
+}
+
+int SpectrumProcessor::fftSizeFor(const BandLayout& layout)
+{
+    return layout.scale == BandLayout::ConstantQ ? kConstantQFftSize : kDefaultFftSize;
+}
+
+void SpectrumProcessor::bandEdges(const BandLayout& layout, int bar, int barCount, float& lo, float& hi)
+{
+    if (layout.scale == BandLayout::FractionalOctave) {
+        const int n = std::max(1, layout.octaveFraction);
+        const int kMin = static_cast<int>(std::ceil(n * std::log2(layout.minFreq / 1000.0f)));
+        const float center = 1000.0f * std::exp2(static_cast<float>(kMin + bar) / n);
+        const float halfBand = std::exp2(0.5f / n);
+        lo = center / halfBand;
+        hi = center * halfBand;
+        return;
+    }
+
+    // 对数等分：第 bar 个频带覆盖 [min*r^bar, min*r^(bar+1)]，r = (max/min)^(1/barCount)
+    const float logMin = std::log10(layout.minFreq);
+    const float logRange = std::log10(layout.maxFreq) - logMin;
+    lo = std::pow(10.0f, logMin + logRange * bar / barCount);
+    hi = std::pow(10.0f, logMin + logRange * (bar + 1) / barCount);
+}
+
+bool SpectrumProcessor::configure(int sampleRate, int fftSize)
+{
+    if (sampleRate <= 0 || fftSize <= 0) return false;
+    if (sampleRate == m_sampleRate && fftSize == m_fftSize) return false;
+
+    m_sampleRate = sampleRate;
+    m_fftSize = fftSize;
+    rebuildTables();
+    return true;
+}
+
+void SpectrumProcessor::rebuildTables()
+{
+    const int halfN = m_fftSize / 2;
+    const float binHz = static_cast<float>(m_sampleRate) / m_fftSize;
+
+    for (int bar = 0; bar < m_barCount; ++bar) {
+        float lo = 0.0f;
+        float hi = 0.0f;
+        bandEdges(m_layout, bar, m_barCount, lo, hi);
+
+        // 频率边界 → bin 范围；跳过 DC，且每个 bar 至少覆盖一个 bin，
+        // 低频端分辨率不足时相邻 bar 会共享同一个 bin（而不是输出空柱）
+        int startBin = std::clamp(static_cast<int>(lo / binHz), 1, halfN - 1);
+        int endBin = std::clamp(static_cast<int>(std::ceil(hi / binHz)), startBin + 1, halfN);
+
+        m_binStart[bar] = startBin;
+        m_binEnd[bar] = endBin;
+
+        // 几何中心频率用于 A计权
+        const float centerFreq = std::sqrt(lo * hi);
+        m_scale[bar] = aWeighting(centerFreq) * kGain / static_cast<float>(m_fftSize);
+    }
+
+    if (m_layout.scale == BandLayout::ConstantQ) {
+        rebuildConstantQKernels();
+    } else {
+        m_kernelBin.clear();
+        m_kernelWeight.clear();
+    }
+}
+
+/**
+ * 常数 Q 频域核（Brown & Puckette 1992）
+ *
+ * bar k 的时域核 g[n] = w_k[n]·e^{i2πf_k·n/fs} / S，长度 N_k = Q·fs/f_k（上限 N，居中放置），
+ * 由 Parseval 定理：Σ y[n]·conj(g[n]) = (1/N)·Σ Y[j]·conj(G[j])，
+ * 因此每帧只需把 STFT 的 FFT 输出与预先算好的稀疏 conj(G)/N 做内积。
+ * STFT 输入已乘过 Hann 窗 w_N，归一化 S = 2·Σ(w_N·w_k) 使幅度为 A 的正弦
+ * 输出 A/4，与幅度谱路径的 |X|/N 量纲一致，后续增益和平滑无需区分。
+ */
+void SpectrumProcessor::rebuildConstantQKernels()
+{
+    const int n = m_fftSize;
+    const int halfN = n / 2;
+    const float nyquist = m_sampleRate * 0.5f;
+
+    FFT fft(n);
+    std::vector<FftComplex> temporal(n);
+    std::vector<FftComplex> spectral(n);
+
+    m_kernelBin.clear();
+    m_kernelWeight.clear();
+
+    for (int bar = 0; bar < m_barCount; ++bar) {
+        m_kernelOffset[bar] = static_cast<int>(m_kernelBin.size());
+
+        float lo = 0.0f;
+        float hi = 0.0f;
+        bandEdges(m_layout, bar, m_barCount, lo, hi);
+        const float centerFreq = std::sqrt(lo * hi);
+        if (centerFreq >= nyquist) continue;   // 超出 Nyquist 的 bar 保持为空
+
+        // Q = f / 带宽；低频端窗口被 N 截断，分辨率退化为 STFT 的极限
+        const float q = centerFreq / (hi - lo);
+        const int length = std::clamp(static_cast<int>(std::ceil(q * m_sampleRate / centerFreq)), 2, n);
+        const int start = (n - length) / 2;
+        const float omega = 2.0f * static_cast<float>(M_PI) * centerFreq / m_sampleRate;
+
+        std::fill(temporal.begin(), temporal.end(), FftComplex());
+        float norm = 0.0f;
+        for (int i = 0; i < length; ++i) {
+            const int pos = start + i;
+            const float w = hann(i, length);
+            temporal[pos] = FftComplex(w * std::cos(omega * pos), w * std::sin(omega * pos));
+            norm += w * hann(pos, n);
+        }
+        if (norm <= 0.0f) continue;
+
+        fft.forward(temporal, spectral);
+
+        // 稀疏化：只保留正频率半边中幅度不低于峰值 kSparsity 的项
+        float peak = 0.0f;
+        for (int j = 0; j < halfN; ++j) {
+            peak = std::max(peak, std::sqrt(spectral[j].r * spectral[j].r + spectral[j].i * spectral[j].i));
+        }
+        const float threshold = peak * kSparsity;
+        const float scale = 1.0f / (2.0f * norm * n);
+        for (int j = 0; j < halfN; ++j) {
+            const FftComplex& g = spectral[j];
+            if (std::sqrt(g.r * g.r + g.i * g.i) < threshold) continue;
+            m_kernelBin.push_back(j);
+            m_kernelWeight.push_back(FftComplex(g.r * scale, -g.i * scale));
+        }
+
+        // 核已归一化，只保留 A计权和增益
+        m_scale[bar] = aWeighting(centerFreq) * kGain;
+    }
+    m_kernelOffset[m_barCount] = static_cast<int>(m_kernelBin.size());
+}
+
+bool SpectrumProcessor::beginFrame(int& planeCount)
+{
+    if (m_fftSize == 0) return false;
+
+    planeCount = std::clamp(planeCount, 1, kMaxPlanes);
+    if (planeCount != m_planeCount) {
+        // 单声道 ↔ 立体声切换：工作缓冲不再对应同一信号
+        reset();
+        m_planeCount = planeCount;
+    }
+    return true;
+}
+
+void SpectrumProcessor::process(const float* const* planes, int planeCount, int binCount)
+{
+    if (!planes || !beginFrame(planeCount)) return;
+
+    for (int plane = 0; plane < m_planeCount; ++plane) {
+        mapPlane(planes[plane], binCount, plane);
+        smoothPlane(plane);
+    }
+}
+
+void SpectrumProcessor::processComplex(const FftComplex* const* planes, int planeCount, int binCount)
+{
+    if (!planes || !beginFrame(planeCount)) return;
+
+    for (int plane = 0; plane < m_planeCount; ++plane) {
+        mapPlaneConstantQ(planes[plane], binCount, plane);
+        smoothPlane(plane);
+    }
+}
+
+void SpectrumProcessor::mapPlane(const float* magnitudes, int binCount, int plane)
+{
+    float* weighted = m_weighted[plane].data();
+
+    // --- Step 1-3: 频带映射 + 归一化 + A计权 + 增益（查表）---
+    for (int bar = 0; bar < m_barCount; ++bar) {
+        const int endBin = std::min(m_binEnd[bar], binCount);
+        float maxMag = 0.0f;
+        for (int bin = m_binStart[bar]; bin < endBin; ++bin) {
+            maxMag = std::max(maxMag, magnitudes[bin]);
+        }
+        weighted[bar] = maxMag * m_scale[bar];
+    }
+}
+
+void SpectrumProcessor::mapPlaneConstantQ(const FftComplex* bins, int binCount, int plane)
+{
+    float* weighted = m_weighted[plane].data();
+    const int* kernelBin = m_kernelBin.data();
+    const FftComplex* kernelWeight = m_kernelWeight.data();
+
+    // --- Step 1-3: 稀疏核内积 + A计权 + 增益 ---
+    for (int bar = 0; bar < m_barCount; ++bar) {
+        float re = 0.0f;
+        float im = 0.0f;
+        for (int k = m_kernelOffset[bar]; k < m_kernelOffset[bar + 1]; ++k) {
+            const int bin = kernelBin[k];
+            if (bin >= binCount) break;   // 核按 bin 升序存放
+            const FftComplex& x = bins[bin];
+            const FftComplex& w = kernelWeight[k];
+            re += x.r * w.r - x.i * w.i;
+            im += x.r * w.i + x.i * w.r;
+        }
+        weighted[bar] = std::sqrt(re * re + im * im) * m_scale[bar];
+    }
+}
+
+void SpectrumProcessor::smoothPlane(int plane)
+{
+    const float* weighted = m_weighted[plane].data();
+    float* bars = m_bars[plane].data();
+
+    // --- Step 4: 空间平滑（边界外复制自身）---
+    for (int bar = 0; bar < m_barCount; ++bar) {
+        float convVal = 0.0f;
+        for (int ki = 0; ki < kKernelSize; ++ki) {
+            const int neighbor = bar + ki - kKernelSize / 2;
+            const bool inside = neighbor >= 0 && neighbor < m_barCount;
+            convVal += weighted[inside ? neighbor : bar] * kKernel[ki];
+        }
+        bars[bar] = convVal / kKernelSum;
+    }
+}
+
+void SpectrumProcessor::reset()
+{
+    for (int plane = 0; plane < kMaxPlanes; ++plane) {
+        m_weighted[plane].fill(0.0f);
+        m_bars[plane].fill(0.0f);
+    }
+}
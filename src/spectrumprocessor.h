@@ -0,0 +1,171 @@
+/*
+ * SpectrumProcessor - 频谱后处理流水线
+ *
+ * 把 STFT 输出的原始幅度谱转换为可直接绘制的频谱柱数据:
+ *   Step 1: 频带映射（每个 bar 取其 bin 范围内的最大幅度，布局见 BandLayout；
+ *           常数 Q 布局改为与稀疏频域核做复数内积）
+ *   Step 2: FFT 归一化 + A 计权感知加权
+ *   Step 3: 增益放大
+ *   Step 4: 空间平滑（卷积核 [1,2,3,5,3,2,1]）
+ * 时间方向的平滑（攻击/释放、峰值）与分析帧率无关，由 GUI 侧的 SpectrumDynamics 按实际帧间隔完成。
+ *
+ * 与采样率相关的一切（bin 范围、A 计权系数、归一化因子）都在 configure()
+ * 中预计算为扁平查找表，process() 只做查表和乘加，不做任何堆分配。
+ * 立体声 / M-S 分析时每帧有两个频谱平面，每个平面独立走完整流水线。
+ * 本类不依赖 Qt，也不加锁，由调用方保证单线程使用。
+ */
+#ifndef SPECTRUMPROCESSOR_H
+#define SPECTRUMPROCESSOR_H
+
+#include <array>
+#include <vector>
+
+#include "fft.h"
+
+/**
+ * @brief 频带布局描述
+ *
+ * Logarithmic:      在 [minFreq, maxFreq] 内按对数等分为 barCount 个频带
+ * FractionalOctave: 以 1kHz 为基准的 1/N 倍频程频带（N=3 即 1/3 倍频程），
+ *                   取中心频率落在 [minFreq, maxFreq] 内的所有频带，
+ *                   此时 barCount 由频率范围推导得出
+ * ConstantQ:        频带划分与 Logarithmic 相同，但每个 bar 用长度与频率成反比的
+ *                   时域核分析（Brown-Puckette 频域核乘法），低频 bar 不再挤在
+ *                   同一两个 bin 上；核长度以 FFT 长度为上限，开销有界
+ */
+struct BandLayout {
+    enum Scale { Logarithmic, FractionalOctave, ConstantQ };
+
+    Scale scale = Logarithmic;
+    int barCount = 41;          // 仅 Logarithmic 使用
+    float minFreq = 20.0f;
+    float maxFreq = 20000.0f;
+    int octaveFraction = 3;     // 仅 FractionalOctave 使用：1/N 倍频程
+
+    static BandLayout logarithmic(int bars, float minHz = 20.0f, float maxHz = 20000.0f)
+    {
+        BandLayout layout;
+        layout.barCount = bars;
+        layout.minFreq = minHz;
+        layout.maxFreq = maxHz;
+        return layout;
+    }
+
+    static BandLayout fractionalOctave(int fraction, float minHz = 20.0f, float maxHz = 20000.0f)
+    {
+        BandLayout layout;
+        layout.scale = FractionalOctave;
+        layout.octaveFraction = fraction;
+        layout.minFreq = minHz;
+        layout.maxFreq = maxHz;
+        return layout;
+    }
+
+    static BandLayout constantQ(int bars, float minHz = 20.0f, float maxHz = 20000.0f)
+    {
+        BandLayout layout = logarithmic(bars, minHz, maxHz);
+        layout.scale = ConstantQ;
+        return layout;
+    }
+
+    bool operator==(const BandLayout& o) const
+    {
+        return scale == o.scale && barCount == o.barCount && minFreq == o.minFreq
+            && maxFreq == o.maxFreq && octaveFraction == o.octaveFraction;
+    }
+    bool operator!=(const BandLayout& o) const { return !(*this == o); }
+};
+
+class SpectrumProcessor
+{
+public:
+    static constexpr int kMaxBars = 128;   // 固定缓冲区上限
+    static constexpr int kMaxPlanes = 2;   // 最多两个声道平面（L/R 或 M/S）
+
+    explicit SpectrumProcessor(const BandLayout& layout = BandLayout());
+
+    /**
+     * @brief 更换频带布局（立即重建查找表并清空工作缓冲）
+     */
+    void setLayout(const BandLayout& layout);
+    const BandLayout& layout() const { return m_layout; }
+
+    /**
+     * @brief 计算某个布局实际产生的 bar 数量（不超过 kMaxBars）
+     */
+    static int barCountFor(const BandLayout& layout);
+
+    /**
+     * @brief 某个布局推荐的 STFT 长度（常数 Q 需要更长的窗口才能分辨低频）
+     */
+    static int fftSizeFor(const BandLayout& layout);
+
+    /**
+     * @brief 当前布局是否需要复数频谱（是则调用 processComplex()）
+     */
+    bool needsComplexBins() const { return m_layout.scale == BandLayout::ConstantQ; }
+
+    /**
+     * @brief 按采样率和 FFT 长度重建频带查找表（格式变化时由分析线程自动调用）
+     * @return 查找表是否被重建（参数未变时直接返回 false）
+     */
+    bool configure(int sampleRate, int fftSize);
+
+    /**
+     * @brief 处理一帧原始幅度谱
+     * @param planes 每个平面 N/2 点原始 FFT 幅度
+     * @param planeCount 平面数量（1 或 2）
+     * @param binCount 每个平面的长度
+     */
+    void process(const float* const* planes, int planeCount, int binCount);
+
+    /**
+     * @brief 处理一帧复数频谱（常数 Q 布局使用）
+     * @param planes 每个平面 N/2 点加窗 FFT 输出
+     */
+    void processComplex(const FftComplex* const* planes, int planeCount, int binCount);
+
+    // 清空工作缓冲（切歌时调用）
+    void reset();
+
+    int barCount() const { return m_barCount; }
+    int planeCount() const { return m_planeCount; }
+    int sampleRate() const { return m_sampleRate; }
+
+    // Step 4 输出（空间平滑后，用于绘制）
+    const float* bars(int plane = 0) const { return m_bars[plane].data(); }
+
+private:
+    void rebuildTables();
+    void rebuildConstantQKernels();
+    bool beginFrame(int& planeCount);
+    void mapPlane(const float* magnitudes, int binCount, int plane);
+    void mapPlaneConstantQ(const FftComplex* bins, int binCount, int plane);
+    void smoothPlane(int plane);
+
+    // 计算布局中第 bar 个频带的上下边界频率（Hz）
+    static void bandEdges(const BandLayout& layout, int bar, int barCount, float& lo, float& hi);
+
+    BandLayout m_layout;
+    int m_barCount;
+    int m_planeCount = 1;
+    int m_sampleRate = 0;
+    int m_fftSize = 0;
+
+    // 预计算查找表：bar i 覆盖 [m_binStart[i], m_binEnd[i]) 个 bin
+    std::array<int, kMaxBars> m_binStart{};
+    std::array<int, kMaxBars> m_binEnd{};
+    std::array<float, kMaxBars> m_scale{};     // 1/fftSize * A计权 * 增益（常数 Q 时核已归一化，不含 1/fftSize）
+
+    // 常数 Q 稀疏频域核：bar i 的非零项为 [m_kernelOffset[i], m_kernelOffset[i+1])
+    std::array<int, kMaxBars + 1> m_kernelOffset{};
+    std::vector<int> m_kernelBin;
+    std::vector<FftComplex> m_kernelWeight;    // conj(FFT(时域核)) / N
+
+    // 固定工作缓冲区（每平面一份）
+    typedef std::array<std::array<float, kMaxBars>, kMaxPlanes> PlaneBuffer;
+    PlaneBuffer m_weighted{};  // Step 1-3 输出
+    PlaneBuffer m_bars{};      // Step 4 输出
+};
+
+#endif // SPECTRUMPROCESSOR_H
@@ -0,0 +1,267 @@
+/*
+ * SpectrumRenderer 实现
+ */
+#include "spectrumrenderer.h"
+#include "simdkernels.h"
+
+#include <QLinearGradient>
+#include <QtGlobal>
+#include <cstring>
+
+void SpectrumRenderer::setColors(const QColor &topColor, const QColor &bottomColor,
+                                 const QColor &midColor, const QColor &peakColor)
+{
+    m_topColor = topColor;
+    m_bottomColor = bottomColor;
+    m_midColor = midColor;
+    m_peakColor = peakColor;
+    m_spritesDirty = true;   // 渐变条需要按新配色重建
+}
+
+void SpectrumRenderer::setBarSize(int width, int spacing)
+{
+    m_barWidth = width;
+    m_barSpacing = spacing;
+    m_spritesDirty = true;   // 渐变条宽度跟随柱宽
+}
+
+/**
+ * @brief 计算某根柱在画布中的位置
+ *
+ * 单声道：自左向右，自底向上
+ * 镜像：低频居中，第一平面（L/M）向左，第二平面（R/S）向右；柱宽按半宽自适应
+ * 分屏：以水平中线为根，第一平面向上、第二平面向下
+ */
+SpectrumRenderer::BarSlot SpectrumRenderer::barSlot(int plane, int bar, int barCount, int planeCount) const
+{
+    const int totalHeight = m_size.height();
+    const int stride = m_barWidth + m_barSpacing;
+
+    if (planeCount == 1) {
+        return {bar * stride, m_barWidth, totalHeight, totalHeight, true};
+    }
+
+    if (m_stereoLayout == MirroredBars) {
+        const int centerX = m_size.width() / 2;
+        const int halfStride = qMax(1, qMin(stride, centerX / qMax(1, barCount)));
+        const int barWidth = qMax(1, qMin(m_barWidth, halfStride - m_barSpacing));
+        const int x = plane == 0 ? centerX - (bar + 1) * halfStride
+                                 : centerX + bar * halfStride + m_barSpacing;
+        return {x, barWidth, totalHeight, totalHeight, true};
+    }
+
+    const int midY = totalHeight / 2;
+    return plane == 0 ? BarSlot{bar * stride, m_barWidth, midY, midY, true}
+                      : BarSlot{bar * stride, m_barWidth, midY, totalHeight - midY, false};
+}
+
+/**
+ * @brief 柱高换算为像素（0 表示只画最小可见点）
+ *
+ * AudioSpectrum 方式：amplitude 直接线性映射到像素。
+ * amplitude 的值域：典型音乐 ≈ 0.05 ~ 1.5，峰值可达 2.0+
+ * 总体设计：正常音量时大部分 bar 在 10%~60% 高度，强节拍时部分 bar 可达 80%~100%
+ */
+int SpectrumRenderer::barLength(float amplitude, int span)
+{
+    if (amplitude < 0.005f) {
+        return 0;
+    }
+    int length = static_cast<int>(amplitude * kVisualScale * (span - 4));
+    length = qMax(length, 1);        // 最少 1px
+    return qMin(length, span - 2);   // 不超出可用区域
+}
+
+/**
+ * @brief 峰值高度换算为像素（0 表示不显示）
+ */
+int SpectrumRenderer::peakLength(float peak, int span)
+{
+    if (peak < 0.01f) {
+        return 0;
+    }
+    int length = static_cast<int>(peak * kVisualScale * (span - 4));
+    length = qMax(length, 2);
+    return qMin(length, span - 2);
+}
+
+/**
+ * @brief 按需重建渐变条缓存
+ *
+ * 渐变条是一张柱宽 × 可用高度的整列渐变（根部深色 → 60% 中间色 → 远端亮色），
+ * 柱子高度为 h 时只需从靠近根部的一端截取 h 行贴图。
+ */
+void SpectrumRenderer::prepare(int planeCount)
+{
+    const int totalHeight = m_size.height();
+    const int midY = totalHeight / 2;
+    const bool split = planeCount > 1 && m_stereoLayout == SplitBars;
+    const int upSpan = split ? midY : totalHeight;
+    const int downSpan = split ? totalHeight - midY : 0;
+
+    const int spriteWidth = qMax(1, m_barWidth);
+    const bool upValid = m_spriteUp.width() == spriteWidth && m_spriteUp.height() == upSpan;
+    const bool downValid = downSpan <= 0 || (m_spriteDown.width() == spriteWidth && m_spriteDown.height() == downSpan);
+    if (!m_spritesDirty && upValid && downValid) {
+        return;
+    }
+
+    auto buildSprite = [&](int span, bool upward) {
+        QImage sprite(spriteWidth, qMax(1, span), QImage::Format_ARGB32_Premultiplied);
+        sprite.fill(Qt::transparent);
+        QPainter p(&sprite);
+        // 远端（柱顶）为亮色，根部为深色
+        QLinearGradient gradient(0, upward ? 0 : span, 0, upward ? span : 0);
+        gradient.setColorAt(0.0, m_topColor);
+        gradient.setColorAt(0.6, m_midColor);
+        gradient.setColorAt(1.0, m_bottomColor);
+        p.fillRect(sprite.rect(), gradient);
+        return sprite;
+    };
+
+    m_spriteUp = buildSprite(upSpan, true);
+    m_spriteDown = downSpan > 0 ? buildSprite(downSpan, false) : QImage();
+    m_spritesDirty = false;
+}
+
+/**
+ * @brief 绘制所有与 clip 相交的柱子
+ */
+void SpectrumRenderer::paint(QPainter &painter, const QRect &clip, const float *levels, const float *peaks,
+                             int barCount, int planeCount) const
+{
+    for (int plane = 0; plane < planeCount; ++plane) {
+        for (int bar = 0; bar < barCount; ++bar) {
+            const BarSlot slot = barSlot(plane, bar, barCount, planeCount);
+            if (!clip.intersects(slot.column())) {
+                continue;
+            }
+            const int i = plane * barCount + bar;
+            paintBar(painter, slot.upward ? m_spriteUp : m_spriteDown, slot, levels[i], peaks[i]);
+        }
+    }
+}
+
+/**
+ * @brief 绘制单根频谱柱
+ *
+ * 柱体本身从缓存的渐变条截取贴图，不再逐柱构造渐变。
+ */
+void SpectrumRenderer::paintBar(QPainter &painter, const QImage &sprite, const BarSlot &slot,
+                                float amplitude, float peak) const
+{
+    // 把“距根部的长度”换算为矩形（向上生长时矩形在根部之上）
+    auto barRect = [&](int length) {
+        return slot.upward ? QRect(slot.x, slot.baseY - length, slot.width, length)
+                           : QRect(slot.x, slot.baseY, slot.width, length);
+    };
+
+    const int length = barLength(amplitude, slot.span);
+    if (length == 0) {
+        // 极低能量：画最小可见点（避免空隙）
+        painter.fillRect(barRect(qMax(1, slot.span / 30)), m_bottomColor);
+        return;
+    }
+
+    // 从渐变条靠根部的一端截取 length 行
+    const QRect source(0, slot.upward ? sprite.height() - length : 0, slot.width, length);
+    painter.drawImage(barRect(length), sprite, source);
+
+    // 峰值指示器
+    const int peakPixels = peakLength(peak, slot.span);
+    if (peakPixels > length + 3) {
+        painter.fillRect(slot.upward ? QRect(slot.x, slot.baseY - peakPixels, slot.width, 2)
+                                     : QRect(slot.x, slot.baseY + peakPixels - 2, slot.width, 2),
+                         m_peakColor);
+    }
+}
+
+/**
+ * @brief 软件合成所有与 clip 相交的柱子
+ *
+ * 先整块恢复背景，再按与 paint() 相同的几何逐柱混合，
+ * 每行只是一次 blendOver / blendSolid 调用，没有 QPainter 状态机和光栅化开销。
+ */
+void SpectrumRenderer::composite(QImage &target, const QImage &background, const QRect &clip,
+                                 const float *levels, const float *peaks, int barCount, int planeCount) const
+{
+    const QRect area = clip & target.rect();
+    if (area.isEmpty()) {
+        return;
+    }
+    copyRect(target, background, area);
+
+    for (int plane = 0; plane < planeCount; ++plane) {
+        for (int bar = 0; bar < barCount; ++bar) {
+            const BarSlot slot = barSlot(plane, bar, barCount, planeCount);
+            if (!area.intersects(slot.column())) {
+                continue;
+            }
+            const int i = plane * barCount + bar;
+            compositeBar(target, slot.upward ? m_spriteUp : m_spriteDown, slot, area, levels[i], peaks[i]);
+        }
+    }
+}
+
+void SpectrumRenderer::copyRect(QImage &target, const QImage &source, const QRect &rect)
+{
+    const QRect area = rect & target.rect() & source.rect();
+    if (area.isEmpty()) {
+        return;
+    }
+    const size_t bytes = static_cast<size_t>(area.width()) * sizeof(quint32);
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        std::memcpy(reinterpret_cast<quint32 *>(target.scanLine(y)) + area.left(),
+                    reinterpret_cast<const quint32 *>(source.constScanLine(y)) + area.left(), bytes);
+    }
+}
+
+void SpectrumRenderer::blendFill(QImage &target, const QRect &rect, const QColor &color)
+{
+    const QRect area = rect & target.rect();
+    if (area.isEmpty()) {
+        return;
+    }
+    const quint32 pixel = qPremultiply(color.rgba());
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        simd::blendSolid(reinterpret_cast<quint32 *>(target.scanLine(y)) + area.left(), pixel, area.width());
+    }
+}
+
+/**
+ * @brief 软件合成单根频谱柱（几何与 paintBar 完全相同，只处理 clip 内的行列）
+ */
+void SpectrumRenderer::compositeBar(QImage &target, const QImage &sprite, const BarSlot &slot, const QRect &clip,
+                                    float amplitude, float peak) const
+{
+    auto barRect = [&](int length) {
+        return slot.upward ? QRect(slot.x, slot.baseY - length, slot.width, length)
+                           : QRect(slot.x, slot.baseY, slot.width, length);
+    };
+
+    const int length = barLength(amplitude, slot.span);
+    if (length == 0) {
+        blendFill(target, barRect(qMax(1, slot.span / 30)) & clip, m_bottomColor);
+        return;
+    }
+
+    // 渐变条第 sourceTop 行对应柱子矩形的第一行
+    const QRect bar = barRect(length);
+    const QRect area = bar & clip;
+    if (!area.isEmpty()) {
+        const int sourceTop = slot.upward ? sprite.height() - length : 0;
+        const int columns = qMin(area.width(), sprite.width() - (area.left() - slot.x));
+        for (int y = area.top(); columns > 0 && y <= area.bottom(); ++y) {
+            const quint32 *src = reinterpret_cast<const quint32 *>(sprite.constScanLine(sourceTop + y - bar.top()))
+                                 + (area.left() - slot.x);
+            simd::blendOver(reinterpret_cast<quint32 *>(target.scanLine(y)) + area.left(), src, columns);
+        }
+    }
+
+    const int peakPixels = peakLength(peak, slot.span);
+    if (peakPixels > length + 3) {
+        blendFill(target, (slot.upward ? QRect(slot.x, slot.baseY - peakPixels, slot.width, 2)
+                                       : QRect(slot.x, slot.baseY + peakPixels - 2, slot.width, 2)) & clip,
+                  m_peakColor);
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * SpectrumRenderer - 频谱柱绘制（与窗口无关）
+ *
+ * 负责柱子几何、渐变条缓存和逐柱绘制，只依赖 QPainter / QImage：
+ *   - SpectrumBars 在 paintEvent 中用它绘制到控件
+ *   - OfflineRenderer 在工作线程中用它绘制到 QImage（无窗口、无声卡）
+ *
+ * 渐变条使用 QImage 而不是 QPixmap，因此可以在非 GUI 线程中绘制。
+ * 除 QPainter 路径外还提供一条纯软件合成路径（composite），直接在
+ * Format_ARGB32_Premultiplied 图像上用 SIMD 混合背景、柱子和峰值。
+ * prepare() 之后 paint() 只读，多个线程可以各自持有一份拷贝并行绘制
+ * （QImage 隐式共享，拷贝不复制像素）。
+ */
+#ifndef SPECTRUMRENDERER_H
+#define SPECTRUMRENDERER_H
+
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+#include <QSize>
+
+class SpectrumRenderer
+{
+public:
+    /**
+     * @brief 双平面（立体声 / M-S）分析时的绘制方式
+     */
+    enum StereoLayout {
+        MirroredBars,   // 低频居中，第一平面向左展开，第二平面向右展开
+        SplitBars       // 上半部分第一平面向上，下半部分第二平面向下
+    };
+
+    /**
+     * @brief 一根柱子在画布中的位置
+     */
+    struct BarSlot {
+        int x;
+        int width;
+        int baseY;      // 根部 y 坐标
+        int span;       // 可用的最大长度（像素）
+        bool upward;    // true 向上生长，false 向下生长
+
+        // 柱子可能占据的整列区域（用于失效区域计算）
+        QRect column() const
+        {
+            return upward ? QRect(x, baseY - span, width, span) : QRect(x, baseY, width, span);
+        }
+    };
+
+    static constexpr float kVisualScale = 2.5f;  // 视觉放大，补偿 A计权后的值域收缩
+
+    void setColors(const QColor &topColor, const QColor &bottomColor,
+                   const QColor &midColor, const QColor &peakColor);
+    const QColor &topColor() const { return m_topColor; }
+    const QColor &bottomColor() const { return m_bottomColor; }
+    const QColor &midColor() const { return m_midColor; }
+    const QColor &peakColor() const { return m_peakColor; }
+
+    void setBarSize(int width, int spacing);
+    int barWidth() const { return m_barWidth; }
+    int barSpacing() const { return m_barSpacing; }
+
+    void setStereoLayout(StereoLayout layout) { m_stereoLayout = layout; }
+    StereoLayout stereoLayout() const { return m_stereoLayout; }
+
+    // 画布尺寸（控件或输出图像的大小）
+    void setSize(const QSize &size) { m_size = size; }
+    const QSize &size() const { return m_size; }
+
+    BarSlot barSlot(int plane, int bar, int barCount, int planeCount) const;
+    static int barLength(float amplitude, int span);
+    static int peakLength(float peak, int span);
+
+    /**
+     * @brief 按需重建渐变条缓存（尺寸、配色、柱宽或平面数变化时），须在 paint() 之前调用
+     */
+    void prepare(int planeCount);
+
+    /**
+     * @brief 绘制所有与 clip 相交的柱子（不清除背景）
+     * @param levels / peaks planeCount × barCount 个柱高和峰值，下标 = plane * barCount + bar
+     */
+    void paint(QPainter &painter, const QRect &clip, const float *levels, const float *peaks,
+               int barCount, int planeCount) const;
+
+    /**
+     * @brief 软件合成：把 background 的 clip 区域拷入 target，再逐柱做预乘 src-over 混合
+     *
+     * target 与 background 都必须是 Format_ARGB32_Premultiplied 且与画布同尺寸。
+     * 不经过 QPainter，结果与 paint() 画在同一背景上逐像素一致（混合舍入误差 ±1）。
+     */
+    void composite(QImage &target, const QImage &background, const QRect &clip,
+                   const float *levels, const float *peaks, int barCount, int planeCount) const;
+
+    // 把 source 的 rect 区域逐行拷贝到 target 的相同位置（两者同为 32 位格式）
+    static void copyRect(QImage &target, const QImage &source, const QRect &rect);
+
+    // 用纯色对 target 的 rect 区域做 src-over 混合（颜色可以半透明）
+    static void blendFill(QImage &target, const QRect &rect, const QColor &color);
+
+private:
+    void paintBar(QPainter &painter, const QImage &sprite, const BarSlot &slot,
+                  float amplitude, float peak) const;
+    void compositeBar(QImage &target, const QImage &sprite, const BarSlot &slot, const QRect &clip,
+                      float amplitude, float peak) const;
+
+    QColor m_topColor{"#8CEFFD"};     // 频谱柱顶部颜色
+    QColor m_bottomColor{"#71CDFD"};  // 频谱柱底部颜色
+    QColor m_midColor{"#4C5FD1"};     // 频谱柱中间颜色
+    QColor m_peakColor{"#FF71CD"};    // 峰值指示器颜色
+    int m_barWidth = 3;               // 频谱柱宽度（像素）
+    int m_barSpacing = 1;             // 频谱柱间距（像素）
+    StereoLayout m_stereoLayout = MirroredBars;
+    QSize m_size{0, 0};
+
+    // 渐变条缓存（paint 只做子矩形贴图）
+    QImage m_spriteUp;                // 向上生长的柱使用
+    QImage m_spriteDown;              // 分屏模式下向下生长的柱使用
+    bool m_spritesDirty = true;       // 配色或柱宽变化后需要重建
+};
+
+#endif // SPECTRUMRENDERER_H
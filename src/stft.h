@@ -0,0 +1,293 @@
+/*
+ * STFT (短时傅里叶变换) 分析级
+ *
+ * 把解码线程送来的交织 PCM 写入固定大小的滑动窗口，
+ * 每累计 hop 个采样就做一次 加窗 + FFT，输出一帧幅度谱。
+ * 频谱的输出速率只取决于 hop（sampleRate / hop 帧每秒），与 MP3 帧长无关。
+ *
+ * 声道模式:
+ *   - Mono:    下混为单声道，输出 1 个频谱平面
+ *   - Stereo:  SIMD 解交织为 L/R 两个平面
+ *   - MidSide: 解交织后转换为 M=(L+R)/2, S=(L-R)/2 两个平面
+ * 双平面模式下两路实信号打包成一个复信号 z = l + i·r，
+ * 一次复数 FFT 同时得到两个频谱（利用实信号频谱的共轭对称性拆分）。
+ * 每帧同时给出幅度谱和复数谱，后者供常数 Q 等需要相位的变换使用；
+ * 另外附带展开后的未加窗时域样本，示波器等波形显示直接复用同一个分析抽头。
+ *
+ * 特点:
+ *   - 窗函数只在 configure() 时预计算一次
+ *   - 所有缓冲区预分配，push() 过程中不做任何堆分配
+ *   - hop 可配置：hop = N/2 为 50% 重叠，hop = N/4 为 75% 重叠
+ *
+ * 使用方式:
+ *   StftAnalyzer stft(1024, 512, StftAnalyzer::Stereo);
+ *   stft.push(pcm, frames, channels, [](const SpectrumFrame& frame) { ... });
+ *   stft.reset();   // seek 之后清空历史，避免拼接不连续的采样
+ */
+#ifndef TTPLAYER_STFT_H
+#define TTPLAYER_STFT_H
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "fft.h"
+#include "simdkernels.h"
+
+/**
+ * @brief 一帧 STFT 输出（引用 StftAnalyzer 内部缓冲，回调返回后失效）
+ */
+struct SpectrumFrame {
+    static constexpr int kMaxPlanes = 2;
+
+    const float* planes[kMaxPlanes] = {nullptr, nullptr};  // 每个平面 binCount 个原始幅度
+    const FftComplex* bins[kMaxPlanes] = {nullptr, nullptr};  // 每个平面 binCount 个复数频谱（加窗 FFT 输出）
+    const float* samples[kMaxPlanes] = {nullptr, nullptr};    // 每个平面 2 × binCount 个时域样本（未加窗，最旧在前）
+    int planeCount = 1;   // 1 = 单声道；2 = L/R 或 M/S
+    int binCount = 0;     // N/2
+    int hopSize = 0;      // 相邻两帧间隔的样本数（帧率 = sampleRate / hopSize）
+    bool discontinuity = false;  // 与上一帧之间采样不连续（reset() 之后的第一帧）
+};
+
+class StftAnalyzer
+{
+public:
+    enum ChannelMode { Mono, Stereo, MidSide };
+
+    explicit StftAnalyzer(int fftSize = 1024, int hopSize = 512, ChannelMode mode = Mono)
+    {
+        configure(fftSize, hopSize, mode);
+    }
+
+    // 重新配置窗口长度、步长和声道模式（非实时调用：会重新分配缓冲区）
+    void configure(int fftSize, int hopSize, ChannelMode mode);
+
+    // 清空滑动窗口（seek / 切歌时调用）
+    void reset();
+
+    // 送入交织采样，每凑满一个 hop 调用一次 onSpectrum(const SpectrumFrame&)
+    template <typename Sample, typename Callback>
+    void push(const Sample* interleaved, int frames, int channels, Callback&& onSpectrum);
+
+    int fftSize() const { return m_fftSize; }
+    int hopSize() const { return m_hopSize; }
+    int binCount() const { return m_fftSize / 2; }
+    ChannelMode channelMode() const { return m_mode; }
+    int planeCount() const { return m_mode == Mono ? 1 : 2; }
+
+private:
+    static constexpr int kChunkFrames = 256;   // 解交织分块大小
+
+    // 把 count 个已解交织的样本写入环形历史，必要时触发分析
+    template <typename Callback>
+    void feed(const float* plane0, const float* plane1, int count, Callback&& onSpectrum);
+
+    void analyze();
+    void analyzeMono();
+    void analyzePair();
+
+    // PCM 样本转换为 [-1, 1] 浮点
+    static float toFloat(float s) { return s; }
+    static float toFloat(int16_t s) { return s / 32768.0f; }
+
+    int m_fftSize = 0;
+    int m_hopSize = 0;
+    ChannelMode m_mode = Mono;
+    std::unique_ptr<FFT> m_fft;
+
+    std::vector<float> m_window;        // 预计算的 Hanning 窗
+    std::vector<float> m_history[SpectrumFrame::kMaxPlanes];  // 每平面环形历史（长度 N）
+    int m_writePos = 0;                 // 下一个写入位置（同时也是最旧样本位置）
+    int m_filled = 0;                   // 已填充的有效样本数（<= N）
+    int m_sinceLastHop = 0;             // 距上次输出已累计的样本数
+
+    float m_chunk[SpectrumFrame::kMaxPlanes][kChunkFrames];   // 解交织暂存
+
+    std::vector<FftComplex> m_fftIn;
+    std::vector<FftComplex> m_fftOut;
+    std::vector<float> m_magnitudes[SpectrumFrame::kMaxPlanes];  // 每平面 N/2 点幅度谱
+    std::vector<FftComplex> m_bins[SpectrumFrame::kMaxPlanes];   // 双平面模式拆分后的复数谱
+    std::vector<float> m_samples[SpectrumFrame::kMaxPlanes];     // 按时间顺序展开的窗口（未加窗）
+    SpectrumFrame m_frame;
+};
+
+// ========== 内联实现 ==========
+
+inline void StftAnalyzer::configure(int fftSize, int hopSize, ChannelMode mode)
+{
+    m_fft = std::make_unique<FFT>(fftSize);
+    m_fftSize = m_fft->size();  // FFT 会把非法长度回退到 1024
+    m_hopSize = std::max(1, std::min(hopSize, m_fftSize));
+    m_mode = mode;
+
+    m_window.resize(m_fftSize);
+    for (int i = 0; i < m_fftSize; ++i) {
+        m_window[i] = 0.5f * (1.0f - std::cos(2.0f * static_cast<float>(M_PI) * i / (m_fftSize - 1)));
+    }
+
+    m_fftIn.assign(m_fftSize, FftComplex());
+    m_fftOut.assign(m_fftSize, FftComplex());
+
+    m_frame.planeCount = planeCount();
+    m_frame.binCount = m_fftSize / 2;
+    m_frame.hopSize = m_hopSize;
+    for (int p = 0; p < SpectrumFrame::kMaxPlanes; ++p) {
+        const bool used = p < m_frame.planeCount;
+        m_history[p].assign(used ? m_fftSize : 0, 0.0f);
+        m_samples[p].assign(used ? m_fftSize : 0, 0.0f);
+        m_frame.samples[p] = used ? m_samples[p].data() : nullptr;
+        m_magnitudes[p].assign(used ? m_fftSize / 2 : 0, 0.0f);
+        m_frame.planes[p] = used ? m_magnitudes[p].data() : nullptr;
+
+        // 单声道直接引用 FFT 输出的前 N/2 点（forward() 尺寸匹配时不会重新分配）
+        const bool split = used && m_mode != Mono;
+        m_bins[p].assign(split ? m_fftSize / 2 : 0, FftComplex());
+        m_frame.bins[p] = !used ? nullptr : (split ? m_bins[p].data() : m_fftOut.data());
+    }
+
+    reset();
+}
+
+inline void StftAnalyzer::reset()
+{
+    for (auto& history : m_history) {
+        std::fill(history.begin(), history.end(), 0.0f);
+    }
+    m_writePos = 0;
+    m_filled = 0;
+    m_sinceLastHop = 0;
+    m_frame.discontinuity = true;
+}
+
+template <typename Sample, typename Callback>
+inline void StftAnalyzer::push(const Sample* interleaved, int frames, int channels, Callback&& onSpectrum)
+{
+    if (!interleaved || frames <= 0 || channels <= 0) return;
+
+    for (int done = 0; done < frames; done += kChunkFrames) {
+        const int count = std::min(kChunkFrames, frames - done);
+        const Sample* src = interleaved + static_cast<size_t>(done) * channels;
+
+        if (m_mode != Mono && channels == 2) {
+            // SIMD 解交织为 L/R，M/S 模式再原地做和差变换
+            simd::deinterleaveStereo(src, m_chunk[0], m_chunk[1], count);
+            if (m_mode == MidSide) {
+                simd::leftRightToMidSide(m_chunk[0], m_chunk[1], count);
+            }
+        } else {
+            // 下混为单声道（避免把 L/R 交织样本当成连续时间序列）；
+            // 双平面模式遇到单声道文件时两个平面相同
+            const float downmix = 1.0f / channels;
+            for (int f = 0; f < count; ++f) {
+                float mono = 0.0f;
+                for (int ch = 0; ch < channels; ++ch) {
+                    mono += toFloat(src[f * channels + ch]);
+                }
+                m_chunk[0][f] = mono * downmix;
+            }
+            if (m_mode == Stereo) {
+                std::copy(m_chunk[0], m_chunk[0] + count, m_chunk[1]);
+            } else if (m_mode == MidSide) {
+                std::fill(m_chunk[1], m_chunk[1] + count, 0.0f);   // 单声道没有侧声道
+            }
+        }
+
+        feed(m_chunk[0], m_chunk[1], count, onSpectrum);
+    }
+}
+
+template <typename Callback>
+inline void StftAnalyzer::feed(const float* plane0, const float* plane1, int count, Callback&& onSpectrum)
+{
+    const bool pair = m_mode != Mono;
+    for (int f = 0; f < count; ++f) {
+        m_history[0][m_writePos] = plane0[f];
+        if (pair) m_history[1][m_writePos] = plane1[f];
+
+        // 推进环形缓冲
+        if (++m_writePos == m_fftSize) m_writePos = 0;
+        if (m_filled < m_fftSize) ++m_filled;
+
+        // 每 hop 个样本输出一帧（窗口填满之前不输出）
+        if (++m_sinceLastHop >= m_hopSize && m_filled == m_fftSize) {
+            m_sinceLastHop = 0;
+            analyze();
+            onSpectrum(static_cast<const SpectrumFrame&>(m_frame));
+            m_frame.discontinuity = false;
+        }
+    }
+}
+
+inline void StftAnalyzer::analyze()
+{
+    if (m_mode == Mono) {
+        analyzeMono();
+    } else {
+        analyzePair();
+    }
+}
+
+inline void StftAnalyzer::analyzeMono()
+{
+    // 从最旧样本开始展开环形缓冲（保留一份时域副本），同时加窗
+    const int n = m_fftSize;
+    float* samples = m_samples[0].data();
+    int src = m_writePos;
+    for (int i = 0; i < n; ++i) {
+        samples[i] = m_history[0][src];
+        m_fftIn[i] = FftComplex(samples[i] * m_window[i], 0.0f);
+        if (++src == n) src = 0;
+    }
+
+    m_fft->forward(m_fftIn, m_fftOut);
+
+    // 原始幅度值，感知映射交给 SpectrumProcessor 处理
+    const int halfN = n / 2;
+    float* mag = m_magnitudes[0].data();
+    for (int i = 0; i < halfN; ++i) {
+        const float re = m_fftOut[i].r;
+        const float im = m_fftOut[i].i;
+        mag[i] = std::sqrt(re * re + im * im);
+    }
+}
+
+inline void StftAnalyzer::analyzePair()
+{
+    // 批量 FFT：z[n] = w[n]·a[n] + i·w[n]·b[n]，一次复数 FFT 得到 Z = A + iB
+    const int n = m_fftSize;
+    float* samplesA = m_samples[0].data();
+    float* samplesB = m_samples[1].data();
+    int src = m_writePos;
+    for (int i = 0; i < n; ++i) {
+        samplesA[i] = m_history[0][src];
+        samplesB[i] = m_history[1][src];
+        m_fftIn[i] = FftComplex(samplesA[i] * m_window[i], samplesB[i] * m_window[i]);
+        if (++src == n) src = 0;
+    }
+
+    m_fft->forward(m_fftIn, m_fftOut);
+
+    // 实信号频谱共轭对称：A[k] = (Z[k] + conj(Z[N-k])) / 2
+    //                     B[k] = (Z[k] - conj(Z[N-k])) / 2i
+    const int halfN = n / 2;
+    float* magA = m_magnitudes[0].data();
+    float* magB = m_magnitudes[1].data();
+    FftComplex* binA = m_bins[0].data();
+    FftComplex* binB = m_bins[1].data();
+    for (int k = 0; k < halfN; ++k) {
+        const FftComplex& z = m_fftOut[k];
+        const FftComplex& zc = m_fftOut[k == 0 ? 0 : n - k];
+        const float aRe = 0.5f * (z.r + zc.r);
+        const float aIm = 0.5f * (z.i - zc.i);
+        const float bRe = 0.5f * (z.i + zc.i);
+        const float bIm = -0.5f * (z.r - zc.r);
+        binA[k] = FftComplex(aRe, aIm);
+        binB[k] = FftComplex(bRe, bIm);
+        magA[k] = std::sqrt(aRe * aRe + aIm * aIm);
+        magB[k] = std::sqrt(bRe * bRe + bIm * bIm);
+    }
+}
+
+#endif // TTPLAYER_STFT_H
@@ -0,0 +1,584 @@
+/*
+ * TagReader 实现
+ */
+#include "tagreader.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRunnable>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#include <QTextCodec>
+#else
+#include <QStringDecoder>
+#endif
+
+#include "medialibrary.h"
+
+namespace {
+
+constexpr int kId3v2HeaderSize = 10;
+constexpr int kId3v1Size = 128;
+constexpr int kApeFooterSize = 32;
+constexpr qint64 kMaxApeSize = 1 << 20;         // 更大的 APE 标签只可能是损坏的或带封面，不读
+
+quint32 bigEndian32(const uchar* p)
+{
+    return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3]);
+}
+
+quint32 littleEndian32(const uchar* p)
+{
+    return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24);
+}
+
+// ID3v2 的同步安全整数：每字节只用低 7 位
+quint32 synchsafe32(const uchar* p)
+{
+    return (quint32(p[0] & 0x7F) << 21) | (quint32(p[1] & 0x7F) << 14) | (quint32(p[2] & 0x7F) << 7)
+           | quint32(p[3] & 0x7F);
+}
+
+// 反同步：写入时在每个 0xFF 后插入了 0x00，读取时去掉
+QByteArray deunsynchronise(const uchar* data, qint64 size)
+{
+    QByteArray out;
+    out.reserve(static_cast<int>(size));
+    for (qint64 i = 0; i < size; ++i) {
+        out.append(static_cast<char>(data[i]));
+        if (data[i] == 0xFF && i + 1 < size && data[i + 1] == 0x00) {
+            ++i;
+        }
+    }
+    return out;
+}
+
+bool isAscii(const uchar* data, int size)
+{
+    for (int i = 0; i < size; ++i) {
+        if (data[i] >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isValidUtf8(const uchar* data, int size)
+{
+    int i = 0;
+    while (i < size) {
+        const uchar lead = data[i];
+        int length;
+        if (lead < 0x80) {
+            length = 1;
+        } else if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+        } else {
+            return false;
+        }
+        if (i + length > size) {
+            return false;
+        }
+        for (int k = 1; k < length; ++k) {
+            if ((data[i + k] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        i += length;
+    }
+    return true;
+}
+
+// GBK 双字节（首字节 0x81-0xFE，尾字节 0x40-0xFE 且不为 0x7F）或 GB18030 四字节序列
+bool isValidGbk(const uchar* data, int size)
+{
+    int i = 0;
+    while (i < size) {
+        const uchar lead = data[i];
+        if (lead < 0x80) {
+            ++i;
+            continue;
+        }
+        if (lead < 0x81 || lead > 0xFE || i + 1 >= size) {
+            return false;
+        }
+        const uchar trail = data[i + 1];
+        if (trail >= 0x40 && trail <= 0xFE && trail != 0x7F) {
+            i += 2;
+        } else if (trail >= 0x30 && trail <= 0x39 && i + 3 < size
+                   && data[i + 2] >= 0x81 && data[i + 2] <= 0xFE && data[i + 3] >= 0x30 && data[i + 3] <= 0x39) {
+            i += 4;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString decodeGbk(const uchar* data, int size)
+{
+    const char* bytes = reinterpret_cast<const char*>(data);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    static QTextCodec* codec = QTextCodec::codecForName("GB18030");
+    if (codec) {
+        return codec->toUnicode(bytes, size);
+    }
+#else
+    QStringDecoder decoder("GB18030");
+    if (decoder.isValid()) {
+        const QString text = decoder.decode(QByteArrayView(bytes, size));
+        return text;
+    }
+#endif
+    return QString::fromLatin1(bytes, size);
+}
+
+/**
+ * @brief 解码声明为 ISO-8859-1 的文本（ID3v2 编码 0 和 ID3v1）
+ *
+ * 国内编辑器写出的这类字段绝大多数是 GBK，也有直接写 UTF-8 的；
+ * 纯 ASCII 走快速路径，有效 UTF-8 优先（GBK 文本很少恰好也是有效 UTF-8）。
+ */
+QString decodeLegacy(const uchar* data, int size)
+{
+    const char* bytes = reinterpret_cast<const char*>(data);
+    if (isAscii(data, size)) {
+        return QString::fromLatin1(bytes, size);
+    }
+    if (isValidUtf8(data, size)) {
+        return QString::fromUtf8(bytes, size);
+    }
+    if (isValidGbk(data, size)) {
+        return decodeGbk(data, size);
+    }
+    return QString::fromLatin1(bytes, size);
+}
+
+QString decodeUtf16(const uchar* data, int size, bool bigEndian)
+{
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xFE) {
+        bigEndian = false;
+        data += 2;
+        size -= 2;
+    } else if (size >= 2 && data[0] == 0xFE && data[1] == 0xFF) {
+        bigEndian = true;
+        data += 2;
+        size -= 2;
+    }
+    // 映射内存不保证 2 字节对齐，逐字节拼出码元
+    const int count = size / 2;
+    QString text(count, Qt::Uninitialized);
+    QChar* out = text.data();
+    for (int i = 0; i < count; ++i) {
+        const uchar* unit = data + 2 * i;
+        out[i] = QChar(bigEndian ? ushort((unit[0] << 8) | unit[1]) : ushort(unit[0] | (unit[1] << 8)));
+    }
+    return text;
+}
+
+// 多值字段以 \0 分隔，只取第一个值
+QString firstValue(QString text)
+{
+    const int nul = text.indexOf(QChar(0));
+    if (nul >= 0) {
+        text.truncate(nul);
+    }
+    return text.trimmed();
+}
+
+QString decodeTextFrame(const uchar* data, qint64 size)
+{
+    if (size < 1) {
+        return QString();
+    }
+    const uchar encoding = data[0];
+    const int length = static_cast<int>(size - 1);
+    ++data;
+    switch (encoding) {
+    case 0: {
+        const uchar* end = static_cast<const uchar*>(std::memchr(data, 0, static_cast<size_t>(length)));
+        return decodeLegacy(data, end ? static_cast<int>(end - data) : length).trimmed();
+    }
+    case 1:
+        return firstValue(decodeUtf16(data, length, false));
+    case 2:
+        return firstValue(decodeUtf16(data, length, true));
+    case 3:
+        return firstValue(QString::fromUtf8(reinterpret_cast<const char*>(data), length));
+    default:
+        return QString();
+    }
+}
+
+QString* fieldForFrame(const uchar* id, int major, TagReader::Tags* tags)
+{
+    if (major == 2) {
+        if (std::memcmp(id, "TT2", 3) == 0) return &tags->title;
+        if (std::memcmp(id, "TP1", 3) == 0) return &tags->artist;
+        if (std::memcmp(id, "TAL", 3) == 0) return &tags->album;
+        return nullptr;
+    }
+    if (std::memcmp(id, "TIT2", 4) == 0) return &tags->title;
+    if (std::memcmp(id, "TPE1", 4) == 0) return &tags->artist;
+    if (std::memcmp(id, "TALB", 4) == 0) return &tags->album;
+    return nullptr;
+}
+
+/**
+ * @brief 解析文件开头的 ID3v2 标签
+ * @param tag 指向 "ID3" 头；size 为映射的字节数（头 + 标签体）
+ *
+ * 只解码标题 / 歌手 / 专辑三个文本帧，其余帧按长度跳过，不访问其内容。
+ */
+void parseId3v2(const uchar* tag, qint64 size, TagReader::Tags* tags)
+{
+    if (size < kId3v2HeaderSize || std::memcmp(tag, "ID3", 3) != 0) {
+        return;
+    }
+    const int major = tag[3];
+    if (major < 2 || major > 4) {
+        return;
+    }
+    const uchar flags = tag[5];
+    const uchar* body = tag + kId3v2HeaderSize;
+    qint64 length = std::min<qint64>(synchsafe32(tag + 6), size - kId3v2HeaderSize);
+
+    // v2.2 / v2.3 的反同步作用于整个标签体；v2.4 改为逐帧处理
+    QByteArray unsynchronised;
+    if ((flags & 0x80) && major < 4) {
+        unsynchronised = deunsynchronise(body, length);
+        body = reinterpret_cast<const uchar*>(unsynchronised.constData());
+        length = unsynchronised.size();
+    }
+    const bool tagUnsync = (flags & 0x80) && major == 4;
+
+    if ((flags & 0x40) && major >= 3) {
+        if (length < 4) {
+            return;
+        }
+        // v2.3 扩展头长度不含自身 4 字节；v2.4 为同步安全整数且包含自身
+        const qint64 extended = major == 3 ? qint64(bigEndian32(body)) + 4 : qint64(synchsafe32(body));
+        if (extended > length) {
+            return;
+        }
+        body += extended;
+        length -= extended;
+    }
+
+    const int headerSize = major == 2 ? 6 : 10;
+    qint64 pos = 0;
+    while (pos + headerSize <= length) {
+        const uchar* frame = body + pos;
+        if (frame[0] == 0) {
+            break;   // 填充区
+        }
+
+        qint64 frameSize;
+        quint16 frameFlags = 0;
+        if (major == 2) {
+            frameSize = (qint64(frame[3]) << 16) | (qint64(frame[4]) << 8) | frame[5];
+        } else {
+            // 早期的 iTunes 在 v2.4 中写的是普通大端长度：出现最高位时按大端读
+            const bool plain = major == 3 || ((frame[4] | frame[5] | frame[6] | frame[7]) & 0x80);
+            frameSize = plain ? bigEndian32(frame + 4) : synchsafe32(frame + 4);
+            frameFlags = quint16((frame[8] << 8) | frame[9]);
+        }
+        pos += headerSize;
+        if (frameSize > length - pos) {
+            break;
+        }
+        const uchar* data = body + pos;
+        pos += frameSize;
+
+        QString* field = fieldForFrame(frame, major, tags);
+        if (!field || !field->isEmpty()) {
+            continue;
+        }
+
+        bool frameUnsync = false;
+        if (major == 3) {
+            if (frameFlags & 0x00C0) {
+                continue;   // 压缩 / 加密
+            }
+            if (frameFlags & 0x0020) {
+                ++data;     // 分组标识
+                --frameSize;
+            }
+        } else if (major == 4) {
+            if (frameFlags & 0x000C) {
+                continue;   // 压缩 / 加密
+            }
+            if (frameFlags & 0x0040) {
+                ++data;     // 分组标识
+                --frameSize;
+            }
+            if (frameFlags & 0x0001) {
+                data += 4;  // 数据长度指示
+                frameSize -= 4;
+            }
+            frameUnsync = tagUnsync || (frameFlags & 0x0002);
+        }
+        if (frameSize <= 0) {
+            continue;
+        }
+
+        if (frameUnsync) {
+            const QByteArray copy = deunsynchronise(data, frameSize);
+            *field = decodeTextFrame(reinterpret_cast<const uchar*>(copy.constData()), copy.size());
+        } else {
+            *field = decodeTextFrame(data, frameSize);
+        }
+    }
+}
+
+/**
+ * @brief 解析 APEv2 标签项（footer 之前的 itemCount 个项）
+ */
+void parseApe(const uchar* items, qint64 size, quint32 itemCount, TagReader::Tags* tags)
+{
+    qint64 pos = 0;
+    for (quint32 i = 0; i < itemCount && pos + 8 <= size; ++i) {
+        const quint32 valueSize = littleEndian32(items + pos);
+        const quint32 itemFlags = littleEndian32(items + pos + 4);
+        pos += 8;
+
+        const uchar* key = items + pos;
+        const uchar* keyEnd = static_cast<const uchar*>(std::memchr(key, 0, static_cast<size_t>(size - pos)));
+        if (!keyEnd) {
+            return;
+        }
+        pos = (keyEnd - items) + 1;
+        if (valueSize > size - pos) {
+            return;
+        }
+        const uchar* value = items + pos;
+        pos += valueSize;
+
+        if (((itemFlags >> 1) & 0x3) != 0) {
+            continue;   // 二进制项或外部链接
+        }
+        const QByteArray name = QByteArray::fromRawData(reinterpret_cast<const char*>(key), int(keyEnd - key)).toLower();
+        QString* field = name == "title" ? &tags->title
+                         : name == "artist" ? &tags->artist
+                         : name == "album" ? &tags->album : nullptr;
+        if (field && field->isEmpty()) {
+            *field = firstValue(QString::fromUtf8(reinterpret_cast<const char*>(value), int(valueSize)));
+        }
+    }
+}
+
+/**
+ * @brief 解析 ID3v1（定长 30 字节字段，空字节或空格填充）
+ */
+void parseId3v1(const uchar* tag, TagReader::Tags* tags)
+{
+    auto field = [](const uchar* data) {
+        const uchar* end = static_cast<const uchar*>(std::memchr(data, 0, 30));
+        return decodeLegacy(data, end ? int(end - data) : 30).trimmed();
+    };
+    if (tags->title.isEmpty()) tags->title = field(tag + 3);
+    if (tags->artist.isEmpty()) tags->artist = field(tag + 33);
+    if (tags->album.isEmpty()) tags->album = field(tag + 63);
+}
+
+} // namespace
+
+// ========== 工作任务 ==========
+
+/**
+ * @brief 一批歌曲的标签读取任务
+ */
+class TagJob : public QRunnable
+{
+public:
+    explicit TagJob(const QStringList& filePaths)
+        : m_filePaths(filePaths)
+    {
+    }
+
+    void run() override
+    {
+        TagReader& reader = TagReader::instance();
+        TagReader::Results results;
+        results.reserve(static_cast<size_t>(m_filePaths.size()));
+
+        QElapsedTimer timer;
+        timer.start();
+        for (const QString& filePath : m_filePaths) {
+            if (reader.m_cancel) {
+                return;
+            }
+            TagReader::Tags tags;
+            if (TagReader::read(filePath, &tags)) {
+                results.emplace_back(filePath, tags);
+            }
+        }
+        qDebug() << "[TagReader] 读取" << results.size() << "首歌曲的标签, 用时" << timer.elapsed() << "ms";
+
+        const QStringList filePaths = m_filePaths;
+        QMetaObject::invokeMethod(&reader, [results, filePaths]() {
+            TagReader::instance().finishJob(results, filePaths);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QStringList m_filePaths;
+};
+
+// ========== TagReader ==========
+
+TagReader& TagReader::instance()
+{
+    static TagReader inst;
+    return inst;
+}
+
+TagReader::TagReader(QObject* parent)
+    : QObject(parent)
+{
+    // 每首歌只读几 KB，瓶颈在磁盘寻道，两个线程足够
+    m_pool.setMaxThreadCount(2);
+}
+
+TagReader::~TagReader()
+{
+    shutdown();
+}
+
+void TagReader::shutdown()
+{
+    m_cancel = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QString TagReader::decodeText(const QByteArray& bytes)
+{
+    return decodeLegacy(reinterpret_cast<const uchar*>(bytes.constData()), bytes.size());
+}
+
+void TagReader::load(const QStringList& filePaths)
+{
+    const MediaLibrary& library = MediaLibrary::instance();
+    QStringList batch;
+    for (const QString& filePath : filePaths) {
+        if (m_cancel || m_pending.contains(filePath)) {
+            continue;
+        }
+        const MediaLibrary::Track* track = library.track(filePath);
+        if (!track || track->tagsLoaded) {
+            continue;
+        }
+        m_pending.insert(filePath);
+        batch.append(filePath);
+        if (batch.size() == kBatchSize) {
+            m_pool.start(new TagJob(batch));
+            batch.clear();
+        }
+    }
+    if (!batch.isEmpty()) {
+        m_pool.start(new TagJob(batch));
+    }
+}
+
+void TagReader::finishJob(const Results& results, const QStringList& filePaths)
+{
+    for (const QString& filePath : filePaths) {
+        m_pending.remove(filePath);
+    }
+    if (m_cancel) {
+        return;
+    }
+
+    MediaLibrary& library = MediaLibrary::instance();
+    std::vector<MediaLibrary::Track> tagged;
+    tagged.reserve(results.size());
+    for (const auto& result : results) {
+        const MediaLibrary::Track* track = library.track(result.first);
+        if (!track) {
+            continue;
+        }
+        MediaLibrary::Track changed = *track;
+        // 没有标签的文件保留导入播放列表时带来的名字（#EXTINF / PLS Title）
+        if (!result.second.title.isEmpty() || !result.second.artist.isEmpty() || !result.second.album.isEmpty()) {
+            changed.title = result.second.title;
+            changed.artist = result.second.artist;
+            changed.album = result.second.album;
+        }
+        changed.tagsLoaded = true;
+        tagged.push_back(std::move(changed));
+    }
+    library.update(tagged);
+}
+
+/**
+ * @brief 读取开头的 ID3v2 和末尾的 APEv2 / ID3v1
+ *
+ * 开头只 read 10 字节的标签头，之后按标签长度映射；末尾先映射 160 字节找 ID3v1 和 APE footer，
+ * 有 APE 标签时再映射它的项区。三个字段都已从 ID3v2 得到时不访问文件末尾。
+ */
+bool TagReader::read(const QString& filePath, Tags* tags)
+{
+    *tags = Tags();
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 fileSize = file.size();
+
+    uchar header[kId3v2HeaderSize];
+    if (fileSize >= kId3v2HeaderSize
+        && file.read(reinterpret_cast<char*>(header), kId3v2HeaderSize) == kId3v2HeaderSize
+        && std::memcmp(header, "ID3", 3) == 0) {
+        const qint64 tagSize = std::min<qint64>(kId3v2HeaderSize + synchsafe32(header + 6), fileSize);
+        if (const uchar* head = file.map(0, tagSize)) {
+            parseId3v2(head, tagSize, tags);
+            file.unmap(const_cast<uchar*>(head));
+        }
+    }
+    if (tags->isComplete()) {
+        return true;
+    }
+
+    const qint64 tailSize = std::min<qint64>(fileSize, kId3v1Size + kApeFooterSize);
+    if (tailSize < kApeFooterSize) {
+        return true;
+    }
+    const qint64 tailOffset = fileSize - tailSize;
+    uchar* tail = file.map(tailOffset, tailSize);
+    if (!tail) {
+        return true;
+    }
+
+    const uchar* id3v1 = nullptr;
+    qint64 apeEnd = tailSize;   // APE footer 结束位置（相对 tail）
+    if (tailSize >= kId3v1Size && std::memcmp(tail + tailSize - kId3v1Size, "TAG", 3) == 0) {
+        id3v1 = tail + tailSize - kId3v1Size;
+        apeEnd -= kId3v1Size;
+    }
+
+    if (apeEnd >= kApeFooterSize && std::memcmp(tail + apeEnd - kApeFooterSize, "APETAGEX", 8) == 0) {
+        const uchar* footer = tail + apeEnd - kApeFooterSize;
+        const qint64 itemsSize = qint64(littleEndian32(footer + 12)) - kApeFooterSize;   // 长度含 footer
+        const quint32 itemCount = littleEndian32(footer + 16);
+        const qint64 footerOffset = tailOffset + apeEnd - kApeFooterSize;
+        if (itemsSize > 0 && itemsSize <= footerOffset && itemsSize <= kMaxApeSize) {
+            if (const uchar* items = file.map(footerOffset - itemsSize, itemsSize)) {
+                parseApe(items, itemsSize, itemCount, tags);
+                file.unmap(const_cast<uchar*>(items));
+            }
+        }
+    }
+
+    if (id3v1) {
+        parseId3v1(id3v1, tags);
+    }
+    file.unmap(tail);
+    return true;
+}
@@ -0,0 +1,96 @@
+/*
+ * TagReader - ID3v1 / ID3v2 / APEv2 标签读取与后台加载
+ *
+ * 只读取标签所在的区域：文件开头的 ID3v2 标签和末尾的 APEv2 / ID3v1 标签，
+ * 两段都用内存映射访问，解析时直接在映射上取字段，跳过的帧（封面图片等）不会被读入内存；
+ * 只有需要反同步（unsynchronisation）的帧才复制一份。
+ *
+ * 支持：
+ *   - ID3v2.2 / 2.3 / 2.4：标签级与帧级反同步、扩展头、2.4 数据长度指示；压缩和加密的帧跳过
+ *   - 文本编码：ISO-8859-1、UTF-16（带 BOM）、UTF-16BE、UTF-8
+ *   - 声明为 ISO-8859-1 的帧和 ID3v1 在中文 MP3 中几乎都是 GBK：能按 UTF-8 解码时按 UTF-8，
+ *     否则符合 GBK 双字节规则时按 GB18030 解码，都不是才按 Latin-1
+ *   - APEv2（位于文件末尾或 ID3v1 之前）的 UTF-8 文本项
+ * 同一字段优先取 ID3v2，其次 APEv2，最后 ID3v1。
+ *
+ * 结果写入 MediaLibrary 的歌曲记录，之后显示列表不再访问文件；
+ * 只为尚未读过标签的歌曲排队，文件被改写后（fileChanged）重新读取。
+ *
+ * 使用方式:
+ *   TagReader::instance().load(playlist);        // 后台读取，完成后 MediaLibrary 发出 trackUpdated
+ *   TagReader::Tags tags;
+ *   TagReader::read(path, &tags);                // 任意线程同步读取
+ */
+#ifndef TAGREADER_H
+#define TAGREADER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QSet>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+class TagReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Tags {
+        QString title;
+        QString artist;
+        QString album;
+
+        bool isComplete() const { return !title.isEmpty() && !artist.isEmpty() && !album.isEmpty(); }
+    };
+
+    static TagReader& instance();
+
+    /**
+     * @brief 读取一个文件的标签（可在任意线程调用）
+     * @return 文件无法打开时返回 false；没有标签时返回 true 且 tags 为空
+     */
+    static bool read(const QString& filePath, Tags* tags);
+
+    /**
+     * @brief 解码未声明编码的 8 位文本：依次尝试 ASCII、UTF-8、GBK（GB18030），都不是时按 Latin-1
+     *
+     * 与 ISO-8859-1 标签字段的识别规则相同，也用于 .m3u / .pls / .cue 等没有编码声明的文本文件。
+     */
+    static QString decodeText(const QByteArray& bytes);
+
+    /**
+     * @brief 为媒体库中尚未读过标签的歌曲排队读取（已读过或不在库中的跳过）
+     */
+    void load(const QStringList& filePaths);
+
+    /**
+     * @brief 取消排队中的任务并等待正在运行的任务退出（程序退出前调用）
+     */
+    void shutdown();
+
+private:
+    friend class TagJob;
+
+    typedef std::vector<std::pair<QString, Tags>> Results;
+
+    TagReader(QObject* parent = nullptr);
+    ~TagReader();
+    TagReader(const TagReader&) = delete;
+    TagReader& operator=(const TagReader&) = delete;
+
+    // 在 GUI 线程中接收一批结果
+    void finishJob(const Results& results, const QStringList& filePaths);
+
+    static constexpr int kBatchSize = 64;       // 每个任务读取的文件数，结果一次写入媒体库
+
+    QThreadPool m_pool;
+    std::atomic<bool> m_cancel{false};
+
+    // 以下仅 GUI 线程访问
+    QSet<QString> m_pending;                    // 已排队或正在读取
+};
+
+#endif // TAGREADER_H
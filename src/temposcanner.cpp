@@ -0,0 +1,190 @@
+/*
+ * TempoScanner 实现
+ */
+#include "temposcanner.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "minimp3.h"
+#include "minimp3_ex.h"
+#include "medialibrary.h"
+#include "onsetdetector.h"
+#include "stft.h"
+
+// ========== 工作任务 ==========
+
+/**
+ * @brief 一首歌的节拍扫描任务
+ */
+class TempoJob : public QRunnable
+{
+public:
+    explicit TempoJob(const QString& filePath)
+        : m_filePath(filePath)
+    {
+    }
+
+    void run() override
+    {
+        TempoScanner& scanner = TempoScanner::instance();
+        TempoScanner::Result result;
+
+        QElapsedTimer timer;
+        timer.start();
+        if (TempoScanner::analyze(m_filePath, scanner.m_cancel, &result)) {
+            const double seconds = std::max<qint64>(1, timer.elapsed()) / 1000.0;
+            qDebug() << "[TempoScanner]" << QFileInfo(m_filePath).fileName()
+                     << result.bpm << "BPM, 置信度" << result.confidence
+                     << "," << qRound(result.audioSeconds / seconds) << "倍实时速度";
+        } else if (scanner.m_cancel) {
+            return;
+        }
+
+        const QString filePath = m_filePath;
+        QMetaObject::invokeMethod(&scanner, [filePath, result]() {
+            TempoScanner::instance().finishJob(filePath, result);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QString m_filePath;
+};
+
+// ========== TempoScanner ==========
+
+TempoScanner& TempoScanner::instance()
+{
+    static TempoScanner inst;
+    return inst;
+}
+
+TempoScanner::TempoScanner(QObject* parent)
+    : QObject(parent)
+{
+    // 留一个核心给解码和界面
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+TempoScanner::~TempoScanner()
+{
+    shutdown();
+}
+
+void TempoScanner::shutdown()
+{
+    m_cancel = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+float TempoScanner::tempo(const QString& filePath) const
+{
+    const MediaLibrary::Track* track = MediaLibrary::instance().track(filePath);
+    return track && track->bpm > 0.0f ? track->bpm : 0.0f;
+}
+
+void TempoScanner::scan(const QStringList& filePaths)
+{
+    for (const QString& filePath : filePaths) {
+        if (m_cancel || m_pending.contains(filePath)) {
+            continue;
+        }
+        const MediaLibrary::Track* track = MediaLibrary::instance().track(filePath);
+        if (!track || track->hasTempo()) {
+            continue;
+        }
+        m_pending.insert(filePath);
+        m_pool.start(new TempoJob(filePath), 0);
+    }
+}
+
+void TempoScanner::finishJob(const QString& filePath, const Result& result)
+{
+    m_pending.remove(filePath);
+    if (m_cancel) {
+        return;
+    }
+
+    MediaLibrary::instance().setTempo(filePath, result.bpm, static_cast<qint32>(result.audioSeconds * 1000.0));
+    if (result.bpm > 0.0f) {
+        emit tempoReady(filePath, result.bpm);
+    }
+}
+
+/**
+ * @brief 解码整首歌并估计节拍（工作线程）
+ *
+ * 文件以内存映射方式读取，PCM 逐帧送入 STFT 和起始点检测，
+ * 只保留每个分析帧一个浮点数的起始强度包络（4 分钟约 160 KB）。
+ */
+bool TempoScanner::analyze(const QString& filePath, const std::atomic<bool>& cancel, Result* result)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        qWarning() << "[TempoScanner] 无法打开:" << filePath;
+        return false;
+    }
+    const uchar* data = file.map(0, file.size());
+    if (!data) {
+        qWarning() << "[TempoScanner] 内存映射失败:" << filePath;
+        return false;
+    }
+
+    // 顺序读取整首歌，不需要 seek 索引
+    auto decoder = std::make_unique<mp3dec_ex_t>();
+    if (mp3dec_ex_open_buf(decoder.get(), data, static_cast<size_t>(file.size()),
+                           MP3D_SEEK_TO_SAMPLE | MP3D_DO_NOT_SCAN) != 0) {
+        qWarning() << "[TempoScanner] 无法解码:" << filePath;
+        return false;
+    }
+
+    StftAnalyzer stft(kFftSize, kHopSize, StftAnalyzer::Mono);
+    OnsetDetector detector;
+    std::vector<float> envelope;
+    int sampleRate = 0;
+    qint64 frameCount = 0;
+
+    mp3d_sample_t* pcm = nullptr;
+    mp3dec_frame_info_t info;
+    size_t samples;
+    while ((samples = mp3dec_ex_read_frame(decoder.get(), &pcm, &info, MINIMP3_MAX_SAMPLES_PER_FRAME)) > 0) {
+        if (cancel) {
+            mp3dec_ex_close(decoder.get());
+            return false;
+        }
+        const int channels = std::max(1, info.channels);
+        if (sampleRate == 0) {
+            sampleRate = info.hz;
+            detector.configure(sampleRate, stft.fftSize(), stft.hopSize());
+            // 预留约 5 分钟的包络，常见歌曲无需扩容
+            envelope.reserve(static_cast<size_t>(detector.frameRate() * 300.0f));
+        }
+
+        const int frames = static_cast<int>(samples) / channels;
+        stft.push(pcm, frames, channels, [&](const SpectrumFrame& frame) {
+            detector.process(frame.planes[0]);
+            envelope.push_back(detector.envelope());
+        });
+        frameCount += frames;
+    }
+    mp3dec_ex_close(decoder.get());
+
+    if (sampleRate <= 0 || envelope.empty()) {
+        return false;
+    }
+
+    const OnsetDetector::Tempo tempo =
+        OnsetDetector::estimateTempo(envelope.data(), static_cast<int>(envelope.size()), detector.frameRate());
+    result->bpm = tempo.bpm;
+    result->confidence = tempo.confidence;
+    result->audioSeconds = static_cast<double>(frameCount) / sampleRate;
+    return tempo.bpm > 0.0f;
+}
@@ -0,0 +1,83 @@
+/*
+ * TempoScanner - 媒体库节拍速度（BPM）批量扫描
+ *
+ * 对播放列表中的每首歌完整解码一遍，用与实时节拍脉冲相同的 OnsetDetector
+ * 计算全曲的起始强度包络，再对整段包络做一次自相关得到 BPM。
+ * 扫描在专用 QThreadPool 上按歌曲并行进行，不经过声卡、不按播放速度节流，
+ * 单个线程即可远快于实时（日志中输出每首歌的倍速）。
+ *
+ * 结果（BPM 和解码得到的时长）写入 MediaLibrary 的歌曲记录，只扫描库中尚未分析过的歌曲；
+ * 无法解码或估计的歌曲记为 0，不会反复重试。
+ * 结果只在 GUI 线程中写入，因此无需加锁。
+ *
+ * 使用方式:
+ *   connect(&TempoScanner::instance(), &TempoScanner::tempoReady, ...);
+ *   TempoScanner::instance().scan(playlist);
+ *   float bpm = TempoScanner::instance().tempo(path);
+ */
+#ifndef TEMPOSCANNER_H
+#define TEMPOSCANNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QSet>
+#include <atomic>
+
+class TempoScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    static TempoScanner& instance();
+
+    /**
+     * @brief 已扫描歌曲的节拍速度；尚未扫描或无法估计时返回 0（并不会触发扫描）
+     */
+    float tempo(const QString& filePath) const;
+
+    /**
+     * @brief 为媒体库中尚未分析过的歌曲排队扫描（低优先级，已有结果或不在库中的跳过）
+     */
+    void scan(const QStringList& filePaths);
+
+    /**
+     * @brief 取消排队中的任务并等待正在运行的任务退出（程序退出前调用）
+     */
+    void shutdown();
+
+signals:
+    void tempoReady(const QString& filePath, float bpm);
+
+private:
+    friend class TempoJob;
+
+    struct Result {
+        float bpm = 0.0f;
+        float confidence = 0.0f;
+        double audioSeconds = 0.0;
+    };
+
+    TempoScanner(QObject* parent = nullptr);
+    ~TempoScanner();
+    TempoScanner(const TempoScanner&) = delete;
+    TempoScanner& operator=(const TempoScanner&) = delete;
+
+    // 在 GUI 线程中接收任务结果
+    void finishJob(const QString& filePath, const Result& result);
+
+    // 在工作线程中运行
+    static bool analyze(const QString& filePath, const std::atomic<bool>& cancel, Result* result);
+
+    static constexpr int kFftSize = 1024;
+    static constexpr int kHopSize = 256;        // 44.1kHz 下约 172 帧/秒，120 BPM 时每拍约 86 帧
+
+    QThreadPool m_pool;
+    std::atomic<bool> m_cancel{false};
+
+    // 以下仅 GUI 线程访问
+    QSet<QString> m_pending;                    // 已排队或正在扫描
+};
+
+#endif // TEMPOSCANNER_H
@@ -0,0 +1,65 @@
+/*
+ * 三缓冲快照交换 (header-only)
+ *
+ * 单生产者 / 单消费者之间传递“最新一份”数据，双方都不加锁、不等待：
+ *   - 生产者始终写自己独占的 back 缓冲，写完 publish() 与 middle 交换
+ *   - 消费者 acquire() 时若 middle 有新数据，就与自己独占的 front 交换
+ * 每次交换只是一条原子 exchange，任何一方都不会被另一方阻塞（wait-free）。
+ * 消费者来不及读取的中间帧会被新帧覆盖，适合“只关心最新值”的显示场景。
+ *
+ * 使用方式:
+ *   TripleBuffer<Snapshot> buffer;
+ *   // 生产者线程
+ *   buffer.writeBuffer() = ...;  buffer.publish();
+ *   // 消费者线程
+ *   if (buffer.acquire()) use(buffer.readBuffer());
+ */
+#ifndef TTPLAYER_TRIPLEBUFFER_H
+#define TTPLAYER_TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // 生产者独占的写缓冲（publish() 之后指向另一块缓冲）
+    T& writeBuffer() { return m_buffers[m_back]; }
+
+    // 发布写缓冲中的数据
+    void publish()
+    {
+        const uint8_t prev = m_middle.exchange(static_cast<uint8_t>(m_back | kFresh), std::memory_order_acq_rel);
+        m_back = prev & kIndexMask;
+    }
+
+    // 取得最新发布的数据；返回 false 表示自上次 acquire 以来没有新数据
+    bool acquire()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        const uint8_t prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = prev & kIndexMask;
+        return true;
+    }
+
+    // 消费者独占的读缓冲（下次 acquire() 前保持不变）
+    const T& readBuffer() const { return m_buffers[m_front]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;   // middle 中是否有未被读取的新数据
+
+    T m_buffers[3] {};
+    uint8_t m_back = 0;                      // 仅生产者访问
+    uint8_t m_front = 1;                     // 仅消费者访问
+    std::atomic<uint8_t> m_middle{2};        // 低两位为缓冲索引，kFresh 为新数据标志
+};
+
+#endif // TTPLAYER_TRIPLEBUFFER_H
@@ -0,0 +1,408 @@
+/*
+ * WaveformCache 实现
+ */
+#include "waveformcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+#include "minimp3.h"
+#include "minimp3_ex.h"
+
+namespace {
+
+constexpr quint32 kPeakMagic = 0x5454504B;   // "TTPK"
+constexpr quint16 kPeakVersion = 1;
+
+// 两个相邻桶合并为上一级的一个桶
+WaveformBucket mergeBuckets(const WaveformBucket& a, const WaveformBucket& b)
+{
+    WaveformBucket merged;
+    merged.min = std::min(a.min, b.min);
+    merged.max = std::max(a.max, b.max);
+    merged.rms = static_cast<uint8_t>(std::lround(std::sqrt((a.rms * a.rms + b.rms * b.rms) * 0.5f)));
+    return merged;
+}
+
+} // namespace
+
+// ========== WaveformOverview ==========
+
+const std::vector<WaveformBucket>& WaveformOverview::levelFor(int pixels) const
+{
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+        if (static_cast<int>(it->size()) >= pixels) {
+            return *it;
+        }
+    }
+    return levels.front();
+}
+
+int WaveformOverview::byteSize() const
+{
+    size_t bytes = sizeof(WaveformOverview);
+    for (const auto& level : levels) {
+        bytes += level.size() * sizeof(WaveformBucket);
+    }
+    return static_cast<int>(bytes);
+}
+
+// ========== 工作任务 ==========
+
+/**
+ * @brief 一首歌的概览任务：读取峰值文件，或解码生成后写入峰值文件
+ */
+class WaveformJob : public QRunnable
+{
+public:
+    WaveformJob(const QString& filePath, const QString& peakFile, bool load)
+        : m_filePath(filePath), m_peakFile(peakFile), m_load(load)
+    {
+        // 排队期间可能被 tryTake 取回提升优先级，所以由 WaveformCache 负责释放
+        setAutoDelete(false);
+    }
+
+    bool load() const { return m_load; }
+
+    void run() override
+    {
+        WaveformCache& cache = WaveformCache::instance();
+        std::shared_ptr<const WaveformOverview> overview;
+
+        if (QFile::exists(m_peakFile)) {
+            // 预取时峰值文件已存在即可，不必读入内存
+            if (m_load) {
+                overview = WaveformCache::readPeakFile(m_peakFile);
+            }
+        }
+        if (!overview && (m_load || !QFile::exists(m_peakFile))) {
+            std::shared_ptr<WaveformOverview> computed = WaveformCache::analyze(m_filePath, cache.m_cancel);
+            if (computed && WaveformCache::writePeakFile(m_peakFile, *computed)) {
+                qDebug() << "[WaveformCache] 已生成峰值文件:" << m_filePath;
+            }
+            overview = computed;
+        }
+
+        const QString filePath = m_filePath;
+        const bool load = m_load;
+        QMetaObject::invokeMethod(&cache, [filePath, load, overview]() {
+            WaveformCache::instance().finishJob(filePath, load, overview);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QString m_filePath;
+    QString m_peakFile;
+    bool m_load;
+};
+
+// ========== WaveformCache ==========
+
+WaveformCache& WaveformCache::instance()
+{
+    static WaveformCache inst;
+    return inst;
+}
+
+WaveformCache::WaveformCache(QObject* parent)
+    : QObject(parent)
+{
+    // 留一个核心给解码和界面
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+    m_memory.setMaxCost(kMemoryBudgetKb);
+
+    QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (base.isEmpty()) {
+        base = QDir::tempPath();
+    }
+    m_cacheDir = QDir(base).filePath("waveforms");
+    QDir().mkpath(m_cacheDir);
+}
+
+WaveformCache::~WaveformCache()
+{
+    shutdown();
+}
+
+void WaveformCache::shutdown()
+{
+    m_cancel = true;
+    m_pool.clear();
+    m_pool.waitForDone();
+    qDeleteAll(m_pending);
+    m_pending.clear();
+}
+
+std::shared_ptr<const WaveformOverview> WaveformCache::overview(const QString& filePath)
+{
+    std::shared_ptr<const WaveformOverview>* cached = m_memory.object(filePath);
+    return cached ? *cached : nullptr;
+}
+
+void WaveformCache::request(const QString& filePath)
+{
+    if (filePath.isEmpty() || m_memory.contains(filePath)) {
+        return;
+    }
+    m_wanted.insert(filePath);
+    schedule(filePath, true, 1);
+}
+
+void WaveformCache::prefetch(const QStringList& filePaths)
+{
+    for (const QString& filePath : filePaths) {
+        if (!filePath.isEmpty() && !m_memory.contains(filePath)) {
+            schedule(filePath, false, 0);
+        }
+    }
+}
+
+void WaveformCache::schedule(const QString& filePath, bool load, int priority)
+{
+    if (m_cancel) {
+        return;
+    }
+
+    // 同一首歌同时只有一个任务。预取任务还在排队时被当前歌曲请求，
+    // 就把它从队列取回，改为高优先级并载入内存；已开始的任务完成时按 m_wanted 决定是否再载入
+    auto it = m_pending.find(filePath);
+    if (it != m_pending.end()) {
+        if (!load || it.value()->load() || !m_pool.tryTake(it.value())) {
+            return;
+        }
+        delete it.value();
+        m_pending.erase(it);
+    }
+
+    WaveformJob* job = new WaveformJob(filePath, peakFilePath(filePath), load);
+    m_pending.insert(filePath, job);
+    m_pool.start(job, priority);
+}
+
+void WaveformCache::finishJob(const QString& filePath, bool load, std::shared_ptr<const WaveformOverview> overview)
+{
+    delete m_pending.take(filePath);
+    if (m_cancel) {
+        return;
+    }
+
+    if (!overview) {
+        if (load) {
+            m_wanted.remove(filePath);          // 无法解码，放弃
+        } else if (m_wanted.contains(filePath)) {
+            // 预取任务只确认了峰值文件存在；期间当前歌曲切换到了它，需要再读一次
+            schedule(filePath, true, 1);
+        }
+        return;
+    }
+
+    // 仅把当前需要的歌曲留在内存，预取结果只落盘
+    if (!m_wanted.remove(filePath)) {
+        return;
+    }
+    const int costKb = std::max(1, overview->byteSize() / 1024);
+    m_memory.insert(filePath, new std::shared_ptr<const WaveformOverview>(overview), costKb);
+    emit overviewReady(filePath);
+}
+
+/**
+ * @brief 峰值文件路径：源文件的绝对路径、大小和修改时间共同决定键，任一变化都会重新生成
+ */
+QString WaveformCache::peakFilePath(const QString& filePath) const
+{
+    const QFileInfo info(filePath);
+    const QByteArray key = info.absoluteFilePath().toUtf8()
+                           + '\n' + QByteArray::number(info.size())
+                           + '\n' + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+    const QByteArray hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex();
+    return QDir(m_cacheDir).filePath(QString::fromLatin1(hash) + ".ttpk");
+}
+
+/**
+ * @brief 解码整首歌并逐桶统计（工作线程）
+ *
+ * 文件以内存映射方式读取，PCM 逐帧下混后直接累加进当前桶，
+ * 整个过程中不保留完整的 PCM，内存占用与歌曲长度无关。
+ */
+std::shared_ptr<WaveformOverview> WaveformCache::analyze(const QString& filePath, const std::atomic<bool>& cancel)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        qWarning() << "[WaveformCache] 无法打开:" << filePath;
+        return nullptr;
+    }
+    const uchar* data = file.map(0, file.size());
+    if (!data) {
+        qWarning() << "[WaveformCache] 内存映射失败:" << filePath;
+        return nullptr;
+    }
+
+    // 顺序读取整首歌，不需要 seek 索引
+    auto decoder = std::make_unique<mp3dec_ex_t>();
+    if (mp3dec_ex_open_buf(decoder.get(), data, static_cast<size_t>(file.size()),
+                           MP3D_SEEK_TO_SAMPLE | MP3D_DO_NOT_SCAN) != 0) {
+        qWarning() << "[WaveformCache] 无法解码:" << filePath;
+        return nullptr;
+    }
+
+    auto overview = std::make_shared<WaveformOverview>();
+    overview->bucketFrames = kBucketFrames;
+    std::vector<WaveformBucket> base;
+
+    float bucketMin = 0.0f;
+    float bucketMax = 0.0f;
+    double bucketSquares = 0.0;
+    int bucketFill = 0;
+    auto flushBucket = [&]() {
+        WaveformBucket bucket;
+        bucket.min = static_cast<int8_t>(std::lround(std::clamp(bucketMin, -1.0f, 1.0f) * 127.0f));
+        bucket.max = static_cast<int8_t>(std::lround(std::clamp(bucketMax, -1.0f, 1.0f) * 127.0f));
+        const double rms = std::sqrt(bucketSquares / bucketFill);
+        bucket.rms = static_cast<uint8_t>(std::lround(std::min(rms, 1.0) * 255.0));
+        base.push_back(bucket);
+        bucketMin = bucketMax = 0.0f;
+        bucketSquares = 0.0;
+        bucketFill = 0;
+    };
+
+    mp3d_sample_t* pcm = nullptr;
+    mp3dec_frame_info_t info;
+    size_t samples;
+    while ((samples = mp3dec_ex_read_frame(decoder.get(), &pcm, &info, MINIMP3_MAX_SAMPLES_PER_FRAME)) > 0) {
+        if (cancel) {
+            mp3dec_ex_close(decoder.get());
+            return nullptr;
+        }
+        const int channels = std::max(1, info.channels);
+        if (overview->sampleRate == 0) {
+            overview->sampleRate = info.hz;
+        }
+
+        const int frames = static_cast<int>(samples) / channels;
+        const float scale = 1.0f / (32768.0f * channels);
+        for (int f = 0; f < frames; ++f) {
+            int sum = 0;
+            for (int ch = 0; ch < channels; ++ch) {
+                sum += pcm[f * channels + ch];
+            }
+            const float mono = sum * scale;
+            bucketMin = std::min(bucketMin, mono);
+            bucketMax = std::max(bucketMax, mono);
+            bucketSquares += static_cast<double>(mono) * mono;
+            if (++bucketFill == kBucketFrames) {
+                flushBucket();
+            }
+        }
+        overview->frameCount += frames;
+    }
+    if (bucketFill > 0) {
+        flushBucket();
+    }
+    mp3dec_ex_close(decoder.get());
+
+    if (base.empty()) {
+        return nullptr;
+    }
+
+    // 逐级两两合并，直到再合并就少于 kMinLevelBuckets
+    overview->levels.push_back(std::move(base));
+    while (overview->levels.back().size() / 2 >= static_cast<size_t>(kMinLevelBuckets)) {
+        const std::vector<WaveformBucket>& finer = overview->levels.back();
+        std::vector<WaveformBucket> coarser(finer.size() / 2);
+        for (size_t i = 0; i < coarser.size(); ++i) {
+            coarser[i] = mergeBuckets(finer[2 * i], finer[2 * i + 1]);
+        }
+        overview->levels.push_back(std::move(coarser));
+    }
+    return overview;
+}
+
+/**
+ * @brief 峰值文件格式（大端）：
+ *   magic "TTPK" | version u16 | sampleRate u32 | bucketFrames u32 | frameCount i64 | levelCount u16
+ *   每级: bucketCount u32 | bucketCount × (min i8, max i8, rms u8)
+ */
+std::shared_ptr<WaveformOverview> WaveformCache::readPeakFile(const QString& peakFile)
+{
+    QFile file(peakFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 sampleRate = 0;
+    quint32 bucketFrames = 0;
+    qint64 frameCount = 0;
+    quint16 levelCount = 0;
+    in >> magic >> version >> sampleRate >> bucketFrames >> frameCount >> levelCount;
+    if (in.status() != QDataStream::Ok || magic != kPeakMagic || version != kPeakVersion || levelCount == 0) {
+        qWarning() << "[WaveformCache] 峰值文件无效:" << peakFile;
+        return nullptr;
+    }
+
+    auto overview = std::make_shared<WaveformOverview>();
+    overview->sampleRate = static_cast<int>(sampleRate);
+    overview->bucketFrames = static_cast<int>(bucketFrames);
+    overview->frameCount = frameCount;
+    overview->levels.resize(levelCount);
+    for (auto& level : overview->levels) {
+        quint32 count = 0;
+        in >> count;
+        // 每级桶数不可能超过剩余字节数，防止损坏的文件触发巨大分配
+        if (in.status() != QDataStream::Ok || count > static_cast<quint64>(file.bytesAvailable()) / 3) {
+            qWarning() << "[WaveformCache] 峰值文件损坏:" << peakFile;
+            return nullptr;
+        }
+        level.resize(count);
+        for (WaveformBucket& bucket : level) {
+            qint8 min = 0;
+            qint8 max = 0;
+            quint8 rms = 0;
+            in >> min >> max >> rms;
+            bucket.min = min;
+            bucket.max = max;
+            bucket.rms = rms;
+        }
+    }
+    if (in.status() != QDataStream::Ok) {
+        return nullptr;
+    }
+    return overview;
+}
+
+bool WaveformCache::writePeakFile(const QString& peakFile, const WaveformOverview& overview)
+{
+    // QSaveFile：写完才替换，并行任务或中途退出都不会留下半个文件
+    QSaveFile file(peakFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "[WaveformCache] 无法写入峰值文件:" << peakFile;
+        return false;
+    }
+
+    QDataStream out(&file);
+    out << kPeakMagic << kPeakVersion
+        << static_cast<quint32>(overview.sampleRate)
+        << static_cast<quint32>(overview.bucketFrames)
+        << static_cast<qint64>(overview.frameCount)
+        << static_cast<quint16>(overview.levels.size());
+    for (const auto& level : overview.levels) {
+        out << static_cast<quint32>(level.size());
+        for (const WaveformBucket& bucket : level) {
+            out << static_cast<qint8>(bucket.min) << static_cast<qint8>(bucket.max) << static_cast<quint8>(bucket.rms);
+        }
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
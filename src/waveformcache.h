@@ -0,0 +1,129 @@
+/*
+ * WaveformCache - 整首歌曲的波形概览（进度条背景）
+ *
+ * 每首歌只解码一次，按固定长度的桶记录下混后样本的最小值、最大值和均方根，
+ * 再逐级两两合并得到多级分辨率。结果写入缓存目录下的紧凑峰值文件
+ * （键由路径、大小和修改时间决定），之后再次打开同一首歌只需读取几十 KB。
+ *
+ * 计算在专用 QThreadPool 上按歌曲并行进行：
+ *   - request():  当前歌曲，高优先级，完成后载入内存并发出 overviewReady
+ *   - prefetch(): 播放列表中的其他歌曲，低优先级，提前生成峰值文件
+ * 结果只在 GUI 线程中写入内存缓存（QCache，按字节数淘汰），因此无需加锁。
+ *
+ * 使用方式:
+ *   connect(&WaveformCache::instance(), &WaveformCache::overviewReady, ...);
+ *   WaveformCache::instance().request(path);
+ *   slider->setWaveform(WaveformCache::instance().overview(path));
+ */
+#ifndef WAVEFORMCACHE_H
+#define WAVEFORMCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 一个桶内样本的最小值、最大值（-127~127）与均方根（0~255）
+ */
+struct WaveformBucket {
+    int8_t min = 0;
+    int8_t max = 0;
+    uint8_t rms = 0;
+};
+
+/**
+ * @brief 多级分辨率波形概览（第 0 级最精细，之后每级桶数减半）
+ */
+struct WaveformOverview {
+    int sampleRate = 0;
+    int bucketFrames = 0;       // 第 0 级每桶的采样帧数
+    qint64 frameCount = 0;      // 全曲采样帧数
+    std::vector<std::vector<WaveformBucket>> levels;
+
+    bool isEmpty() const { return levels.empty() || levels.front().empty(); }
+
+    // 桶数不少于 pixels 的最粗一级（不足时返回最精细的一级）
+    const std::vector<WaveformBucket>& levelFor(int pixels) const;
+
+    // 占用的字节数（内存缓存按此淘汰）
+    int byteSize() const;
+};
+
+class WaveformJob;
+
+class WaveformCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static WaveformCache& instance();
+
+    /**
+     * @brief 已载入内存的概览；尚未就绪时返回 nullptr（并不会触发计算）
+     */
+    std::shared_ptr<const WaveformOverview> overview(const QString& filePath);
+
+    /**
+     * @brief 请求当前歌曲的概览：有峰值文件则读取，否则解码生成，完成后发出 overviewReady
+     */
+    void request(const QString& filePath);
+
+    /**
+     * @brief 为播放列表中的歌曲预先生成峰值文件（低优先级，已有峰值文件的跳过）
+     */
+    void prefetch(const QStringList& filePaths);
+
+    /**
+     * @brief 取消排队中的任务并等待正在运行的任务退出（程序退出前调用）
+     */
+    void shutdown();
+
+    // 峰值文件所在目录
+    QString cacheDir() const { return m_cacheDir; }
+
+signals:
+    void overviewReady(const QString& filePath);
+
+private:
+    friend class WaveformJob;
+
+    WaveformCache(QObject* parent = nullptr);
+    ~WaveformCache();
+    WaveformCache(const WaveformCache&) = delete;
+    WaveformCache& operator=(const WaveformCache&) = delete;
+
+    void schedule(const QString& filePath, bool load, int priority);
+
+    // 在 GUI 线程中接收任务结果
+    void finishJob(const QString& filePath, bool load, std::shared_ptr<const WaveformOverview> overview);
+
+    QString peakFilePath(const QString& filePath) const;
+
+    // 以下静态函数在工作线程中运行
+    static std::shared_ptr<WaveformOverview> analyze(const QString& filePath, const std::atomic<bool>& cancel);
+    static std::shared_ptr<WaveformOverview> readPeakFile(const QString& peakFile);
+    static bool writePeakFile(const QString& peakFile, const WaveformOverview& overview);
+
+    static constexpr int kBucketFrames = 1024;      // 第 0 级每桶帧数（44.1kHz 下约 43 桶/秒）
+    static constexpr int kMinLevelBuckets = 128;    // 最粗一级至少保留的桶数
+    static constexpr int kMemoryBudgetKb = 16 * 1024;
+
+    QThreadPool m_pool;
+    std::atomic<bool> m_cancel{false};
+    QString m_cacheDir;
+
+    // 以下仅 GUI 线程访问
+    QCache<QString, std::shared_ptr<const WaveformOverview>> m_memory;   // 代价单位 KB
+    QHash<QString, WaveformJob*> m_pending;   // 已排队或正在计算（任务由这里持有，finishJob 时释放）
+    QSet<QString> m_wanted;         // 完成后需要载入内存的歌曲
+};
+
+#endif // WAVEFORMCACHE_H
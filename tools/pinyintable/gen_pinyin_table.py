@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+生成 src/pinyintable.h：CJK 统一汉字 U+4E00..U+9FA5 → 拼音首字母
+
+GB2312 一级汉字（0xB0A1..0xD7F9，3755 个常用字）按拼音排序，
+因此只需要每个声母的起始编码就能得到首字母；二级汉字按部首排序，无法推出，记为 '.'。
+
+用法:
+    python3 tools/pinyintable/gen_pinyin_table.py > src/pinyintable.h
+"""
+
+FIRST, LAST = 0x4E00, 0x9FA5
+
+# GB2312 一级汉字中每个首字母的起始编码（i / u / v 不作声母）
+BOUNDARIES = [
+    (0xB0A1, 'a'), (0xB0C5, 'b'), (0xB2C1, 'c'), (0xB4EE, 'd'), (0xB6EA, 'e'),
+    (0xB7A2, 'f'), (0xB8C1, 'g'), (0xB9FE, 'h'), (0xBBF7, 'j'), (0xBFA6, 'k'),
+    (0xC0AC, 'l'), (0xC2E8, 'm'), (0xC4C3, 'n'), (0xC5B6, 'o'), (0xC5BE, 'p'),
+    (0xC6DA, 'q'), (0xC8BB, 'r'), (0xC8F6, 's'), (0xCBFA, 't'), (0xCDDA, 'w'),
+    (0xCEF4, 'x'), (0xD1B9, 'y'), (0xD4D1, 'z'),
+]
+LEVEL1_END = 0xD7F9
+
+
+def initial(ch):
+    try:
+        encoded = ch.encode('gb2312')
+    except UnicodeEncodeError:
+        return '.'
+    if len(encoded) != 2:
+        return '.'
+    code = (encoded[0] << 8) | encoded[1]
+    if code < BOUNDARIES[0][0] or code > LEVEL1_END:
+        return '.'
+    letter = '.'
+    for start, value in BOUNDARIES:
+        if code >= start:
+            letter = value
+    return letter
+
+
+def main():
+    table = ''.join(initial(chr(cp)) for cp in range(FIRST, LAST + 1))
+    known = sum(1 for c in table if c != '.')
+    print('/*')
+    print(' * pinyintable.h - 汉字拼音首字母表（由 tools/pinyintable/gen_pinyin_table.py 生成，请勿手工修改）')
+    print(' *')
+    print(' * kPinyinInitials[c - kPinyinFirst] 为 U+%04X..U+%04X 中汉字的拼音首字母，' % (FIRST, LAST))
+    print(' * 不在 GB2312 一级汉字中的字为 \'.\'。共 %d 个字有首字母。' % known)
+    print(' */')
+    print('#ifndef PINYINTABLE_H')
+    print('#define PINYINTABLE_H')
+    print()
+    print('constexpr char16_t kPinyinFirst = 0x%04X;' % FIRST)
+    print('constexpr char16_t kPinyinLast = 0x%04X;' % LAST)
+    print()
+    print('static const char kPinyinInitials[] =')
+    width = 96
+    for i in range(0, len(table), width):
+        end = ';' if i + width >= len(table) else ''
+        print('    "%s"%s' % (table[i:i + width], end))
+    print()
+    print('#endif // PINYINTABLE_H')
+
+
+if __name__ == '__main__':
+    main()